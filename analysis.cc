@@ -0,0 +1,84 @@
+#include <cassert>
+#include "profiler.h"
+#include "analysis.h"
+
+namespace
+{
+
+compiler_skeleton::utils::Statistic analysis_hits("analysis", "cached analyses reused");
+compiler_skeleton::utils::Statistic analysis_builds("analysis", "analyses computed");
+
+} // namespace
+
+namespace compiler_skeleton::eeyore
+{
+
+AnalysisManager::FuncAnalyses &AnalysisManager::_entry_of(const EeyoreStatement *begin,
+	const EeyoreStatement *end)
+{
+	assert(begin != end && std::holds_alternative<FuncDefStmt>(*begin));
+	FuncAnalyses &entry = _funcs[std::get<FuncDefStmt>(*begin).func_name];
+	// A transform changed the statement count without dropping the CFG.
+	assert(entry.cfg == nullptr || entry.cfg->stmt_cnt() == end - begin);
+	return entry;
+}
+
+const CFG &AnalysisManager::cfg(const EeyoreStatement *begin, const EeyoreStatement *end)
+{
+	FuncAnalyses &entry = _entry_of(begin, end);
+	if(entry.cfg != nullptr)
+		++analysis_hits;
+	else
+	{
+		entry.cfg = std::make_unique<eeyore::CFG>(begin, end);
+		++analysis_builds;
+	}
+	return *entry.cfg;
+}
+
+const DomTree &AnalysisManager::dom_tree(const EeyoreStatement *begin, const EeyoreStatement *end)
+{
+	FuncAnalyses &entry = _entry_of(begin, end);
+	if(entry.dom_tree != nullptr)
+		++analysis_hits;
+	else
+	{
+		entry.dom_tree = std::make_unique<DomTree>(cfg(begin, end));
+		++analysis_builds;
+	}
+	return *entry.dom_tree;
+}
+
+const LoopForest &AnalysisManager::loops(const EeyoreStatement *begin, const EeyoreStatement *end)
+{
+	FuncAnalyses &entry = _entry_of(begin, end);
+	if(entry.loops != nullptr)
+		++analysis_hits;
+	else
+	{
+		entry.loops = std::make_unique<LoopForest>(cfg(begin, end), dom_tree(begin, end));
+		++analysis_builds;
+	}
+	return *entry.loops;
+}
+
+void AnalysisManager::invalidate(utils::Symbol func_name, unsigned analyses)
+{
+	auto iter = _funcs.find(func_name);
+	if(iter == _funcs.end())
+		return;
+	FuncAnalyses &entry = iter->second;
+	// Each analysis depends on all the ones before it.
+	if(analyses & CFG)
+		analyses |= DOM_TREE;
+	if(analyses & DOM_TREE)
+		analyses |= LOOPS;
+	if(analyses & LOOPS)
+		entry.loops.reset();
+	if(analyses & DOM_TREE)
+		entry.dom_tree.reset();
+	if(analyses & CFG)
+		entry.cfg.reset();
+}
+
+} // namespace compiler_skeleton::eeyore
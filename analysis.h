@@ -0,0 +1,80 @@
+#ifndef SKELETON_ANALYSIS_H
+#define SKELETON_ANALYSIS_H
+
+/*
+ * A cache of the analyses (see cfg.h) of Eeyore functions.
+ *
+ * Analyses are computed on first use and kept per function, keyed by the
+ * function name. An analysis depends on the ones before it:
+ *     CFG <- DomTree <- LoopForest
+ * so dropping one drops those that depend on it as well.
+ *
+ * Nothing is invalidated automatically: a transform that changes a function
+ * must say which analyses it did not preserve. A transform that only rewrites
+ * statements in place keeps everything; one that inserts or removes
+ * statements moves the block boundaries and must drop the CFG. In debug
+ * builds, a cached CFG is checked against the statement count of the function
+ * it is requested for.
+ *
+ * Example:
+ *     using namespace compiler_skeleton::eeyore;
+ *     AnalysisManager am;
+ *     const auto &loops = am.loops(func); // builds the CFG and DomTree too
+ *     const auto &dom = am.dom_tree(func); // cached
+ *     if(remove_dead_code(func))
+ *         am.invalidate(func_name, AnalysisManager::CFG);
+ */
+
+#include <memory>
+#include <unordered_map>
+#include "symbol.h"
+#include "eeyore.h"
+#include "cfg.h"
+
+namespace compiler_skeleton::eeyore
+{
+
+class AnalysisManager
+{
+  public:
+	// Analyses to invalidate, as bit flags.
+	enum Analysis: unsigned
+	{
+		CFG = 1, DOM_TREE = 2, LOOPS = 4, ALL = 7
+	};
+
+  protected:
+	struct FuncAnalyses
+	{
+		std::unique_ptr<eeyore::CFG> cfg;
+		std::unique_ptr<DomTree> dom_tree;
+		std::unique_ptr<LoopForest> loops;
+	};
+
+	std::unordered_map<utils::Symbol, FuncAnalyses> _funcs;
+
+	FuncAnalyses &_entry_of(const EeyoreStatement *begin, const EeyoreStatement *end);
+
+  public:
+	// [begin, end) is a whole function, from its FuncDefStmt to its
+	// EndFuncDefStmt (inclusive).
+	const eeyore::CFG &cfg(const EeyoreStatement *begin, const EeyoreStatement *end);
+	const DomTree &dom_tree(const EeyoreStatement *begin, const EeyoreStatement *end);
+	const LoopForest &loops(const EeyoreStatement *begin, const EeyoreStatement *end);
+
+	// The same, for a function on its own (e.g. in an EeyoreStream pass).
+	const eeyore::CFG &cfg(const EeyoreStmtVec &func)
+		{ return cfg(func.data(), func.data() + func.size()); }
+	const DomTree &dom_tree(const EeyoreStmtVec &func)
+		{ return dom_tree(func.data(), func.data() + func.size()); }
+	const LoopForest &loops(const EeyoreStmtVec &func)
+		{ return loops(func.data(), func.data() + func.size()); }
+
+	// Drop the given analyses of a function, and those depending on them.
+	void invalidate(utils::Symbol func_name, unsigned analyses=ALL);
+	void invalidate_all() { _funcs.clear(); }
+};
+
+} // namespace compiler_skeleton::eeyore
+
+#endif
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cstdint>
+#include "profiler.h"
+#include "arena.h"
+
+namespace
+{
+
+thread_local std::pmr::memory_resource *current_unit_resource = nullptr;
+
+compiler_skeleton::utils::Statistic arena_allocs("arena", "allocations");
+compiler_skeleton::utils::Statistic arena_bytes("arena", "bytes allocated");
+compiler_skeleton::utils::Statistic arena_chunks("arena", "chunks");
+
+inline char *align_up(char *p, size_t alignment)
+{
+	auto addr = reinterpret_cast<uintptr_t>(p);
+	return reinterpret_cast<char *>((addr + alignment - 1) & ~(alignment - 1));
+}
+
+} // namespace
+
+namespace compiler_skeleton::utils
+{
+
+Arena::Arena(size_t initial_chunk_size, std::pmr::memory_resource *upstream)
+  : _upstream(upstream), _chunks(nullptr), _cur(nullptr), _end(nullptr),
+	_initial_chunk_size(initial_chunk_size), _next_chunk_size(initial_chunk_size),
+	_bytes_allocated(0) {}
+
+void Arena::_new_chunk(size_t min_size)
+{
+	size_t size = std::max(_next_chunk_size, min_size + sizeof(Chunk));
+	auto chunk = static_cast<Chunk *>(_upstream->allocate(size, alignof(std::max_align_t)));
+	chunk->prev = _chunks;
+	chunk->size = size;
+	_chunks = chunk;
+	_cur = reinterpret_cast<char *>(chunk + 1);
+	_end = reinterpret_cast<char *>(chunk) + size;
+	_next_chunk_size = std::min(_next_chunk_size * 2, MAX_CHUNK_SIZE);
+	++arena_chunks;
+}
+
+void *Arena::do_allocate(size_t bytes, size_t alignment)
+{
+	char *p = align_up(_cur, alignment);
+	if(_cur == nullptr || p + bytes > _end)
+	{
+		_new_chunk(bytes + alignment);
+		p = align_up(_cur, alignment);
+	}
+	_cur = p + bytes;
+	_bytes_allocated += bytes;
+	++arena_allocs;
+	arena_bytes += bytes;
+	return p;
+}
+
+void Arena::release()
+{
+	while(_chunks != nullptr)
+	{
+		Chunk *prev = _chunks->prev;
+		_upstream->deallocate(_chunks, _chunks->size, alignof(std::max_align_t));
+		_chunks = prev;
+	}
+	_cur = _end = nullptr;
+	_next_chunk_size = _initial_chunk_size;
+	_bytes_allocated = 0;
+}
+
+void Arena::reset()
+{
+	Chunk **link = nullptr;
+	for(Chunk **chunk = &_chunks; *chunk != nullptr; chunk = &(*chunk)->prev)
+		if((*chunk)->size <= MAX_CHUNK_SIZE && (link == nullptr || (*chunk)->size > (*link)->size))
+			link = chunk;
+	Chunk *kept = link != nullptr? *link : nullptr;
+	if(kept != nullptr)
+		*link = kept->prev;
+	release();
+	if(kept == nullptr)
+		return;
+	kept->prev = nullptr;
+	_chunks = kept;
+	_cur = reinterpret_cast<char *>(kept + 1);
+	_end = reinterpret_cast<char *>(kept) + kept->size;
+	_next_chunk_size = std::min(kept->size * 2, MAX_CHUNK_SIZE);
+}
+
+std::pmr::memory_resource *unit_resource()
+{
+	return current_unit_resource != nullptr?
+		current_unit_resource : std::pmr::get_default_resource();
+}
+
+ArenaScope::ArenaScope(Arena &arena): _prev(current_unit_resource)
+{
+	current_unit_resource = &arena;
+}
+
+ArenaScope::~ArenaScope()
+{
+	current_unit_resource = _prev;
+}
+
+} // namespace compiler_skeleton::utils
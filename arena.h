@@ -0,0 +1,112 @@
+#ifndef SKELETON_ARENA_H
+#define SKELETON_ARENA_H
+
+/*
+ * A bump-pointer arena that plugs into std::pmr.
+ *
+ * Memory is carved out of large chunks and is never returned one object at a
+ * time; everything goes away at once when the arena is released or destroyed.
+ * This suits a compilation unit well: IR statements and AST nodes are all
+ * created while compiling a unit, and none of them is needed afterwards.
+ * (Types are interned for the whole program instead, see sysy_type.h.)
+ *
+ *  + Arena is a std::pmr::memory_resource, so it can back any pmr container,
+ *    e.g. `std::pmr::vector<EeyoreStatement> stmts{&arena};'.
+ *  + ArenaScope makes an arena the "unit resource" of the current thread.
+ *    Library code that allocates on behalf of the unit takes its memory from
+ *    `unit_resource()', which falls back to the default pmr resource when no
+ *    arena is installed.
+ *
+ * Note that destructors of objects in the arena are never run by the arena.
+ * Anything allocated from an arena must not outlive it.
+ *
+ * Example:
+ *     using namespace compiler_skeleton;
+ *     utils::Arena arena;
+ *     {
+ *         utils::ArenaScope scope(arena);
+ *         eeyore::EeyoreStmtVec stmts{utils::unit_resource()};
+ *         ... // compile the unit
+ *     }
+ *     arena.release(); // or simply let the arena go out of scope
+ */
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+namespace compiler_skeleton::utils
+{
+
+class Arena: public std::pmr::memory_resource
+{
+  protected:
+	struct Chunk
+	{
+		Chunk *prev;
+		size_t size; // including this header
+	};
+
+	std::pmr::memory_resource *_upstream;
+	Chunk *_chunks;
+	char *_cur, *_end;
+	size_t _initial_chunk_size, _next_chunk_size;
+	size_t _bytes_allocated; // bytes handed out, excluding padding
+
+	static constexpr size_t MAX_CHUNK_SIZE = 16 << 20;
+
+	void _new_chunk(size_t min_size);
+
+	void *do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void *p, size_t bytes, size_t alignment) override {}
+	bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+		{ return this == &other; }
+
+  public:
+	Arena(size_t initial_chunk_size=64 << 10,
+		std::pmr::memory_resource *upstream=std::pmr::new_delete_resource());
+	Arena(const Arena &) = delete;
+	Arena &operator = (const Arena &) = delete;
+	~Arena() override { release(); }
+
+	// Free all the chunks at once, and start over with a chunk of the initial
+	// size.
+	void release();
+	// Free all the chunks but the largest one, and start over in it, so a run
+	// of similar units allocates no memory after the first one. A chunk over
+	// MAX_CHUNK_SIZE, made for one huge allocation, is never kept.
+	void reset();
+
+	size_t bytes_allocated() const { return _bytes_allocated; }
+
+	// Construct an object in the arena. Its destructor will never be called.
+	template<class T, class ...Args>
+	T *make(Args &&...args)
+	{
+		void *p = allocate(sizeof(T), alignof(T));
+		return ::new(p) T(std::forward<Args>(args)...);
+	}
+};
+
+// The memory resource of the compilation unit on this thread. This is the
+// arena of the innermost ArenaScope, or the default pmr resource if none.
+std::pmr::memory_resource *unit_resource();
+
+// Install an arena as the unit resource of this thread until the end of the
+// scope.
+class ArenaScope
+{
+  protected:
+	std::pmr::memory_resource *_prev;
+
+  public:
+	ArenaScope(Arena &arena);
+	ArenaScope(const ArenaScope &) = delete;
+	ArenaScope &operator = (const ArenaScope &) = delete;
+	~ArenaScope();
+};
+
+} // namespace compiler_skeleton::utils
+
+#endif
@@ -0,0 +1,16 @@
+#include "ast.h"
+
+namespace compiler_skeleton::sysy
+{
+
+SrcLoc loc_of(const Expr &expr)
+{
+	return std::visit([](const auto &e) { return e.loc; }, expr);
+}
+
+SrcLoc loc_of(const Stmt &stmt)
+{
+	return std::visit([](const auto &s) { return s.loc; }, stmt);
+}
+
+} // namespace compiler_skeleton::sysy
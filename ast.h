@@ -0,0 +1,288 @@
+#ifndef SKELETON_AST_H
+#define SKELETON_AST_H
+
+/*
+ * The abstract syntax tree of SysY.
+ *
+ * All the nodes of a compilation unit live in its arena (see arena.h): nodes
+ * refer to each other by raw pointers, and lists of children are pmr vectors
+ * allocated from the same arena. Nothing in the tree is freed individually.
+ *
+ * Expressions and statements are std::variants, so they are handled with
+ * std::visit just like types and IR statements:
+ *  + Expr: NumberExpr, LValExpr, CallExpr, UnaryExpr, BinaryExpr.
+ *  + Stmt: VarDeclStmt, AssignStmt, ExprStmt, BlockStmt, IfStmt, WhileStmt,
+ *    BreakStmt, ContinueStmt, ReturnStmt.
+ *  + A CompUnit is a list of global VarDeclStmts and FuncDefs in source order.
+ *
+ * The `type' fields are empty after parsing and are filled in by semantic
+ * analysis.
+ */
+
+#include <memory_resource>
+#include <variant>
+#include <vector>
+#include "arena.h"
+#include "symbol.h"
+#include "lexer.h"
+#include "sysy_type.h"
+#include "eeyore.h"
+
+namespace compiler_skeleton::sysy
+{
+
+using UnaryOp = eeyore::UnaryOp;
+using BinaryOp = eeyore::BinaryOp;
+
+// Expressions.
+
+struct NumberExpr;
+struct LValExpr;
+struct CallExpr;
+struct UnaryExpr;
+struct BinaryExpr;
+
+using Expr = std::variant
+<
+	NumberExpr,
+	LValExpr,
+	CallExpr,
+	UnaryExpr,
+	BinaryExpr
+>;
+using ExprVec = std::pmr::vector<Expr *>;
+
+struct NumberExpr
+{
+	SrcLoc loc;
+	int val;
+
+	NumberExpr(SrcLoc _loc, int _val): loc(_loc), val(_val) {}
+};
+
+struct LValExpr
+{
+	// name[idx1][idx2]...
+	SrcLoc loc;
+	utils::Symbol name;
+	ExprVec indices;
+	TypePtr type;
+
+	LValExpr(SrcLoc _loc, utils::Symbol _name, ExprVec _indices)
+	  : loc(_loc), name(_name), indices(std::move(_indices)) {}
+};
+
+struct CallExpr
+{
+	SrcLoc loc;
+	utils::Symbol func_name;
+	ExprVec args;
+	TypePtr type;
+
+	CallExpr(SrcLoc _loc, utils::Symbol _func_name, ExprVec _args)
+	  : loc(_loc), func_name(_func_name), args(std::move(_args)) {}
+};
+
+struct UnaryExpr
+{
+	SrcLoc loc;
+	UnaryOp op;
+	Expr *opr;
+	TypePtr type;
+
+	UnaryExpr(SrcLoc _loc, UnaryOp _op, Expr *_opr)
+	  : loc(_loc), op(_op), opr(_opr) {}
+};
+
+struct BinaryExpr
+{
+	SrcLoc loc;
+	BinaryOp op;
+	Expr *opr1, *opr2;
+	TypePtr type;
+
+	BinaryExpr(SrcLoc _loc, Expr *_opr1, BinaryOp _op, Expr *_opr2)
+	  : loc(_loc), op(_op), opr1(_opr1), opr2(_opr2) {}
+};
+
+// Initializers: either a single expression or a (possibly nested) list.
+
+struct InitVal
+{
+	Expr *expr; // nullptr for a list
+	std::pmr::vector<InitVal *> elems;
+
+	InitVal(Expr *_expr, std::pmr::memory_resource *res)
+	  : expr(_expr), elems(res) {}
+	bool is_list() const { return expr == nullptr; }
+};
+
+// Declarations.
+
+struct VarDef
+{
+	// name[dim1][dim2]... = init
+	SrcLoc loc;
+	utils::Symbol name;
+	ExprVec dims;
+	InitVal *init; // nullptr if there is no initializer
+	TypePtr type;
+	// The flattened initial values of a global array, or nullptr if it is all
+	// zero. Filled in by semantic analysis.
+	const eeyore::InitData *init_data;
+
+	VarDef(SrcLoc _loc, utils::Symbol _name, ExprVec _dims, InitVal *_init)
+	  : loc(_loc), name(_name), dims(std::move(_dims)), init(_init), init_data(nullptr) {}
+};
+
+struct FuncParam
+{
+	// name, or name[][dim2][dim3]... if is_ptr
+	SrcLoc loc;
+	utils::Symbol name;
+	bool is_ptr;
+	ExprVec dims; // the dimensions after the first `[]'
+	TypePtr type;
+
+	FuncParam(SrcLoc _loc, utils::Symbol _name, bool _is_ptr, ExprVec _dims)
+	  : loc(_loc), name(_name), is_ptr(_is_ptr), dims(std::move(_dims)) {}
+};
+
+// Statements.
+
+struct VarDeclStmt;
+struct AssignStmt;
+struct ExprStmt;
+struct BlockStmt;
+struct IfStmt;
+struct WhileStmt;
+struct BreakStmt;
+struct ContinueStmt;
+struct ReturnStmt;
+
+using Stmt = std::variant
+<
+	VarDeclStmt,
+	AssignStmt,
+	ExprStmt,
+	BlockStmt,
+	IfStmt,
+	WhileStmt,
+	BreakStmt,
+	ContinueStmt,
+	ReturnStmt
+>;
+using StmtVec = std::pmr::vector<Stmt *>;
+
+struct VarDeclStmt
+{
+	SrcLoc loc;
+	bool is_const;
+	std::pmr::vector<VarDef *> defs;
+
+	VarDeclStmt(SrcLoc _loc, bool _is_const, std::pmr::vector<VarDef *> _defs)
+	  : loc(_loc), is_const(_is_const), defs(std::move(_defs)) {}
+};
+
+struct AssignStmt
+{
+	SrcLoc loc;
+	Expr *lval; // always a LValExpr
+	Expr *rval;
+
+	AssignStmt(SrcLoc _loc, Expr *_lval, Expr *_rval)
+	  : loc(_loc), lval(_lval), rval(_rval) {}
+};
+
+struct ExprStmt
+{
+	SrcLoc loc;
+	Expr *expr; // nullptr for an empty statement
+
+	ExprStmt(SrcLoc _loc, Expr *_expr): loc(_loc), expr(_expr) {}
+};
+
+struct BlockStmt
+{
+	SrcLoc loc;
+	StmtVec stmts;
+
+	BlockStmt(SrcLoc _loc, StmtVec _stmts): loc(_loc), stmts(std::move(_stmts)) {}
+};
+
+struct IfStmt
+{
+	SrcLoc loc;
+	Expr *cond;
+	Stmt *then_stmt;
+	Stmt *else_stmt; // nullptr if there is no else branch
+
+	IfStmt(SrcLoc _loc, Expr *_cond, Stmt *_then_stmt, Stmt *_else_stmt)
+	  : loc(_loc), cond(_cond), then_stmt(_then_stmt), else_stmt(_else_stmt) {}
+};
+
+struct WhileStmt
+{
+	SrcLoc loc;
+	Expr *cond;
+	Stmt *body;
+
+	WhileStmt(SrcLoc _loc, Expr *_cond, Stmt *_body)
+	  : loc(_loc), cond(_cond), body(_body) {}
+};
+
+struct BreakStmt
+{
+	SrcLoc loc;
+
+	BreakStmt(SrcLoc _loc): loc(_loc) {}
+};
+
+struct ContinueStmt
+{
+	SrcLoc loc;
+
+	ContinueStmt(SrcLoc _loc): loc(_loc) {}
+};
+
+struct ReturnStmt
+{
+	SrcLoc loc;
+	Expr *retval; // nullptr for `return;'
+
+	ReturnStmt(SrcLoc _loc, Expr *_retval): loc(_loc), retval(_retval) {}
+};
+
+// Top level.
+
+struct FuncDef
+{
+	SrcLoc loc;
+	TypePtr retval_type; // void or int
+	utils::Symbol name;
+	std::pmr::vector<FuncParam *> params;
+	BlockStmt *body;
+	TypePtr type; // the FuncType, filled in by semantic analysis
+
+	FuncDef(SrcLoc _loc, TypePtr _retval_type, utils::Symbol _name,
+		std::pmr::vector<FuncParam *> _params, BlockStmt *_body)
+	  : loc(_loc), retval_type(_retval_type), name(_name),
+		params(std::move(_params)), body(_body) {}
+};
+
+using GlobalItem = std::variant<VarDeclStmt *, FuncDef *>;
+
+struct CompUnit
+{
+	std::pmr::vector<GlobalItem> items;
+
+	CompUnit(std::pmr::memory_resource *res): items(res) {}
+};
+
+// Source location of any expression or statement.
+SrcLoc loc_of(const Expr &expr);
+SrcLoc loc_of(const Stmt &stmt);
+
+} // namespace compiler_skeleton::sysy
+
+#endif
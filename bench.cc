@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include "profiler.h"
+#include "bench.h"
+
+namespace
+{
+
+using namespace compiler_skeleton::bench;
+
+struct BenchEntry
+{
+	std::string name;
+	BenchFunc func;
+	std::vector<std::vector<int64_t>> arg_lists;
+};
+
+struct BenchResult
+{
+	std::string name;
+	size_t iterations;
+	double real_ns, cpu_ns; // per iteration
+	double items_per_sec, bytes_per_sec;
+};
+
+std::vector<BenchEntry> &registry()
+{
+	static std::vector<BenchEntry> entries;
+	return entries;
+}
+
+int64_t cpu_clock_ns()
+{
+	timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+std::string full_name(const std::string &name, const std::vector<int64_t> &args)
+{
+	std::string res = name;
+	for(int64_t arg : args)
+		res += '/' + std::to_string(arg);
+	return res;
+}
+
+// Run with more and more iterations until one run is long enough.
+BenchResult run_one(const std::string &name, const BenchFunc &func,
+	const std::vector<int64_t> &args, double min_time)
+{
+	const int64_t min_ns = static_cast<int64_t>(min_time * 1e9);
+	size_t iterations = 1;
+	while(true)
+	{
+		State state(iterations, args);
+		int64_t cpu_start = cpu_clock_ns();
+		int64_t real_start = compiler_skeleton::utils::profile_clock_ns();
+		func(state);
+		int64_t real_ns = compiler_skeleton::utils::profile_clock_ns() - real_start
+			- state.paused_ns();
+		int64_t cpu_ns = cpu_clock_ns() - cpu_start - state.paused_ns();
+
+		const size_t MAX_ITERATIONS = 1000000000;
+		if(real_ns >= min_ns || iterations >= MAX_ITERATIONS)
+		{
+			double secs = std::max<int64_t>(real_ns, 1) / 1e9;
+			return BenchResult{full_name(name, args), iterations,
+				static_cast<double>(real_ns) / iterations,
+				static_cast<double>(cpu_ns) / iterations,
+				state.items_processed() / secs, state.bytes_processed() / secs};
+		}
+		// Aim at 1.4x the minimal time, growing by at most 10x each round.
+		double scale = real_ns > 0? 1.4 * min_ns / real_ns : 10.0;
+		size_t next = static_cast<size_t>(iterations * std::min(scale, 10.0));
+		iterations = std::min(std::max(next, iterations + 1), MAX_ITERATIONS);
+	}
+}
+
+void print_result(std::ostream &out, const BenchResult &res)
+{
+	out << std::left << std::setw(48) << res.name << std::right
+		<< std::setw(16) << std::fixed << std::setprecision(1) << res.real_ns << " ns"
+		<< std::setw(12) << res.iterations;
+	if(res.items_per_sec > 0)
+		out << "  " << std::setprecision(3) << res.items_per_sec / 1e6 << " M items/s";
+	if(res.bytes_per_sec > 0)
+		out << "  " << std::setprecision(3) << res.bytes_per_sec / (1 << 20) << " MiB/s";
+	out << std::endl;
+}
+
+void write_json(std::ostream &out, const std::vector<BenchResult> &results)
+{
+	char date[32];
+	time_t now = time(nullptr);
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+	out << "{\n  \"context\": {\n"
+		<< "    \"date\": \"" << date << "\",\n"
+		<< "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+#ifdef __VERSION__
+		<< "    \"compiler\": \"" << __VERSION__ << "\",\n"
+#endif
+#ifdef NDEBUG
+		<< "    \"library_build_type\": \"release\"\n"
+#else
+		<< "    \"library_build_type\": \"debug\"\n"
+#endif
+		<< "  },\n  \"benchmarks\": [";
+	out << std::fixed << std::setprecision(3);
+	bool first = true;
+	for(const auto &res : results)
+	{
+		// Benchmark names are built from plain identifiers and numbers, so no
+		// escaping is needed.
+		out << (first? "\n" : ",\n") << "    {\"name\": \"" << res.name << "\""
+			<< ", \"run_type\": \"iteration\""
+			<< ", \"iterations\": " << res.iterations
+			<< ", \"real_time\": " << res.real_ns
+			<< ", \"cpu_time\": " << res.cpu_ns
+			<< ", \"time_unit\": \"ns\"";
+		if(res.items_per_sec > 0)
+			out << ", \"items_per_second\": " << res.items_per_sec;
+		if(res.bytes_per_sec > 0)
+			out << ", \"bytes_per_second\": " << res.bytes_per_sec;
+		out << '}';
+		first = false;
+	}
+	out << "\n  ]\n}" << std::endl;
+}
+
+} // namespace
+
+namespace compiler_skeleton::bench
+{
+
+void State::pause_timing()
+{
+	_pause_start_ns = utils::profile_clock_ns();
+}
+
+void State::resume_timing()
+{
+	_paused_ns += utils::profile_clock_ns() - _pause_start_ns;
+}
+
+void register_bench(std::string name, BenchFunc func,
+	std::vector<std::vector<int64_t>> arg_lists)
+{
+	if(arg_lists.empty())
+		arg_lists.emplace_back();
+	registry().push_back(BenchEntry{std::move(name), std::move(func), std::move(arg_lists)});
+}
+
+int run_benchmarks(int argc, char **argv)
+{
+	std::string filter;
+	double min_time = 0.2;
+	const char *json_file = nullptr;
+	for(int i = 1; i < argc; i++)
+	{
+		if(strncmp(argv[i], "--filter=", 9) == 0)
+			filter = argv[i] + 9;
+		else if(strncmp(argv[i], "--min-time=", 11) == 0)
+			min_time = atof(argv[i] + 11);
+		else if(strncmp(argv[i], "--json=", 7) == 0)
+			json_file = argv[i] + 7;
+		else
+		{
+			std::cerr << "unknown argument " << argv[i] << std::endl;
+			std::cerr << "usage: " << argv[0]
+				<< " [--filter=STR] [--min-time=SEC] [--json=FILE]" << std::endl;
+			return 1;
+		}
+	}
+
+	std::vector<BenchResult> results;
+	std::cout << std::left << std::setw(48) << "benchmark" << std::right
+		<< std::setw(19) << "time/iter" << std::setw(12) << "iterations" << std::endl;
+	for(const auto &entry : registry())
+	{
+		for(const auto &args : entry.arg_lists)
+		{
+			if(!filter.empty() && full_name(entry.name, args).find(filter) == std::string::npos)
+				continue;
+			results.push_back(run_one(entry.name, entry.func, args, min_time));
+			print_result(std::cout, results.back());
+		}
+	}
+
+	if(json_file != nullptr)
+	{
+		std::ofstream json_out(json_file);
+		if(!json_out)
+		{
+			std::cerr << "cannot open " << json_file << std::endl;
+			return 1;
+		}
+		write_json(json_out, results);
+	}
+	return 0;
+}
+
+} // namespace compiler_skeleton::bench
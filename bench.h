@@ -0,0 +1,94 @@
+#ifndef SKELETON_BENCH_H
+#define SKELETON_BENCH_H
+
+/*
+ * A small, self-contained micro-benchmark harness.
+ *
+ * A benchmark is a function taking a `bench::State'. It runs the code to be
+ * measured `state.iterations()' times, and may report how many items or bytes
+ * it processed so that throughput is printed as well. Each benchmark can be
+ * registered with several argument lists (e.g. sizes), which are appended to
+ * its name in the report, like "bitmap/union/4096/50".
+ *
+ * The harness picks the number of iterations so that each run takes at least
+ * `--min-time' seconds, then reports the time per iteration. Results are
+ * printed as a table, and can be written as JSON (`--json=FILE') in the same
+ * layout as Google Benchmark, so that the usual comparison scripts work.
+ *
+ * Example:
+ *     using namespace compiler_skeleton;
+ *     void bench_cnt(bench::State &state)
+ *     {
+ *         utils::Bitmap bitmap(state.arg(0));
+ *         for(size_t i = 0; i < state.iterations(); i++)
+ *             bench::do_not_optimize(bitmap.cnt());
+ *         state.set_items_processed(state.iterations() * state.arg(0));
+ *     }
+ *     int main(int argc, char **argv)
+ *     {
+ *         bench::register_bench("bitmap/cnt", bench_cnt, {{1024}, {65536}});
+ *         return bench::run_benchmarks(argc, argv);
+ *     }
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace compiler_skeleton::bench
+{
+
+class State
+{
+  protected:
+	size_t _iterations;
+	const std::vector<int64_t> &_args;
+	int64_t _items_processed, _bytes_processed;
+	int64_t _paused_ns, _pause_start_ns;
+
+  public:
+	State(size_t iterations, const std::vector<int64_t> &args)
+	  : _iterations(iterations), _args(args), _items_processed(0),
+		_bytes_processed(0), _paused_ns(0), _pause_start_ns(0) {}
+
+	inline size_t iterations() const { return _iterations; }
+	inline int64_t arg(size_t idx) const { return _args.at(idx); }
+
+	inline void set_items_processed(int64_t items) { _items_processed = items; }
+	inline void set_bytes_processed(int64_t bytes) { _bytes_processed = bytes; }
+	inline int64_t items_processed() const { return _items_processed; }
+	inline int64_t bytes_processed() const { return _bytes_processed; }
+
+	// Exclude the setup work between these two calls from the measured time.
+	// They cost a clock read each, so do not use them around tiny operations.
+	void pause_timing();
+	void resume_timing();
+	inline int64_t paused_ns() const { return _paused_ns; }
+};
+
+using BenchFunc = std::function<void (State &)>;
+
+// Register `func' to be run once for each argument list in `arg_lists'. An
+// empty `arg_lists' runs it once without arguments.
+void register_bench(std::string name, BenchFunc func,
+	std::vector<std::vector<int64_t>> arg_lists={});
+
+// Run all the registered benchmarks. Recognized arguments:
+//   --filter=STR: only run the benchmarks whose names contain STR.
+//   --min-time=SEC: minimal time of each measured run (default 0.2).
+//   --json=FILE: also write the results to FILE as JSON.
+// Returns the exit code of the program.
+int run_benchmarks(int argc, char **argv);
+
+// Keep the compiler from optimizing away a value that is never used.
+template<class T>
+inline void do_not_optimize(const T &val)
+{
+	asm volatile("" : : "r,m"(val) : "memory");
+}
+
+} // namespace compiler_skeleton::bench
+
+#endif
@@ -0,0 +1,601 @@
+/*
+ * The benchmark suite of the core data structures and passes (see bench.h).
+ *
+ * Usage: benchmarks [--filter=STR] [--min-time=SEC] [--json=FILE]
+ *
+ * Build it with optimizations, from all the .cc files but the flex/bison
+ * driver, e.g. `g++ -std=c++17 -O2 -DNDEBUG benchmarks.cc bench.cc bitmap.cc ...'.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <optional>
+#include <random>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "analysis.h"
+#include "arena.h"
+#include "bench.h"
+#include "bitmap.h"
+#include "compile_server.h"
+#include "copy_prop.h"
+#include "eeyore.h"
+#include "eeyore_stream.h"
+#include "lexer.h"
+#include "parser.h"
+#include "riscv.h"
+#include "synth.h"
+#include "sysy_type.h"
+#include "thread_pool.h"
+#include "tigger.h"
+#include "tigger_frame.h"
+#include "tigger_saves.h"
+#include "tigger_sched.h"
+
+namespace
+{
+
+using namespace compiler_skeleton;
+
+// A stream buffer that throws the output away, only counting the bytes.
+class NullBuf: public std::streambuf
+{
+  protected:
+	int64_t _cnt = 0;
+
+	int overflow(int ch) override { _cnt++; return ch; }
+	std::streamsize xsputn(const char *, std::streamsize n) override { _cnt += n; return n; }
+
+  public:
+	int64_t cnt() const { return _cnt; }
+};
+
+// Bitmaps.
+
+utils::Bitmap random_bitmap(size_t size, int density_percent, unsigned seed)
+{
+	std::mt19937 rng(seed);
+	utils::Bitmap bitmap(size);
+	bitmap.clear();
+	for(size_t i = 0; i < size; i++)
+		if(static_cast<int>(rng() % 100) < density_percent)
+			bitmap.set(i);
+	return bitmap;
+}
+
+void bench_bitmap_set_get(bench::State &state)
+{
+	size_t size = state.arg(0);
+	utils::Bitmap bitmap(size);
+	bitmap.clear();
+	for(size_t i = 0; i < state.iterations(); i++)
+	{
+		for(size_t j = 0; j < size; j += 3)
+			bitmap.set(j);
+		size_t cnt = 0;
+		for(size_t j = 0; j < size; j++)
+			cnt += bitmap.get(j);
+		bench::do_not_optimize(cnt);
+	}
+	state.set_items_processed(state.iterations() * (size + (size + 2) / 3));
+}
+
+void bench_bitmap_cnt(bench::State &state)
+{
+	utils::Bitmap bitmap = random_bitmap(state.arg(0), state.arg(1), 1);
+	for(size_t i = 0; i < state.iterations(); i++)
+		bench::do_not_optimize(bitmap.cnt());
+	state.set_items_processed(state.iterations() * state.arg(0));
+}
+
+// Run `op' on two random bitmaps, the way a dataflow analysis would do it.
+template<class Op>
+void bench_bitmap_binary(bench::State &state, Op op)
+{
+	size_t size = state.arg(0);
+	utils::Bitmap bitmap1 = random_bitmap(size, state.arg(1), 1),
+	              bitmap2 = random_bitmap(size, state.arg(1), 2);
+	for(size_t i = 0; i < state.iterations(); i++)
+	{
+		op(bitmap1, bitmap2);
+		bench::do_not_optimize(bitmap1);
+	}
+	state.set_items_processed(state.iterations() * size);
+}
+
+void bench_bitmap_union(bench::State &state)
+{
+	bench_bitmap_binary(state, [](utils::Bitmap &a, const utils::Bitmap &b) { a.union_with(b); });
+}
+
+void bench_bitmap_intersect(bench::State &state)
+{
+	bench_bitmap_binary(state, [](utils::Bitmap &a, const utils::Bitmap &b) { a.intersect_with(b); });
+}
+
+void bench_bitmap_diff(bench::State &state)
+{
+	bench_bitmap_binary(state, [](utils::Bitmap &a, const utils::Bitmap &b) { a.diff_with(b); });
+}
+
+// Types.
+
+// int[2][2]...[2] with `depth' dimensions.
+sysy::TypePtr deep_arr_type(int depth, bool is_const=false)
+{
+	std::vector<int> dims(depth, 2);
+	return sysy::make_arr(sysy::make_int(is_const), dims.begin(), dims.end());
+}
+
+void bench_type_make_arr(bench::State &state)
+{
+	int depth = state.arg(0);
+	std::vector<int> dims(depth, 2);
+	sysy::TypePtr int_type = sysy::make_int();
+	utils::Arena arena;
+	utils::ArenaScope scope(arena);
+	for(size_t i = 0; i < state.iterations(); i++)
+		bench::do_not_optimize(sysy::make_arr(int_type, dims.begin(), dims.end()));
+	state.set_items_processed(state.iterations() * depth);
+}
+
+// Interning on arg 0 threads at once, as when the function bodies of a unit
+// are checked in parallel: mostly types seen before, and a new one now and
+// then.
+void bench_type_intern_threads(bench::State &state)
+{
+	constexpr size_t ITEMS = 4096;
+	utils::ThreadPool pool(state.arg(0));
+	sysy::TypePtr int_type = sysy::make_int();
+	std::atomic<int> next_len(1 << 20);
+	for(size_t i = 0; i < state.iterations(); i++)
+	{
+		pool.parallel_for(ITEMS, [&](size_t item)
+		{
+			sysy::TypePtr arr = sysy::make_arr(int_type, item % 256);
+			sysy::TypePtr args[] = {sysy::make_ptr(arr), sysy::make_arr(arr, 4), int_type};
+			bench::do_not_optimize(sysy::make_func(int_type, args, args + 3));
+			if(item % 64 == 0)
+				bench::do_not_optimize(sysy::make_arr(int_type, next_len++));
+		});
+	}
+	state.set_items_processed(state.iterations() * ITEMS * 4);
+}
+
+void bench_type_is_same_type(bench::State &state)
+{
+	int depth = state.arg(0);
+	sysy::TypePtr type1 = deep_arr_type(depth), type2 = deep_arr_type(depth);
+	for(size_t i = 0; i < state.iterations(); i++)
+		bench::do_not_optimize(sysy::is_same_type(type1, type2));
+	state.set_items_processed(state.iterations() * depth);
+}
+
+void bench_type_can_accept(bench::State &state)
+{
+	// Passing an int[2]...[2] array to an int[][2]...[2] parameter.
+	int depth = state.arg(0);
+	sysy::TypePtr arg_type = deep_arr_type(depth);
+	sysy::TypePtr param_type = sysy::make_ptr(deep_arr_type(depth - 1));
+	for(size_t i = 0; i < state.iterations(); i++)
+		bench::do_not_optimize(sysy::can_accept(param_type, arg_type));
+	state.set_items_processed(state.iterations() * depth);
+}
+
+// Eeyore & Tigger.
+
+// One function of `stmt_cnt' statements, plus `main'.
+std::vector<eeyore::EeyoreStatement> synthetic_eeyore(int stmt_cnt)
+{
+	synth::EeyoreGenOptions opts;
+	opts.func_cnt = 1;
+	opts.stmts_per_func = stmt_cnt;
+	return synth::generate_eeyore(opts);
+}
+
+// A function that copies its argument along a chain of `len' temporaries,
+// then adds them all up.
+void copy_chain_eeyore(eeyore::EeyoreStmtVec &stmts, int len)
+{
+	using namespace eeyore;
+	stmts.reserve(3 * len + 4);
+	stmts.emplace_back(FuncDefStmt("chain", 1));
+	for(int i = 0; i <= len; i++)
+		stmts.emplace_back(DeclStmt(TempVar(i)));
+	stmts.emplace_back(MoveStmt(TempVar(1), Param(0)));
+	for(int i = 2; i <= len; i++)
+		stmts.emplace_back(MoveStmt(TempVar(i), TempVar(i - 1)));
+	stmts.emplace_back(MoveStmt(TempVar(0), 0));
+	for(int i = 1; i <= len; i++)
+		stmts.emplace_back(BinaryOpStmt(TempVar(0), TempVar(0), BinaryOp::ADD, TempVar(i)));
+	stmts.emplace_back(RetStmt(TempVar(0)));
+	stmts.emplace_back(EndFuncDefStmt("chain"));
+}
+
+std::vector<tigger::TiggerStatement> synthetic_tigger(int stmt_cnt, unsigned seed)
+{
+	using namespace tigger;
+	std::mt19937 rng(seed);
+	auto rand_reg = [&]() -> Reg
+	{
+		switch(rng() % 3)
+		{
+			case 0: return CalleeSavedReg(rng() % 12);
+			case 1: return CallerSavedReg(rng() % 6);
+			default: return ArgReg(rng() % 8);
+		}
+	};
+
+	std::vector<TiggerStatement> stmts;
+	stmts.reserve(stmt_cnt + 3);
+	stmts.emplace_back(GlobalArrDeclStmt(GlobalVar(0), 400));
+	stmts.emplace_back(FuncHeaderStmt("bench_func", 4, 16));
+	for(int i = 0; i < stmt_cnt; i++)
+	{
+		switch(rng() % 8)
+		{
+			case 0: stmts.emplace_back(MoveStmt(rand_reg(), rand_reg())); break;
+			case 1: stmts.emplace_back(LoadStmt(rand_reg(), static_cast<int>(rng() % 16))); break;
+			case 2: stmts.emplace_back(StoreStmt(rng() % 16, rand_reg())); break;
+			case 3: stmts.emplace_back(ReadArrStmt(rand_reg(), rand_reg(), 4 * (rng() % 8))); break;
+			case 4:
+				stmts.emplace_back(CondGotoStmt(rand_reg(), BinaryOp::LT, rand_reg(), Label(i)));
+				stmts.emplace_back(LabelStmt(Label(i)));
+				break;
+			case 5:
+				stmts.emplace_back(BinaryOpStmt(rand_reg(), rand_reg(), BinaryOp::ADD,
+					static_cast<int>(rng() % 4096)));
+				break;
+			default:
+				stmts.emplace_back(BinaryOpStmt(rand_reg(), rand_reg(),
+					static_cast<BinaryOp>(rng() % 13), rand_reg()));
+		}
+	}
+	stmts.emplace_back(ReturnStmt());
+	stmts.emplace_back(FuncEndStmt("bench_func"));
+	return stmts;
+}
+
+void bench_eeyore_used_vars(bench::State &state)
+{
+	auto stmts = synthetic_eeyore(state.arg(0));
+	std::vector<eeyore::Operand> oprs;
+	for(size_t i = 0; i < state.iterations(); i++)
+	{
+		size_t cnt = 0;
+		for(const auto &stmt : stmts)
+		{
+			eeyore::used_vars(stmt, oprs);
+			cnt += oprs.size();
+		}
+		bench::do_not_optimize(cnt);
+	}
+	state.set_items_processed(state.iterations() * stmts.size());
+}
+
+void bench_eeyore_defined_vars(bench::State &state)
+{
+	auto stmts = synthetic_eeyore(state.arg(0));
+	std::vector<eeyore::Operand> oprs;
+	for(size_t i = 0; i < state.iterations(); i++)
+	{
+		size_t cnt = 0;
+		for(const auto &stmt : stmts)
+		{
+			eeyore::defined_vars(stmt, oprs);
+			cnt += oprs.size();
+		}
+		bench::do_not_optimize(cnt);
+	}
+	state.set_items_processed(state.iterations() * stmts.size());
+}
+
+// The returning versions, which allocate a vector on each call.
+void bench_eeyore_used_vars_alloc(bench::State &state)
+{
+	auto stmts = synthetic_eeyore(state.arg(0));
+	for(size_t i = 0; i < state.iterations(); i++)
+	{
+		size_t cnt = 0;
+		for(const auto &stmt : stmts)
+			cnt += eeyore::used_vars(stmt).size();
+		bench::do_not_optimize(cnt);
+	}
+	state.set_items_processed(state.iterations() * stmts.size());
+}
+
+void bench_eeyore_print(bench::State &state)
+{
+	auto stmts = synthetic_eeyore(state.arg(0));
+	NullBuf buf;
+	std::ostream out(&buf);
+	for(size_t i = 0; i < state.iterations(); i++)
+		out << stmts;
+	state.set_items_processed(state.iterations() * stmts.size());
+	state.set_bytes_processed(buf.cnt());
+}
+
+// Generate and print `func_cnt' functions of 100 statements, either through a
+// stream or by building the whole program first (arg 1 is 1 or 0).
+void bench_eeyore_stream(bench::State &state)
+{
+	synth::EeyoreGenOptions opts;
+	opts.func_cnt = state.arg(0);
+	opts.stmts_per_func = 100;
+	NullBuf buf;
+	std::ostream out(&buf);
+	for(size_t i = 0; i < state.iterations(); i++)
+	{
+		if(state.arg(1))
+		{
+			eeyore::EeyoreStream stream(out);
+			synth::generate_eeyore(stream, opts);
+		}
+		else
+			out << synth::generate_eeyore(opts);
+	}
+	state.set_bytes_processed(buf.cnt());
+}
+
+// Loop nests of a function of `stmt_cnt' statements, either computed from
+// scratch or taken from an AnalysisManager (arg 1 is 0 or 1).
+void bench_analysis_loops(bench::State &state)
+{
+	synth::EeyoreGenOptions opts;
+	opts.func_cnt = 1;
+	opts.stmts_per_func = state.arg(0);
+	opts.branch_percent = 20;
+	auto stmts = synth::generate_eeyore(opts);
+	auto begin = std::find_if(stmts.begin(), stmts.end(),
+		[](const auto &stmt) { return std::holds_alternative<eeyore::FuncDefStmt>(stmt); });
+	auto end = std::find_if(begin, stmts.end(),
+		[](const auto &stmt) { return std::holds_alternative<eeyore::EndFuncDefStmt>(stmt); }) + 1;
+	const eeyore::EeyoreStatement *func_begin = &*begin, *func_end = &*(end - 1) + 1;
+
+	eeyore::AnalysisManager am;
+	for(size_t i = 0; i < state.iterations(); i++)
+	{
+		if(state.arg(1))
+			bench::do_not_optimize(am.loops(func_begin, func_end).loop_cnt());
+		else
+		{
+			eeyore::CFG cfg(func_begin, func_end);
+			eeyore::DomTree dom(cfg);
+			bench::do_not_optimize(eeyore::LoopForest(cfg, dom).loop_cnt());
+		}
+	}
+	state.set_items_processed(state.iterations() * (end - begin));
+}
+
+// Copy propagation and dead code elimination on a function of `stmt_cnt'
+// statements, plus `main'.
+void bench_eeyore_simplify_copies(bench::State &state)
+{
+	eeyore::EeyoreStmtVec stmts;
+	if(state.arg(1))
+		copy_chain_eeyore(stmts, state.arg(0) / 3);
+	else
+	{
+		synth::EeyoreGenOptions opts;
+		opts.func_cnt = 1;
+		opts.stmts_per_func = state.arg(0);
+		synth::generate_eeyore(stmts, opts);
+	}
+	for(size_t i = 0; i < state.iterations(); i++)
+	{
+		state.pause_timing();
+		auto copy = stmts;
+		state.resume_timing();
+		bench::do_not_optimize(eeyore::simplify_copies(copy));
+	}
+	state.set_items_processed(state.iterations() * stmts.size());
+}
+
+void bench_tigger_print(bench::State &state)
+{
+	auto stmts = synthetic_tigger(state.arg(0), 1);
+	NullBuf buf;
+	std::ostream out(&buf);
+	for(size_t i = 0; i < state.iterations(); i++)
+		out << stmts;
+	state.set_items_processed(state.iterations() * stmts.size());
+	state.set_bytes_processed(buf.cnt());
+}
+
+void bench_tigger_schedule(bench::State &state)
+{
+	auto stmts = synthetic_tigger(state.arg(0), 1);
+	for(size_t i = 0; i < state.iterations(); i++)
+	{
+		state.pause_timing();
+		auto copy = stmts;
+		state.resume_timing();
+		bench::do_not_optimize(tigger::schedule(copy));
+	}
+	state.set_items_processed(state.iterations() * stmts.size());
+}
+
+void bench_tigger_layout_frames(bench::State &state)
+{
+	auto stmts = synthetic_tigger(state.arg(0), 1);
+	for(size_t i = 0; i < state.iterations(); i++)
+	{
+		state.pause_timing();
+		auto copy = stmts;
+		state.resume_timing();
+		bench::do_not_optimize(tigger::layout_frames(copy));
+	}
+	state.set_items_processed(state.iterations() * stmts.size());
+}
+
+// `func_cnt' functions, each saving all the callee-saved registers, though it
+// only writes some of them, after an early return.
+tigger::TiggerStmtVec synthetic_tigger_funcs(int func_cnt, unsigned seed)
+{
+	using namespace tigger;
+	std::mt19937 rng(seed);
+	TiggerStmtVec stmts;
+	for(int func = 0; func < func_cnt; func++)
+	{
+		stmts.emplace_back(FuncHeaderStmt("bench_func", 2, 16));
+		for(const CalleeSavedReg &reg : ALL_CALLEE_SAVED_REG)
+			stmts.emplace_back(StoreStmt(reg.id, reg));
+		auto ret = [&stmts]()
+		{
+			for(const CalleeSavedReg &reg : ALL_CALLEE_SAVED_REG)
+				stmts.emplace_back(LoadStmt(reg, reg.id));
+			stmts.emplace_back(ReturnStmt());
+		};
+		stmts.emplace_back(CondGotoStmt(ArgReg(0), BinaryOp::LT, ArgReg(1), Label(0)));
+		ret();
+		stmts.emplace_back(LabelStmt(Label(0)));
+		for(int i = 0; i < 20; i++)
+		{
+			Reg reg = CalleeSavedReg(rng() % 6);
+			if(rng() % 4 == 0)
+				stmts.emplace_back(FuncCallStmt("bench_callee"));
+			stmts.emplace_back(BinaryOpStmt(reg, reg, BinaryOp::ADD, ArgReg(rng() % 2)));
+		}
+		stmts.emplace_back(MoveStmt(ArgReg(0), CalleeSavedReg(0)));
+		ret();
+		stmts.emplace_back(FuncEndStmt("bench_func"));
+	}
+	return stmts;
+}
+
+void bench_tigger_callee_saves(bench::State &state)
+{
+	auto stmts = synthetic_tigger_funcs(state.arg(0), 1);
+	for(size_t i = 0; i < state.iterations(); i++)
+	{
+		state.pause_timing();
+		auto copy = stmts;
+		state.resume_timing();
+		bench::do_not_optimize(tigger::place_callee_saves(copy));
+	}
+	state.set_items_processed(state.iterations() * stmts.size());
+}
+
+void bench_riscv_emit(bench::State &state)
+{
+	auto stmts = synthetic_tigger(state.arg(0), 1);
+	NullBuf buf;
+	std::ostream out(&buf);
+	for(size_t i = 0; i < state.iterations(); i++)
+		riscv::emit_riscv(out, stmts);
+	state.set_items_processed(state.iterations() * stmts.size());
+	state.set_bytes_processed(buf.cnt());
+}
+
+// End to end.
+
+// A SysY program with `func_cnt' functions of `stmt_cnt' statements each.
+std::string synthetic_sysy(int func_cnt, int stmt_cnt)
+{
+	synth::SysYGenOptions opts;
+	opts.func_cnt = func_cnt;
+	opts.stmts_per_func = stmt_cnt;
+	return synth::generate_sysy(opts);
+}
+
+void bench_e2e_front_end(bench::State &state)
+{
+	std::string src = synthetic_sysy(state.arg(0), state.arg(1));
+	utils::Arena arena;
+	for(size_t i = 0; i < state.iterations(); i++)
+	{
+		arena.release();
+		utils::ArenaScope scope(arena);
+		sysy::SyntaxError err;
+		sysy::CompUnit *unit = sysy::parse_sysy(src, arena, err);
+		if(unit == nullptr)
+		{
+			std::cerr << "synthetic program: error at " << err.loc << ": " << err.msg << std::endl;
+			exit(1);
+		}
+		bench::do_not_optimize(unit);
+	}
+	state.set_bytes_processed(state.iterations() * src.size());
+}
+
+void bench_e2e_lex(bench::State &state)
+{
+	std::string src = synthetic_sysy(state.arg(0), state.arg(1));
+	std::vector<sysy::Token> tokens;
+	for(size_t i = 0; i < state.iterations(); i++)
+	{
+		tokens.clear();
+		bench::do_not_optimize(sysy::tokenize(src, tokens));
+	}
+	state.set_bytes_processed(state.iterations() * src.size());
+}
+
+// A small unit compiled the way a compile server does, either by a server
+// kept warm across requests (arg 1 = 1) or by a fresh one each time, which
+// starts the thread pool and warms the arena up again.
+void bench_server_compile(bench::State &state)
+{
+	server::Request req{"", synthetic_sysy(state.arg(0), 20)};
+	std::optional<server::CompileServer> warm;
+	if(state.arg(1))
+		warm.emplace(2);
+	for(size_t i = 0; i < state.iterations(); i++)
+	{
+		if(warm)
+			bench::do_not_optimize(warm->compile(req).status);
+		else
+			bench::do_not_optimize(server::CompileServer(2).compile(req).status);
+	}
+	state.set_bytes_processed(state.iterations() * req.source.size());
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	using namespace compiler_skeleton::bench;
+	// Bitmap sizes and densities (in percent).
+	std::vector<std::vector<int64_t>> bitmap_args;
+	for(int64_t size : {64, 1024, 65536})
+		for(int64_t density : {1, 50})
+			bitmap_args.push_back({size, density});
+
+	register_bench("bitmap/set_get", bench_bitmap_set_get, {{64}, {1024}, {65536}});
+	register_bench("bitmap/cnt", bench_bitmap_cnt, bitmap_args);
+	register_bench("bitmap/union", bench_bitmap_union, bitmap_args);
+	register_bench("bitmap/intersect", bench_bitmap_intersect, bitmap_args);
+	register_bench("bitmap/diff", bench_bitmap_diff, bitmap_args);
+
+	register_bench("type/make_arr", bench_type_make_arr, {{1}, {4}, {16}});
+	register_bench("type/is_same_type", bench_type_is_same_type, {{1}, {4}, {16}});
+	register_bench("type/can_accept", bench_type_can_accept, {{2}, {4}, {16}});
+	// Thread count.
+	register_bench("type/intern_threads", bench_type_intern_threads, {{1}, {2}, {4}, {8}});
+
+	register_bench("eeyore/used_vars", bench_eeyore_used_vars, {{10000}});
+	register_bench("eeyore/used_vars_alloc", bench_eeyore_used_vars_alloc, {{10000}});
+	register_bench("eeyore/defined_vars", bench_eeyore_defined_vars, {{10000}});
+	register_bench("eeyore/print", bench_eeyore_print, {{10000}});
+	register_bench("eeyore/stream", bench_eeyore_stream, {{1000, 0}, {1000, 1}});
+	// Statement count and whether the function is one chain of copies.
+	register_bench("eeyore/simplify_copies", bench_eeyore_simplify_copies,
+		{{1000, 0}, {10000, 0}, {3000, 1}, {24000, 1}});
+	register_bench("analysis/loops", bench_analysis_loops, {{1000, 0}, {100000, 0}, {100000, 1}});
+
+	register_bench("tigger/print", bench_tigger_print, {{10000}});
+	register_bench("tigger/schedule", bench_tigger_schedule, {{10000}});
+	register_bench("tigger/layout_frames", bench_tigger_layout_frames, {{10000}});
+	register_bench("tigger/callee_saves", bench_tigger_callee_saves, {{1000}});
+	register_bench("riscv/emit", bench_riscv_emit, {{10000}});
+
+	// Function count and statements per function.
+	register_bench("e2e/lex", bench_e2e_lex, {{100, 100}});
+	register_bench("e2e/front_end", bench_e2e_front_end,
+		{{10, 100}, {100, 100}, {1000, 100}, {10000, 10}, {1, 100000}});
+	// Function count and whether the server is kept warm.
+	register_bench("e2e/server_compile", bench_server_compile, {{5, 0}, {5, 1}});
+
+	return run_benchmarks(argc, argv);
+}
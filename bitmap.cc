@@ -1,6 +1,15 @@
 #include <cassert>
+#include "profiler.h"
 #include "bitmap.h"
 
+namespace
+{
+
+compiler_skeleton::utils::Statistic bitmap_ops("bitmap", "whole-bitmap operations");
+compiler_skeleton::utils::Statistic bitmap_words("bitmap", "words processed");
+
+} // namespace
+
 namespace compiler_skeleton::utils
 {
 
@@ -13,7 +22,7 @@ void Bitmap::clear()
 size_t Bitmap::cnt() const
 {
 	size_t res = 0;
-	for(int i = 0; i < _size; i++)
+	for(size_t i = 0; i < _size; i++)
 		res += get(i);
 	return res;
 }
@@ -28,6 +37,8 @@ void Bitmap::union_with(const Bitmap &other)
 {
 	assert(other.size() == size());
 	size_t data_cnt = _bits.size();
+	++bitmap_ops;
+	bitmap_words += data_cnt;
 	for(size_t i = 0; i < data_cnt; i++)
 		_bits.at(i) |= other._bits.at(i);
 }
@@ -36,6 +47,8 @@ void Bitmap::intersect_with(const Bitmap &other)
 {
 	assert(other.size() == size());
 	size_t data_cnt = _bits.size();
+	++bitmap_ops;
+	bitmap_words += data_cnt;
 	for(size_t i = 0; i < data_cnt; i++)
 		_bits.at(i) &= other._bits.at(i);
 }
@@ -44,8 +57,25 @@ void Bitmap::diff_with(const Bitmap &other)
 {
 	assert(other.size() == size());
 	size_t data_cnt = _bits.size();
+	++bitmap_ops;
+	bitmap_words += data_cnt;
 	for(size_t i = 0; i < data_cnt; i++)
 		_bits.at(i) &= ~(other._bits.at(i));
 }
 
+bool Bitmap::operator == (const Bitmap &other) const
+{
+	if(_size != other._size)
+		return false;
+	size_t full_cnt = _div32(_size);
+	for(size_t i = 0; i < full_cnt; i++)
+		if(_bits.at(i) != other._bits.at(i))
+			return false;
+	int remain = _remain_div32(_size);
+	if(remain == 0)
+		return true;
+	uint32_t mask = (uint32_t(1) << remain) - 1;
+	return ((_bits.at(full_cnt) ^ other._bits.at(full_cnt)) & mask) == 0;
+}
+
 } // namespace compiler_skeleton::utils
\ No newline at end of file
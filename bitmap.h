@@ -9,8 +9,10 @@
  *   + size/resize to get/set its size.
  *   + clear/flip_all to change all the bits.
  *   + union_with/intersect_with/diff_with another Bitmap
+ *   + compare with another Bitmap
  */
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 #include <unordered_map>
@@ -58,6 +60,11 @@ class Bitmap
 	void union_with(const Bitmap &other);
 	void intersect_with(const Bitmap &other);
 	void diff_with(const Bitmap &other);
+
+	// Only bits below the size are compared; the padding bits of the last
+	// word (e.g. set by flip_all or left by resize) are ignored.
+	bool operator == (const Bitmap &other) const;
+	inline bool operator != (const Bitmap &other) const { return !(*this == other); }
 };
 
 } // compiler_skeleton::utils
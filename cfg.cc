@@ -0,0 +1,311 @@
+#include <algorithm>
+#include <cassert>
+#include <utility>
+#include "profiler.h"
+#include "cfg.h"
+
+namespace compiler_skeleton::eeyore
+{
+
+namespace
+{
+
+// The statement types the graph is built from, for each IR.
+struct EeyoreIR
+{
+	using Statement = EeyoreStatement;
+	using FuncBegin = FuncDefStmt;
+	using FuncEnd = EndFuncDefStmt;
+	using Label = LabelStmt;
+	using Goto = GotoStmt;
+	using CondGoto = CondGotoStmt;
+	using Return = RetStmt;
+};
+
+struct TiggerIR
+{
+	using Statement = tigger::TiggerStatement;
+	using FuncBegin = tigger::FuncHeaderStmt;
+	using FuncEnd = tigger::FuncEndStmt;
+	using Label = tigger::LabelStmt;
+	using Goto = tigger::GotoStmt;
+	using CondGoto = tigger::CondGotoStmt;
+	using Return = tigger::ReturnStmt;
+};
+
+} // namespace
+
+CFG::CFG(const EeyoreStatement *begin, const EeyoreStatement *end)
+  : _stmt_cnt(static_cast<int>(end - begin))
+{
+	_build<EeyoreIR>(begin, end);
+}
+
+CFG::CFG(const tigger::TiggerStatement *begin, const tigger::TiggerStatement *end)
+  : _stmt_cnt(static_cast<int>(end - begin))
+{
+	_build<TiggerIR>(begin, end);
+}
+
+template<class IR>
+void CFG::_build(const typename IR::Statement *begin, const typename IR::Statement *end)
+{
+	utils::ScopedTimer timer("build cfg");
+	assert(_stmt_cnt >= 2 && std::holds_alternative<typename IR::FuncBegin>(*begin)
+		&& std::holds_alternative<typename IR::FuncEnd>(*(end - 1)));
+
+	// A block starts at a label and ends after a jump or a return.
+	int body_end = _stmt_cnt - 1;
+	std::unordered_map<int, int> block_of_label;
+	for(int i = 1; i < body_end; i++)
+	{
+		const auto &stmt = begin[i];
+		bool is_label = std::holds_alternative<typename IR::Label>(stmt);
+		if(_blocks.empty() || (is_label && _blocks.back().end > _blocks.back().begin))
+			_blocks.push_back(BasicBlock{i, i, {}, {}});
+		if(is_label)
+			block_of_label[std::get<typename IR::Label>(stmt).label.id] = block_cnt() - 1;
+		_blocks.back().end = i + 1;
+		if(std::holds_alternative<typename IR::Goto>(stmt)
+			|| std::holds_alternative<typename IR::CondGoto>(stmt)
+			|| std::holds_alternative<typename IR::Return>(stmt))
+		{
+			if(i + 1 < body_end)
+				_blocks.push_back(BasicBlock{i + 1, i + 1, {}, {}});
+		}
+	}
+	if(_blocks.empty()) // an empty function still has an entry
+		_blocks.push_back(BasicBlock{1, 1, {}, {}});
+
+	auto add_edge = [this](int from, int to)
+	{
+		_blocks[from].succs.push_back(to);
+		_blocks[to].preds.push_back(from);
+	};
+	for(int idx = 0; idx < block_cnt(); idx++)
+	{
+		const BasicBlock &block = _blocks[idx];
+		bool falls_through = true;
+		if(block.end > block.begin)
+		{
+			const auto &last = begin[block.end - 1];
+			if(auto jump = std::get_if<typename IR::Goto>(&last))
+			{
+				add_edge(idx, block_of_label.at(jump->goto_label.id));
+				falls_through = false;
+			}
+			else if(auto jump = std::get_if<typename IR::CondGoto>(&last))
+			{
+				int target = block_of_label.at(jump->goto_label.id);
+				add_edge(idx, target);
+				// Both edges may lead to the same block.
+				falls_through = idx + 1 != target;
+			}
+			else if(std::holds_alternative<typename IR::Return>(last))
+				falls_through = false;
+		}
+		if(falls_through && idx + 1 < block_cnt())
+			add_edge(idx, idx + 1);
+	}
+	_compute_rpo();
+}
+
+void CFG::_compute_rpo()
+{
+	// Iterative DFS, since long functions would overflow the stack.
+	std::vector<char> visited(_blocks.size(), false);
+	std::vector<std::pair<int, size_t>> stack{{0, 0}};
+	visited[0] = true;
+	while(!stack.empty())
+	{
+		auto &[block, succ_idx] = stack.back();
+		if(succ_idx < _blocks[block].succs.size())
+		{
+			int succ = _blocks[block].succs[succ_idx++];
+			if(!visited[succ])
+			{
+				visited[succ] = true;
+				stack.emplace_back(succ, 0);
+			}
+			continue;
+		}
+		_rpo.push_back(block);
+		stack.pop_back();
+	}
+	std::reverse(_rpo.begin(), _rpo.end());
+}
+
+DomTree::DomTree(const CFG &cfg)
+  : _idom(cfg.block_cnt(), -1), _children(cfg.block_cnt()),
+	_pre(cfg.block_cnt(), -1), _post(cfg.block_cnt(), -1)
+{
+	utils::ScopedTimer timer("dominator tree");
+	const auto &rpo = cfg.rpo();
+	std::vector<int> rpo_num(cfg.block_cnt(), -1);
+	for(size_t i = 0; i < rpo.size(); i++)
+		rpo_num[rpo[i]] = static_cast<int>(i);
+
+	// During the iteration the entry is its own idom, which ends the walks up.
+	auto intersect = [&](int block1, int block2)
+	{
+		while(block1 != block2)
+		{
+			while(rpo_num[block1] > rpo_num[block2])
+				block1 = _idom[block1];
+			while(rpo_num[block2] > rpo_num[block1])
+				block2 = _idom[block2];
+		}
+		return block1;
+	};
+	_idom[0] = 0;
+	for(bool changed = true; changed; )
+	{
+		changed = false;
+		for(size_t i = 1; i < rpo.size(); i++)
+		{
+			int block = rpo[i], new_idom = -1;
+			for(int pred : cfg.block(block).preds)
+			{
+				if(_idom[pred] < 0)
+					continue;
+				new_idom = new_idom < 0? pred : intersect(pred, new_idom);
+			}
+			if(new_idom != _idom[block])
+			{
+				_idom[block] = new_idom;
+				changed = true;
+			}
+		}
+	}
+	_idom[0] = -1;
+
+	for(size_t i = 1; i < rpo.size(); i++)
+		_children[_idom[rpo[i]]].push_back(rpo[i]);
+	int counter = 0;
+	std::vector<std::pair<int, size_t>> stack{{0, 0}};
+	_pre[0] = counter++;
+	while(!stack.empty())
+	{
+		auto &[block, child_idx] = stack.back();
+		if(child_idx < _children[block].size())
+		{
+			int child = _children[block][child_idx++];
+			_pre[child] = counter++;
+			stack.emplace_back(child, 0);
+			continue;
+		}
+		_post[block] = counter++;
+		stack.pop_back();
+	}
+}
+
+LoopForest::LoopForest(const CFG &cfg, const DomTree &dom)
+  : _loop_of(cfg.block_cnt(), -1)
+{
+	utils::ScopedTimer timer("loop forest");
+	// Loops are found innermost first, by visiting the headers in postorder.
+	// A loop that has been found is collapsed into its header (`rep' is a
+	// union-find forest), so the walk of an enclosing loop steps over it in one
+	// go, and every block is visited a constant number of times overall.
+	std::vector<int> rep(cfg.block_cnt());
+	for(int block = 0; block < cfg.block_cnt(); block++)
+		rep[block] = block;
+	auto find = [&rep](int block)
+	{
+		int root = block;
+		while(rep[root] != root)
+			root = rep[root];
+		while(rep[block] != root)
+			block = std::exchange(rep[block], root);
+		return root;
+	};
+
+	std::vector<Loop> found;
+	std::vector<int> loop_of_header(cfg.block_cnt(), -1);
+	std::vector<int> worklist;
+	for(auto iter = cfg.rpo().rbegin(); iter != cfg.rpo().rend(); ++iter)
+	{
+		int header = *iter;
+		worklist.clear();
+		for(int pred : cfg.block(header).preds)
+			if(dom.dominates(header, pred))
+				worklist.push_back(pred);
+		if(worklist.empty())
+			continue;
+		int loop_idx = static_cast<int>(found.size());
+		found.push_back(Loop{header, {header}, -1, {}, 0});
+		loop_of_header[header] = loop_idx;
+		while(!worklist.empty())
+		{
+			int block = find(worklist.back());
+			worklist.pop_back();
+			if(block == header)
+				continue;
+			rep[block] = header;
+			if(int sub_loop = loop_of_header[block]; sub_loop >= 0)
+			{
+				found[sub_loop].parent = loop_idx;
+				found[loop_idx].children.push_back(sub_loop);
+			}
+			else
+				found[loop_idx].blocks.push_back(block);
+			// For a collapsed loop, the edges from inside it now lead to the
+			// header and are skipped when popped.
+			for(int pred : cfg.block(block).preds)
+				if(dom.is_reachable(pred))
+					worklist.push_back(pred);
+		}
+	}
+
+	// Renumber in preorder of the nest, so enclosing loops come first.
+	std::vector<int> new_idx(found.size(), -1);
+	std::vector<int> stack;
+	for(int idx = static_cast<int>(found.size()) - 1; idx >= 0; idx--)
+		if(found[idx].parent < 0)
+			stack.push_back(idx);
+	while(!stack.empty())
+	{
+		int idx = stack.back();
+		stack.pop_back();
+		new_idx[idx] = static_cast<int>(_loops.size());
+		_loops.push_back(std::move(found[idx]));
+		for(auto child = _loops.back().children.rbegin(); child != _loops.back().children.rend(); ++child)
+			stack.push_back(*child);
+	}
+	for(auto &loop : _loops)
+	{
+		if(loop.parent >= 0)
+			loop.parent = new_idx[loop.parent];
+		for(int &child : loop.children)
+			child = new_idx[child];
+		loop.depth = loop.parent < 0? 1 : _loops[loop.parent].depth + 1;
+		std::sort(loop.blocks.begin(), loop.blocks.end());
+	}
+	for(int idx = 0; idx < loop_cnt(); idx++)
+		for(int block : _loops[idx].blocks)
+			_loop_of[block] = idx;
+}
+
+bool LoopForest::contains(int loop, int block) const
+{
+	for(int inner = _loop_of[block]; inner >= 0; inner = _loops[inner].parent)
+		if(inner == loop)
+			return true;
+	return false;
+}
+
+std::vector<int> LoopForest::all_blocks(int loop) const
+{
+	std::vector<int> blocks, stack{loop};
+	while(!stack.empty())
+	{
+		const Loop &cur = _loops[stack.back()];
+		stack.pop_back();
+		blocks.insert(blocks.end(), cur.blocks.begin(), cur.blocks.end());
+		stack.insert(stack.end(), cur.children.begin(), cur.children.end());
+	}
+	std::sort(blocks.begin(), blocks.end());
+	return blocks;
+}
+
+} // namespace compiler_skeleton::eeyore
@@ -0,0 +1,130 @@
+#ifndef SKELETON_CFG_H
+#define SKELETON_CFG_H
+
+/*
+ * Control flow graphs of Eeyore functions, with dominator trees and loop
+ * nests on top of them. Tigger functions have graphs of the same shape, which
+ * the back end passes use.
+ *
+ *  + CFG splits a function into basic blocks. A block is a range of statement
+ *    indices, counted from the FuncDefStmt of the function (which, like the
+ *    EndFuncDefStmt, belongs to no block). Block 0 is the entry block.
+ *  + DomTree is computed with the iterative algorithm of Cooper, Harvey and
+ *    Kennedy ("A Simple, Fast Dominance Algorithm"), which is faster than
+ *    Lengauer-Tarjan on CFGs of the size compilers see. Unreachable blocks are
+ *    not in the tree.
+ *  + LoopForest holds the natural loops, found from the back edges (edges to a
+ *    dominator). Loops with the same header are merged, and loops are nested
+ *    by containment. Each block is only listed in its innermost loop, so the
+ *    forest stays linear in size however deep the nest is. Irreducible
+ *    cycles have no back edge and are not loops.
+ *
+ * These are usually obtained from an AnalysisManager (see analysis.h), which
+ * caches them.
+ *
+ * Example:
+ *     using namespace compiler_skeleton::eeyore;
+ *     CFG cfg(func.data(), func.data() + func.size());
+ *     DomTree dom(cfg);
+ *     LoopForest loops(cfg, dom);
+ *     for(int block = 0; block < cfg.block_cnt(); block++)
+ *         std::cout << block << ": depth " << loops.depth_of(block) << std::endl;
+ */
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include "eeyore.h"
+#include "tigger.h"
+
+namespace compiler_skeleton::eeyore
+{
+
+struct BasicBlock
+{
+	int begin, end; // statement indices [begin, end)
+	std::vector<int> succs, preds;
+};
+
+class CFG
+{
+  protected:
+	std::vector<BasicBlock> _blocks;
+	std::vector<int> _rpo; // reachable blocks in reverse postorder
+	int _stmt_cnt;
+
+	template<class IR>
+	void _build(const typename IR::Statement *begin, const typename IR::Statement *end);
+	void _compute_rpo();
+
+  public:
+	// [begin, end) is a whole function, from its FuncDefStmt to its
+	// EndFuncDefStmt (inclusive).
+	CFG(const EeyoreStatement *begin, const EeyoreStatement *end);
+	// The same, from a FuncHeaderStmt to a FuncEndStmt.
+	CFG(const tigger::TiggerStatement *begin, const tigger::TiggerStatement *end);
+
+	int block_cnt() const { return static_cast<int>(_blocks.size()); }
+	const BasicBlock &block(int idx) const { return _blocks[idx]; }
+	const std::vector<BasicBlock> &blocks() const { return _blocks; }
+	const std::vector<int> &rpo() const { return _rpo; }
+	// Statements of the function the graph was built from.
+	int stmt_cnt() const { return _stmt_cnt; }
+};
+
+class DomTree
+{
+  protected:
+	std::vector<int> _idom; // -1 for the entry and for unreachable blocks
+	std::vector<std::vector<int>> _children;
+	std::vector<int> _pre, _post; // DFS numbers on the tree, -1 if unreachable
+
+  public:
+	explicit DomTree(const CFG &cfg);
+
+	int idom(int block) const { return _idom[block]; }
+	const std::vector<int> &children(int block) const { return _children[block]; }
+	bool is_reachable(int block) const { return _pre[block] >= 0; }
+	// Every block dominates itself.
+	bool dominates(int dom, int block) const
+	{
+		return is_reachable(dom) && is_reachable(block)
+			&& _pre[dom] <= _pre[block] && _post[block] <= _post[dom];
+	}
+};
+
+struct Loop
+{
+	int header;
+	// The header and the other blocks whose innermost loop this is, in
+	// increasing order. Blocks of nested loops are only in those loops.
+	std::vector<int> blocks;
+	int parent; // index of the enclosing loop, -1 for outermost loops
+	std::vector<int> children;
+	int depth; // 1 for outermost loops
+};
+
+class LoopForest
+{
+  protected:
+	std::vector<Loop> _loops; // enclosing loops come before the loops in them
+	std::vector<int> _loop_of; // innermost loop of each block, -1 if none
+
+  public:
+	LoopForest(const CFG &cfg, const DomTree &dom);
+
+	int loop_cnt() const { return static_cast<int>(_loops.size()); }
+	const Loop &loop(int idx) const { return _loops[idx]; }
+	const std::vector<Loop> &loops() const { return _loops; }
+	int loop_of(int block) const { return _loop_of[block]; }
+	int depth_of(int block) const
+		{ return _loop_of[block] < 0? 0 : _loops[_loop_of[block]].depth; }
+	// Whether `block' is in `loop' or in a loop nested in it.
+	bool contains(int loop, int block) const;
+	// The blocks of `loop' and of the loops nested in it, in increasing order.
+	std::vector<int> all_blocks(int loop) const;
+};
+
+} // namespace compiler_skeleton::eeyore
+
+#endif
@@ -0,0 +1,224 @@
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "profiler.h"
+#include "front_end.h"
+#include "compile_server.h"
+
+namespace
+{
+
+compiler_skeleton::utils::Statistic conns_served("server", "connections served");
+compiler_skeleton::utils::Statistic requests_served("server", "requests served");
+
+constexpr uint32_t MAX_STRING_SIZE = 1u << 30;
+
+// Blocking I/O of whole messages on a connected socket.
+class Conn
+{
+  protected:
+	int _fd;
+
+  public:
+	Conn(int fd): _fd(fd) {}
+
+	bool read_bytes(void *buf, size_t size)
+	{
+		for(auto p = static_cast<char *>(buf); size > 0; )
+		{
+			ssize_t got = recv(_fd, p, size, 0);
+			if(got < 0 && errno == EINTR)
+				continue;
+			if(got <= 0)
+				return false;
+			p += got;
+			size -= got;
+		}
+		return true;
+	}
+
+	bool write_bytes(const void *buf, size_t size)
+	{
+		for(auto p = static_cast<const char *>(buf); size > 0; )
+		{
+			// A peer that hangs up must not kill us with SIGPIPE.
+			ssize_t put = send(_fd, p, size, MSG_NOSIGNAL);
+			if(put < 0 && errno == EINTR)
+				continue;
+			if(put <= 0)
+				return false;
+			p += put;
+			size -= put;
+		}
+		return true;
+	}
+
+	bool read_u32(uint32_t &val)
+	{
+		unsigned char bytes[4];
+		if(!read_bytes(bytes, 4))
+			return false;
+		val = bytes[0] | bytes[1] << 8 | bytes[2] << 16 | uint32_t(bytes[3]) << 24;
+		return true;
+	}
+
+	bool write_u32(uint32_t val)
+	{
+		unsigned char bytes[4] = {
+			static_cast<unsigned char>(val), static_cast<unsigned char>(val >> 8),
+			static_cast<unsigned char>(val >> 16), static_cast<unsigned char>(val >> 24)};
+		return write_bytes(bytes, 4);
+	}
+
+	bool read_string(std::string &str)
+	{
+		uint32_t size;
+		if(!read_u32(size) || size > MAX_STRING_SIZE)
+			return false;
+		str.resize(size);
+		return read_bytes(str.data(), size);
+	}
+
+	bool write_string(const std::string &str)
+	{
+		return write_u32(static_cast<uint32_t>(str.size())) && write_bytes(str.data(), str.size());
+	}
+};
+
+// Fill in the address of the socket at `path'. Returns false if it is too long.
+bool socket_addr(const char *path, sockaddr_un &addr)
+{
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if(strlen(path) >= sizeof(addr.sun_path))
+		return false;
+	strcpy(addr.sun_path, path);
+	return true;
+}
+
+} // namespace
+
+namespace compiler_skeleton::server
+{
+
+CompileServer::CompileServer(int thread_cnt): _listen_fd(-1), _pool(thread_cnt) {}
+
+CompileServer::~CompileServer()
+{
+	if(_listen_fd >= 0)
+	{
+		close(_listen_fd);
+		unlink(_socket_path.c_str());
+	}
+}
+
+bool CompileServer::listen(const char *path)
+{
+	sockaddr_un addr;
+	if(!socket_addr(path, addr))
+		return false;
+	struct stat st;
+	if(lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+		unlink(path);
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0)
+		return false;
+	if(bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 || ::listen(fd, 64) != 0)
+	{
+		close(fd);
+		return false;
+	}
+	_listen_fd = fd;
+	_socket_path = path;
+	return true;
+}
+
+void CompileServer::serve()
+{
+	for(bool running = _listen_fd >= 0; running; )
+	{
+		int fd = accept(_listen_fd, nullptr, nullptr);
+		if(fd < 0)
+		{
+			running = errno == EINTR || errno == ECONNABORTED;
+			continue;
+		}
+		running = _serve_conn(fd);
+		close(fd);
+	}
+}
+
+bool CompileServer::_serve_conn(int fd)
+{
+	utils::ScopedTimer timer("serve connection");
+	++conns_served;
+	Conn conn(fd);
+	for(char kind; conn.read_bytes(&kind, 1); )
+	{
+		if(kind == 'Q')
+			return false;
+		Request req;
+		if(kind != 'C' || !conn.read_string(req.filename) || !conn.read_string(req.source))
+			break;
+		Response resp = compile(req);
+		if(!conn.write_u32(static_cast<uint32_t>(resp.status))
+			|| !conn.write_string(resp.out) || !conn.write_string(resp.err))
+		{
+			break;
+		}
+	}
+	return true;
+}
+
+Response CompileServer::compile(const Request &req)
+{
+	utils::ScopedTimer timer("serve request");
+	++requests_served;
+	auto res = sysy::check_source(req.source, _arena, &_pool);
+	// Keep the memory of this unit for the next one.
+	_arena.reset();
+
+	std::ostringstream out, err;
+	sysy::print_result(res, req.filename.c_str(), !req.filename.empty(), out, err);
+	Response resp;
+	resp.status = res.ok()? 0 : 1;
+	resp.out = out.str();
+	resp.err = err.str();
+	return resp;
+}
+
+bool compile_remote(const char *socket_path, const std::vector<Request> &reqs,
+	std::vector<Response> &resps, bool quit)
+{
+	sockaddr_un addr;
+	if(!socket_addr(socket_path, addr))
+		return false;
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0)
+		return false;
+	bool ok = connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0;
+	Conn conn(fd);
+	resps.clear();
+	// One request at a time, so neither side blocks on a full socket buffer
+	// while the other one is writing too.
+	for(size_t i = 0; ok && i < reqs.size(); i++)
+	{
+		uint32_t status = 0;
+		Response &resp = resps.emplace_back();
+		ok = conn.write_bytes("C", 1) && conn.write_string(reqs[i].filename)
+			&& conn.write_string(reqs[i].source) && conn.read_u32(status)
+			&& conn.read_string(resp.out) && conn.read_string(resp.err);
+		resp.status = static_cast<int>(status);
+	}
+	if(ok && quit)
+		ok = conn.write_bytes("Q", 1);
+	close(fd);
+	return ok;
+}
+
+} // namespace compiler_skeleton::server
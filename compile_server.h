@@ -0,0 +1,94 @@
+#ifndef SKELETON_COMPILE_SERVER_H
+#define SKELETON_COMPILE_SERVER_H
+
+/*
+ * A persistent compile server on a local (Unix domain) socket.
+ *
+ * A compiler process pays for its start, for warming up the allocator and for
+ * interning the same names and types (the runtime functions, `int[]', ...) on
+ * every run. The server pays once: the symbol table and the types stay
+ * interned across requests, the thread pool is started once, and the unit
+ * arena is reset rather than released between requests (see Arena::reset()).
+ * A request then costs the compile work itself, plus a round trip.
+ *
+ * Protocol: a client connects, sends any number of requests and reads one
+ * response per request, in order. All integers are 32-bit little-endian, and
+ * a string is its length followed by its bytes.
+ *  + A request is a kind byte, then for 'C' (compile) the file name and the
+ *    source text as strings. 'Q' (quit) stops the server after the responses
+ *    owed to this connection.
+ *  + A response is the exit status (0 on success), then the output and the
+ *    error messages as strings, as the example driver would print them.
+ *
+ * Connections are served one at a time, and each request has the whole
+ * thread pool to itself.
+ *
+ * Example:
+ *     using namespace compiler_skeleton::server;
+ *     // in the server process
+ *     CompileServer server;
+ *     if(server.listen("/tmp/sysy.sock"))
+ *         server.serve();
+ *     // in a client
+ *     std::vector<Response> resps;
+ *     if(compile_remote("/tmp/sysy.sock", {{"a.sy", source}}, resps))
+ *         std::cout << resps[0].out;
+ */
+
+#include <string>
+#include <vector>
+#include "arena.h"
+#include "thread_pool.h"
+
+namespace compiler_skeleton::server
+{
+
+struct Request
+{
+	std::string filename; // only used in messages
+	std::string source;
+};
+
+struct Response
+{
+	int status = 0;
+	std::string out, err;
+};
+
+class CompileServer
+{
+  protected:
+	std::string _socket_path;
+	int _listen_fd;
+	utils::ThreadPool _pool;
+	utils::Arena _arena; // reset after every request
+
+	// Serve one connection. Returns false if it asked the server to quit.
+	bool _serve_conn(int fd);
+
+  public:
+	// `thread_cnt' is as for ThreadPool.
+	explicit CompileServer(int thread_cnt=0);
+	~CompileServer();
+	CompileServer(const CompileServer &) = delete;
+	CompileServer &operator = (const CompileServer &) = delete;
+
+	// Listen at the socket path `path', replacing a stale socket file there.
+	// Returns false on failure (e.g. a path too long for a socket).
+	bool listen(const char *path);
+	// Serve connections until one of them asks to quit.
+	void serve();
+
+	// Compile one request in this process, as served.
+	Response compile(const Request &req);
+};
+
+// Send the requests to the server at `socket_path' over one connection, and
+// receive their responses in order. Ask the server to quit afterwards if
+// `quit' is set. Returns false if the server cannot be reached, or hangs up.
+bool compile_remote(const char *socket_path, const std::vector<Request> &reqs,
+	std::vector<Response> &resps, bool quit=false);
+
+} // namespace compiler_skeleton::server
+
+#endif
@@ -0,0 +1,179 @@
+#include <cstdint>
+#include "lambda_visitor.h"
+#include "profiler.h"
+#include "const_eval.h"
+
+namespace
+{
+
+compiler_skeleton::utils::Statistic eeyore_folded("const eval", "Eeyore statements folded");
+
+} // namespace
+
+namespace compiler_skeleton::eeyore
+{
+
+std::optional<int> eval_unary(UnaryOp op, int val)
+{
+	switch(op)
+	{
+		case UnaryOp::NEG: return static_cast<int>(0u - static_cast<uint32_t>(val));
+		case UnaryOp::NOT: return !val;
+	}
+	return std::nullopt;
+}
+
+std::optional<int> eval_binary(BinaryOp op, int val1, int val2)
+{
+	auto u1 = static_cast<uint32_t>(val1), u2 = static_cast<uint32_t>(val2);
+	switch(op)
+	{
+		case BinaryOp::ADD: return static_cast<int>(u1 + u2);
+		case BinaryOp::SUB: return static_cast<int>(u1 - u2);
+		case BinaryOp::MUL: return static_cast<int>(u1 * u2);
+		case BinaryOp::DIV:
+			if(val2 == 0)
+				return std::nullopt;
+			return val2 == -1? static_cast<int>(0u - u1) : val1 / val2;
+		case BinaryOp::MOD:
+			if(val2 == 0)
+				return std::nullopt;
+			return val2 == -1? 0 : val1 % val2;
+		case BinaryOp::OR: return val1 || val2;
+		case BinaryOp::AND: return val1 && val2;
+		case BinaryOp::GT: return val1 > val2;
+		case BinaryOp::LT: return val1 < val2;
+		case BinaryOp::GE: return val1 >= val2;
+		case BinaryOp::LE: return val1 <= val2;
+		case BinaryOp::EQ: return val1 == val2;
+		case BinaryOp::NE: return val1 != val2;
+	}
+	return std::nullopt;
+}
+
+bool fold_stmt(EeyoreStatement &stmt)
+{
+	auto imm = [](const Operand &opr) { return std::get_if<int>(&opr); };
+	std::optional<EeyoreStatement> folded;
+	bool keep = true;
+	std::visit(utils::LambdaVisitor
+	{
+		[&](const UnaryOpStmt &s)
+		{
+			if(auto val = imm(s.opr1))
+				if(auto res = eval_unary(s.op_type, *val))
+					folded = MoveStmt(s.opr, res.value());
+		},
+		[&](const BinaryOpStmt &s)
+		{
+			auto val1 = imm(s.opr1), val2 = imm(s.opr2);
+			if(val1 != nullptr && val2 != nullptr)
+				if(auto res = eval_binary(s.op_type, *val1, *val2))
+					folded = MoveStmt(s.opr, res.value());
+		},
+		[&](const CondGotoStmt &s)
+		{
+			auto val1 = imm(s.opr1), val2 = imm(s.opr2);
+			if(val1 != nullptr && val2 != nullptr)
+			{
+				if(eval_binary(s.op, *val1, *val2).value_or(0))
+					folded = GotoStmt(s.goto_label);
+				else
+					keep = false;
+			}
+		},
+		[](const auto &s) {}
+	}, stmt);
+	if(folded.has_value())
+		stmt = std::move(folded.value());
+	if(folded.has_value() || !keep)
+		++eeyore_folded;
+	return keep;
+}
+
+size_t fold_constants(EeyoreStmtVec &stmts)
+{
+	utils::ScopedTimer timer("fold constants");
+	size_t changed = 0, out = 0;
+	for(size_t i = 0; i < stmts.size(); i++)
+	{
+		size_t index = stmts[i].index();
+		bool keep = fold_stmt(stmts[i]);
+		if(!keep || stmts[i].index() != index)
+			changed++;
+		if(keep)
+		{
+			if(out != i)
+				stmts[out] = std::move(stmts[i]);
+			out++;
+		}
+	}
+	stmts.erase(stmts.begin() + out, stmts.end());
+	return changed;
+}
+
+} // namespace compiler_skeleton::eeyore
+
+namespace compiler_skeleton::sysy
+{
+
+namespace
+{
+
+// The value of `name[indices]', if it is an element of a const array.
+std::optional<int> eval_arr_read(const ConstValue &arr, const ExprVec &indices,
+	const ConstScope &scope)
+{
+	TypePtr type = arr.type;
+	int offset = 0;
+	for(const Expr *idx_expr : indices)
+	{
+		if(!is_arr(type))
+			return std::nullopt;
+		auto idx = eval_const(*idx_expr, scope);
+		if(!idx.has_value() || idx.value() < 0 || idx.value() >= type->len())
+			return std::nullopt;
+		type = type->element_type();
+		offset += idx.value() * (type->size() / 4);
+	}
+	// Only whole elements are values; a partially indexed array is not.
+	if(!is_int(type))
+		return std::nullopt;
+	return arr.data != nullptr? arr.data->get(offset) : 0;
+}
+
+} // namespace
+
+std::optional<int> eval_const(const Expr &expr, const ConstScope &scope)
+{
+	return std::visit(utils::LambdaVisitor
+	{
+		[](const NumberExpr &e) -> std::optional<int> { return e.val; },
+		[&](const LValExpr &e) -> std::optional<int>
+		{
+			const ConstValue *var = scope.lookup_const(e.name);
+			if(var == nullptr || var->type == nullptr || !is_const_type(var->type))
+				return std::nullopt;
+			if(is_arr(var->type))
+				return eval_arr_read(*var, e.indices, scope);
+			return e.indices.empty()? var->scalar : std::nullopt;
+		},
+		[](const CallExpr &e) -> std::optional<int> { return std::nullopt; },
+		[&](const UnaryExpr &e) -> std::optional<int>
+		{
+			auto val = eval_const(*e.opr, scope);
+			if(!val.has_value())
+				return std::nullopt;
+			return eeyore::eval_unary(e.op, val.value());
+		},
+		[&](const BinaryExpr &e) -> std::optional<int>
+		{
+			auto val1 = eval_const(*e.opr1, scope), val2 = eval_const(*e.opr2, scope);
+			if(!val1.has_value() || !val2.has_value())
+				return std::nullopt;
+			return eeyore::eval_binary(e.op, val1.value(), val2.value());
+		}
+	}, expr);
+}
+
+} // namespace compiler_skeleton::sysy
@@ -0,0 +1,73 @@
+#ifndef SKELETON_CONST_EVAL_H
+#define SKELETON_CONST_EVAL_H
+
+/*
+ * Compile-time evaluation of constant expressions, on the SysY AST and on
+ * Eeyore statements.
+ *
+ * Arithmetic follows the target: ints are 32-bit and wrap around on overflow,
+ * division truncates toward zero, and INT_MIN / -1 wraps to INT_MIN (with
+ * INT_MIN % -1 being 0). Division or modulo by zero is never folded.
+ *
+ * On the AST, a constant is a number, a const scalar, an element of a const
+ * array with constant indices (within bounds), or an operator on constants.
+ * Names are resolved through a ConstScope, which semantic analysis implements
+ * with its symbol tables.
+ *
+ * On Eeyore, `fold_constants' rewrites the statements whose operands are all
+ * immediates: UnaryOpStmt and BinaryOpStmt become MoveStmt, and CondGotoStmt
+ * becomes GotoStmt or disappears. It can be used as a pass of EeyoreStream.
+ *
+ * Example:
+ *     using namespace compiler_skeleton;
+ *     auto val = sysy::eval_const(*dim, scope); // std::nullopt if not constant
+ *     eeyore::fold_constants(func_stmts);
+ */
+
+#include <cstddef>
+#include <optional>
+#include "symbol.h"
+#include "sysy_type.h"
+#include "eeyore.h"
+#include "ast.h"
+
+namespace compiler_skeleton::eeyore
+{
+
+std::optional<int> eval_unary(UnaryOp op, int val);
+std::optional<int> eval_binary(BinaryOp op, int val1, int val2);
+
+// Fold `stmt' in place if all its operands are immediates. Returns false if
+// the statement should be removed (a CondGotoStmt that is never taken).
+bool fold_stmt(EeyoreStatement &stmt);
+// Fold all the statements, removing the dead ones. Returns the number of
+// statements changed or removed.
+size_t fold_constants(EeyoreStmtVec &stmts);
+
+} // namespace compiler_skeleton::eeyore
+
+namespace compiler_skeleton::sysy
+{
+
+// What the evaluator needs to know about a name. Only names of const types
+// are constants.
+struct ConstValue
+{
+	TypePtr type;
+	std::optional<int> scalar; // of const scalars
+	const eeyore::InitData *data; // of const arrays, nullptr if all zero
+};
+
+class ConstScope
+{
+  public:
+	virtual ~ConstScope() = default;
+	// nullptr if `name' is not declared.
+	virtual const ConstValue *lookup_const(utils::Symbol name) const = 0;
+};
+
+std::optional<int> eval_const(const Expr &expr, const ConstScope &scope);
+
+} // namespace compiler_skeleton::sysy
+
+#endif
@@ -0,0 +1,763 @@
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "lambda_visitor.h"
+#include "profiler.h"
+#include "bitmap.h"
+#include "cfg.h"
+#include "const_eval.h"
+#include "copy_prop.h"
+
+namespace
+{
+
+compiler_skeleton::utils::Statistic copies_propagated("copy prop", "uses replaced by copies");
+compiler_skeleton::utils::Statistic dead_stmts("copy prop", "dead statements removed");
+compiler_skeleton::utils::Statistic dead_results("copy prop", "dead call results dropped");
+
+} // namespace
+
+namespace compiler_skeleton::eeyore
+{
+
+namespace
+{
+
+using utils::Bitmap;
+
+// Call `fn(begin, end)' on each function [begin, end) of `stmts'.
+template<class Fn>
+void for_each_func(EeyoreStmtVec &stmts, Fn &&fn)
+{
+	for(size_t begin = 0; begin < stmts.size(); begin++)
+	{
+		if(!std::holds_alternative<FuncDefStmt>(stmts[begin]))
+			continue;
+		size_t end = begin + 1;
+		while(!std::holds_alternative<EndFuncDefStmt>(stmts[end]))
+			end++;
+		fn(begin, end + 1);
+		begin = end;
+	}
+}
+
+// Erase the statements marked in `removed'.
+void compact(EeyoreStmtVec &stmts, const std::vector<bool> &removed)
+{
+	size_t out = 0;
+	for(size_t i = 0; i < stmts.size(); i++)
+	{
+		if(removed[i])
+			continue;
+		if(out != i)
+			stmts[out] = std::move(stmts[i]);
+		out++;
+	}
+	stmts.erase(stmts.begin() + out, stmts.end());
+}
+
+inline uint32_t id_of(const Operand &opr)
+{
+	return std::visit(utils::LambdaVisitor
+	{
+		[](int val) { return static_cast<uint32_t>(val); },
+		[](const VarBase &var) { return static_cast<uint32_t>(var.id); }
+	}, opr);
+}
+
+// The variables a statement writes. Unlike `defined_vars', this counts the
+// result of a call, and not the declarations.
+void defs_of(const EeyoreStatement &stmt, std::vector<Operand> &oprs)
+{
+	if(auto call = std::get_if<FuncCallStmt>(&stmt))
+	{
+		oprs.clear();
+		if(call->retval_receiver)
+			oprs.push_back(*call->retval_receiver);
+	}
+	else if(std::holds_alternative<DeclStmt>(stmt))
+		oprs.clear();
+	else
+		defined_vars(stmt, oprs);
+}
+
+// Call `fn(opr, imm_ok)' on the operands `stmt' reads, where `imm_ok' tells
+// whether an immediate may take the place of `opr'.
+template<class Fn>
+void for_each_use(EeyoreStatement &stmt, Fn &&fn)
+{
+	std::visit(utils::LambdaVisitor
+	{
+		[&](ParamStmt &s) { fn(s.param, true); },
+		[&](RetStmt &s)
+		{
+			if(s.retval)
+				fn(*s.retval, true);
+		},
+		[&](CondGotoStmt &s) { fn(s.opr1, true); fn(s.opr2, true); },
+		[&](UnaryOpStmt &s) { fn(s.opr1, true); },
+		[&](BinaryOpStmt &s) { fn(s.opr1, true); fn(s.opr2, true); },
+		[&](MoveStmt &s) { fn(s.opr1, true); },
+		[&](ReadArrStmt &s) { fn(s.arr_opr, false); fn(s.idx_opr, true); },
+		[&](WriteArrStmt &s) { fn(s.arr_opr, false); fn(s.idx_opr, true); fn(s.opr, true); },
+		[](auto &s) {}
+	}, stmt);
+}
+
+// The numbers of the variables of the function being worked on, by kind and
+// id. Entries are stamped with the function, so that the tables are reused
+// across functions without being cleared.
+class VarIds
+{
+  protected:
+	struct Entry
+	{
+		unsigned stamp;
+		int var;
+	};
+	std::vector<Entry> _tables[std::variant_size_v<Operand>];
+	unsigned _stamp = 0;
+
+  public:
+	void next_func() { _stamp++; }
+	// -1 for immediates and unknown variables.
+	int find(const Operand &opr) const
+	{
+		const auto &table = _tables[opr.index()];
+		uint32_t id = id_of(opr);
+		if(std::holds_alternative<int>(opr) || id >= table.size() || table[id].stamp != _stamp)
+			return -1;
+		return table[id].var;
+	}
+	// The number of `opr', which is `var' if it has none yet.
+	int add(const Operand &opr, int var)
+	{
+		auto &table = _tables[opr.index()];
+		uint32_t id = id_of(opr);
+		if(id >= table.size())
+			table.resize(id + 1, Entry{0, -1});
+		if(table[id].stamp != _stamp)
+			table[id] = Entry{_stamp, var};
+		return table[id].var;
+	}
+};
+
+// The variables of a function, numbered densely, and the numbers of those
+// each statement reads and writes (at most one), by statement index from the
+// FuncDefStmt.
+class FuncVars
+{
+  protected:
+	VarIds &_ids;
+	std::vector<bool> _local_arr;
+	Bitmap _globals;
+	std::vector<int> _def; // -1 if none
+	std::vector<int> _use_begin, _uses; // the uses of statement i are from _use_begin[i]
+
+	int _add(const Operand &opr);
+
+  public:
+	// [begin, end) is a whole function. `ids' is taken over until the next
+	// function.
+	FuncVars(VarIds &ids, const EeyoreStatement *begin, const EeyoreStatement *end);
+
+	int cnt() const { return static_cast<int>(_local_arr.size()); }
+	// -1 for immediates.
+	int find(const Operand &opr) const { return _ids.find(opr); }
+	bool is_global(int var) const { return _globals.get(var); }
+	bool is_local_arr(int var) const { return _local_arr[var]; }
+	const Bitmap &globals() const { return _globals; }
+
+	int def_of(int stmt) const { return _def[stmt]; }
+	void clear_def(int stmt) { _def[stmt] = -1; }
+	const int *uses_begin(int stmt) const { return _uses.data() + _use_begin[stmt]; }
+	const int *uses_end(int stmt) const { return _uses.data() + _use_begin[stmt + 1]; }
+};
+
+int FuncVars::_add(const Operand &opr)
+{
+	int var = _ids.add(opr, cnt());
+	if(var == cnt())
+		_local_arr.push_back(false);
+	return var;
+}
+
+FuncVars::FuncVars(VarIds &ids, const EeyoreStatement *begin, const EeyoreStatement *end)
+  : _ids(ids)
+{
+	_ids.next_func();
+	// Declared variables first, so that the others are known to be globals.
+	for(auto stmt = begin; stmt != end; stmt++)
+		if(auto decl = std::get_if<DeclStmt>(stmt))
+			_local_arr[_add(decl->var)] = decl->is_arr;
+	int local_cnt = cnt();
+	std::vector<int> globals;
+	std::vector<Operand> oprs;
+	auto add = [&](const Operand &opr)
+	{
+		int var = _add(opr);
+		if(var >= local_cnt && std::holds_alternative<OrigVar>(opr))
+			globals.push_back(var);
+		return var;
+	};
+	_def.reserve(end - begin);
+	_use_begin.reserve(end - begin + 1);
+	for(auto stmt = begin; stmt != end; stmt++)
+	{
+		_use_begin.push_back(static_cast<int>(_uses.size()));
+		used_vars(*stmt, oprs);
+		for(const auto &opr : oprs)
+			_uses.push_back(add(opr));
+		defs_of(*stmt, oprs);
+		_def.push_back(oprs.empty()? -1 : add(oprs[0]));
+	}
+	_use_begin.push_back(static_cast<int>(_uses.size()));
+
+	_globals = Bitmap(cnt());
+	for(int var : globals)
+		_globals.set(var);
+}
+
+class CopyPropagation
+{
+  protected:
+	EeyoreStatement *_func;
+	std::vector<bool>::iterator _removed; // of the statements of the function
+	FuncVars _vars;
+	CFG _cfg;
+	std::vector<bool> _reachable;
+
+	// The copies `dst = src' made by MoveStmts, with an immediate or a
+	// variable as the source.
+	struct Copy
+	{
+		int dst;
+		Operand src;
+	};
+	std::vector<Copy> _copies;
+	std::unordered_map<uint64_t, int> _copy_idx;
+	std::vector<int> _copy_at; // by statement, -1 if none
+	std::vector<std::vector<int>> _copies_to; // by destination
+	std::vector<std::vector<int>> _copies_of; // by destination or source
+	Bitmap _all, _global_copies;
+	std::vector<Bitmap> _gen, _kill, _out; // by block
+	size_t _replaced = 0;
+
+	// The index of the copy made by `stmt', or -1.
+	int _add_copy(const EeyoreStatement &stmt);
+	// Find the copies, each with its source resolved through the copies
+	// made before it in its block, and rewrite the MoveStmts to match.
+	void _find_copies();
+	// Apply the statement at `idx', as it was when the copies were found, to
+	// the available copies `avail', and record the copies it kills in `kill'
+	// if given.
+	void _transfer(int idx, Bitmap &avail, Bitmap *kill);
+	void _in_of(int block, Bitmap &in) const;
+	// The operand with the value of `opr', following the available copies.
+	Operand _resolve(const Operand &opr, const Bitmap &avail, bool imm_ok) const;
+
+  public:
+	// [begin, end) is a whole function.
+	CopyPropagation(VarIds &ids, EeyoreStatement *begin, EeyoreStatement *end,
+		std::vector<bool>::iterator removed);
+
+	size_t run();
+};
+
+CopyPropagation::CopyPropagation(VarIds &ids, EeyoreStatement *begin, EeyoreStatement *end,
+	std::vector<bool>::iterator removed)
+  : _func(begin), _removed(removed), _vars(ids, begin, end), _cfg(begin, end),
+	_reachable(_cfg.block_cnt(), false), _copies_to(_vars.cnt()), _copies_of(_vars.cnt())
+{
+	for(int block : _cfg.rpo())
+		_reachable[block] = true;
+	_copy_at.assign(end - begin, -1);
+	_find_copies();
+
+	_all = Bitmap(_copies.size());
+	_global_copies = Bitmap(_copies.size());
+	for(size_t copy = 0; copy < _copies.size(); copy++)
+	{
+		_all.set(copy);
+		int src = _vars.find(_copies[copy].src);
+		if(_vars.is_global(_copies[copy].dst) || (src >= 0 && _vars.is_global(src)))
+			_global_copies.set(copy);
+	}
+}
+
+int CopyPropagation::_add_copy(const EeyoreStatement &stmt)
+{
+	auto move = std::get_if<MoveStmt>(&stmt);
+	if(move == nullptr)
+		return -1;
+	int dst = _vars.find(move->opr), src = _vars.find(move->opr1);
+	if(dst == src)
+		return -1;
+	// Tell immediates from variables in the key.
+	uint64_t key = static_cast<uint64_t>(dst) << 33
+		| static_cast<uint64_t>(src >= 0) << 32 | (src >= 0? src : id_of(move->opr1));
+	auto [iter, added] = _copy_idx.emplace(key, static_cast<int>(_copies.size()));
+	if(added)
+	{
+		_copies.push_back(Copy{dst, move->opr1});
+		_copies_to[dst].push_back(iter->second);
+		_copies_of[dst].push_back(iter->second);
+		if(src >= 0)
+			_copies_of[src].push_back(iter->second);
+	}
+	return iter->second;
+}
+
+void CopyPropagation::_find_copies()
+{
+	// The copy a variable holds in the block being walked. It is valid while
+	// its source keeps the version it had, and no call came in between if
+	// either side is a global; a write of the variable itself drops it.
+	struct Held
+	{
+		int block, copy;
+		unsigned src_version, calls;
+	};
+	std::vector<Held> held(_vars.cnt(), Held{-1, -1, 0, 0});
+	std::vector<unsigned> version(_vars.cnt(), 0);
+	unsigned calls = 0;
+	auto source_of = [&](int var, int block) -> const Operand *
+	{
+		const Held &h = held[var];
+		if(h.block != block)
+			return nullptr;
+		int src = _vars.find(_copies[h.copy].src);
+		if(src >= 0 && version[src] != h.src_version)
+			return nullptr;
+		if(h.calls != calls && (_vars.is_global(var) || (src >= 0 && _vars.is_global(src))))
+			return nullptr;
+		return &_copies[h.copy].src;
+	};
+
+	for(int block = 0; block < _cfg.block_cnt(); block++)
+	{
+		const auto &bb = _cfg.block(block);
+		for(int i = bb.begin; i < bb.end; i++)
+		{
+			EeyoreStatement &stmt = _func[i];
+			if(auto move = std::get_if<MoveStmt>(&stmt))
+			{
+				// So `t2 = t1' after `t1 = T0' is the copy `t2 = T0', which
+				// writes to T0 kill, and a use of t2 takes one step.
+				int src = _vars.find(move->opr1);
+				if(const Operand *res = src >= 0? source_of(src, block) : nullptr)
+				{
+					move->opr1 = *res;
+					_replaced++;
+				}
+				_copy_at[i] = _add_copy(stmt);
+			}
+			if(std::holds_alternative<FuncCallStmt>(stmt))
+				calls++;
+			if(int def = _vars.def_of(i); def >= 0)
+			{
+				version[def]++;
+				held[def].block = -1;
+			}
+			if(int copy = _copy_at[i]; copy >= 0)
+			{
+				int src = _vars.find(_copies[copy].src);
+				held[_copies[copy].dst] = Held{block, copy, src >= 0? version[src] : 0, calls};
+			}
+		}
+	}
+}
+
+void CopyPropagation::_transfer(int idx, Bitmap &avail, Bitmap *kill)
+{
+	// Rewriting the uses leaves the variables written as they were.
+	const EeyoreStatement &stmt = _func[idx];
+	if(std::holds_alternative<FuncCallStmt>(stmt))
+	{
+		// The callee may write any global.
+		avail.diff_with(_global_copies);
+		if(kill != nullptr)
+			kill->union_with(_global_copies);
+	}
+	if(int def = _vars.def_of(idx); def >= 0)
+		for(int copy : _copies_of[def])
+		{
+			avail.reset(copy);
+			if(kill != nullptr)
+				kill->set(copy);
+		}
+	if(_copy_at[idx] >= 0)
+		avail.set(_copy_at[idx]);
+}
+
+void CopyPropagation::_in_of(int block, Bitmap &in) const
+{
+	if(block == 0 || !_reachable[block])
+	{
+		in.clear();
+		return;
+	}
+	// Unreachable predecessors keep everything, which changes nothing.
+	in = _all;
+	for(int pred : _cfg.block(block).preds)
+		in.intersect_with(_out[pred]);
+}
+
+Operand CopyPropagation::_resolve(const Operand &opr, const Bitmap &avail, bool imm_ok) const
+{
+	// A copy kills the copies of its destination, so the available ones
+	// cannot form a cycle. The sources are resolved within blocks, so a chain
+	// takes a step per block it crosses; the bound is only a safeguard.
+	Operand res = opr;
+	for(int step = 0; step < _vars.cnt(); step++)
+	{
+		int var = _vars.find(res), from = -1;
+		if(var < 0)
+			break;
+		for(int copy : _copies_to[var])
+			if(avail.get(copy))
+			{
+				from = copy;
+				break;
+			}
+		if(from < 0 || (!imm_ok && std::holds_alternative<int>(_copies[from].src)))
+			break;
+		res = _copies[from].src;
+	}
+	return res;
+}
+
+size_t CopyPropagation::run()
+{
+	if(_copies.empty())
+		return _replaced;
+	int block_cnt = _cfg.block_cnt();
+	_gen.assign(block_cnt, Bitmap(_copies.size()));
+	_kill.assign(block_cnt, Bitmap(_copies.size()));
+	_out.assign(block_cnt, _all);
+	for(int block = 0; block < block_cnt; block++)
+	{
+		const auto &bb = _cfg.block(block);
+		for(int i = bb.begin; i < bb.end; i++)
+			_transfer(i, _gen[block], &_kill[block]);
+	}
+
+	// The copies made on all paths to a point, iterated to the greatest
+	// fixed point.
+	Bitmap avail(_copies.size());
+	for(bool changed = true; changed; )
+	{
+		changed = false;
+		for(int block : _cfg.rpo())
+		{
+			_in_of(block, avail);
+			avail.diff_with(_kill[block]);
+			avail.union_with(_gen[block]);
+			if(avail != _out[block])
+			{
+				_out[block] = avail;
+				changed = true;
+			}
+		}
+	}
+
+	size_t replaced = _replaced;
+	for(int block = 0; block < block_cnt; block++)
+	{
+		const auto &bb = _cfg.block(block);
+		_in_of(block, avail);
+		for(int i = bb.begin; i < bb.end; i++)
+		{
+			EeyoreStatement &stmt = _func[i];
+			bool changed = false;
+			for_each_use(stmt, [&](Operand &opr, bool imm_ok)
+			{
+				Operand src = _resolve(opr, avail, imm_ok);
+				if(!(src == opr))
+				{
+					opr = src;
+					changed = true;
+					replaced++;
+				}
+			});
+			// A CondGotoStmt never taken only loses an edge of the CFG, which
+			// leaves more copies available, not fewer.
+			if(changed && !fold_stmt(stmt))
+				_removed[i] = true;
+			// The values do not change, so the copies made are still those of
+			// the statement as it was.
+			_transfer(i, avail, nullptr);
+		}
+	}
+	return replaced;
+}
+
+// Whether `stmt' has no effect but its result.
+inline bool is_pure(const EeyoreStatement &stmt)
+{
+	return std::holds_alternative<MoveStmt>(stmt) || std::holds_alternative<UnaryOpStmt>(stmt)
+		|| std::holds_alternative<BinaryOpStmt>(stmt) || std::holds_alternative<ReadArrStmt>(stmt);
+}
+
+class DeadCode
+{
+  protected:
+	EeyoreStatement *_func, *_end;
+	std::vector<bool>::iterator _removed; // of the statements of the function
+	FuncVars _vars;
+	CFG _cfg;
+	std::vector<int> _order; // postorder, then the unreachable blocks
+	std::vector<Bitmap> _live_in, _live_out; // by block
+	size_t _changed = 0;
+
+	// Whether the statement at `idx' is needed, with `live' live after it.
+	bool _is_needed(int idx, const Bitmap &live) const;
+	// Apply the statement at `idx' backward to the live variables `live'.
+	void _transfer(int idx, Bitmap &live) const;
+	void _compute_liveness();
+	// Remove the statements that are not needed, and the dead results of
+	// calls. Returns the number of statements removed.
+	size_t _sweep();
+	// Returns the number of statements removed.
+	size_t _remove_dead_stores();
+	void _remove_unused_decls();
+
+  public:
+	// [begin, end) is a whole function.
+	DeadCode(VarIds &ids, EeyoreStatement *begin, EeyoreStatement *end,
+		std::vector<bool>::iterator removed);
+
+	size_t run();
+};
+
+DeadCode::DeadCode(VarIds &ids, EeyoreStatement *begin, EeyoreStatement *end,
+	std::vector<bool>::iterator removed)
+  : _func(begin), _end(end), _removed(removed), _vars(ids, begin, end), _cfg(begin, end)
+{
+	_order.assign(_cfg.rpo().rbegin(), _cfg.rpo().rend());
+	std::vector<bool> reachable(_cfg.block_cnt(), false);
+	for(int block : _order)
+		reachable[block] = true;
+	for(int block = _cfg.block_cnt() - 1; block >= 0; block--)
+		if(!reachable[block])
+			_order.push_back(block);
+}
+
+bool DeadCode::_is_needed(int idx, const Bitmap &live) const
+{
+	const auto &stmt = _func[idx];
+	if(!is_pure(stmt))
+		return true;
+	auto move = std::get_if<MoveStmt>(&stmt);
+	return live.get(_vars.def_of(idx)) && (move == nullptr || !(move->opr == move->opr1));
+}
+
+void DeadCode::_transfer(int idx, Bitmap &live) const
+{
+	// A statement that is not needed reads nothing, so whatever only feeds
+	// such statements is not needed either (e.g. a counter nothing else
+	// reads), without another round.
+	if(_removed[idx] || !_is_needed(idx, live))
+		return;
+	if(int def = _vars.def_of(idx); def >= 0)
+		live.reset(def);
+	for(auto use = _vars.uses_begin(idx); use != _vars.uses_end(idx); use++)
+		live.set(*use);
+	// The callee, or the caller after a return, may read any global.
+	const auto &stmt = _func[idx];
+	if(std::holds_alternative<FuncCallStmt>(stmt) || std::holds_alternative<RetStmt>(stmt))
+		live.union_with(_vars.globals());
+}
+
+void DeadCode::_compute_liveness()
+{
+	int block_cnt = _cfg.block_cnt();
+	_live_in.assign(block_cnt, Bitmap(_vars.cnt()));
+	_live_out.assign(block_cnt, Bitmap(_vars.cnt()));
+	Bitmap live(_vars.cnt());
+	// The transfer is not a fixed gen and kill, so blocks are walked on every
+	// round. Liveness only grows, up to the least fixed point.
+	for(bool changed = true; changed; )
+	{
+		changed = false;
+		for(int block : _order)
+		{
+			const auto &bb = _cfg.block(block);
+			// Falling off the end returns as well.
+			if(bb.succs.empty())
+				live = _vars.globals();
+			else
+				live.clear();
+			for(int succ : bb.succs)
+				live.union_with(_live_in[succ]);
+			_live_out[block] = live;
+			for(int i = bb.end - 1; i >= bb.begin; i--)
+				_transfer(i, live);
+			if(live != _live_in[block])
+			{
+				_live_in[block] = live;
+				changed = true;
+			}
+		}
+	}
+}
+
+size_t DeadCode::_sweep()
+{
+	size_t removed = 0;
+	Bitmap live(_vars.cnt());
+	for(int block = 0; block < _cfg.block_cnt(); block++)
+	{
+		const auto &bb = _cfg.block(block);
+		live = _live_out[block];
+		for(int i = bb.end - 1; i >= bb.begin; i--)
+		{
+			if(_removed[i])
+				continue;
+			if(!_is_needed(i, live))
+			{
+				_removed[i] = true;
+				removed++;
+				continue;
+			}
+			auto call = std::get_if<FuncCallStmt>(&_func[i]);
+			if(call != nullptr && call->retval_receiver && !live.get(_vars.def_of(i)))
+			{
+				call->retval_receiver.reset();
+				_vars.clear_def(i);
+				++dead_results;
+				_changed++;
+			}
+			_transfer(i, live);
+		}
+	}
+	return removed;
+}
+
+size_t DeadCode::_remove_dead_stores()
+{
+	// A local array is read if it is used other than as the array of a store.
+	Bitmap read(_vars.cnt());
+	for(int i = 0; i < _end - _func; i++)
+	{
+		if(_removed[i])
+			continue;
+		if(auto write = std::get_if<WriteArrStmt>(&_func[i]))
+		{
+			for(const Operand *opr : {&write->idx_opr, &write->opr})
+				if(int var = _vars.find(*opr); var >= 0)
+					read.set(var);
+			continue;
+		}
+		for(auto use = _vars.uses_begin(i); use != _vars.uses_end(i); use++)
+			read.set(*use);
+	}
+
+	size_t removed = 0;
+	for(int i = 0; i < _end - _func; i++)
+		if(auto write = std::get_if<WriteArrStmt>(&_func[i]); write != nullptr && !_removed[i])
+		{
+			int arr = _vars.find(write->arr_opr);
+			if(_vars.is_local_arr(arr) && !read.get(arr))
+			{
+				_removed[i] = true;
+				removed++;
+			}
+		}
+	return removed;
+}
+
+void DeadCode::_remove_unused_decls()
+{
+	Bitmap used(_vars.cnt());
+	for(int i = 0; i < _end - _func; i++)
+	{
+		if(_removed[i])
+			continue;
+		for(auto use = _vars.uses_begin(i); use != _vars.uses_end(i); use++)
+			used.set(*use);
+		if(int def = _vars.def_of(i); def >= 0)
+			used.set(def);
+	}
+
+	for(int i = 0; i < _end - _func; i++)
+		if(auto decl = std::get_if<DeclStmt>(&_func[i]); decl != nullptr && !used.get(_vars.find(decl->var)))
+		{
+			_removed[i] = true;
+			++dead_stmts;
+			_changed++;
+		}
+}
+
+size_t DeadCode::run()
+{
+	// Removing the reads of a local array may leave the stores to it dead,
+	// and removing the stores may leave their operands dead.
+	for(size_t removed = 1; removed > 0; )
+	{
+		_compute_liveness();
+		removed = _sweep();
+		removed += _remove_dead_stores();
+		dead_stmts += removed;
+		_changed += removed;
+	}
+	_remove_unused_decls();
+	return _changed;
+}
+
+} // namespace
+
+size_t propagate_copies(EeyoreStmtVec &stmts)
+{
+	utils::ScopedTimer timer("propagate copies");
+	size_t replaced = 0;
+	std::vector<bool> removed(stmts.size(), false);
+	VarIds ids;
+	for_each_func(stmts, [&](size_t begin, size_t end)
+	{
+		CopyPropagation prop(ids, stmts.data() + begin, stmts.data() + end, removed.begin() + begin);
+		replaced += prop.run();
+	});
+	compact(stmts, removed);
+	copies_propagated += replaced;
+	return replaced;
+}
+
+size_t remove_dead_code(EeyoreStmtVec &stmts)
+{
+	utils::ScopedTimer timer("remove dead code");
+	size_t changed = 0;
+	std::vector<bool> removed(stmts.size(), false);
+	VarIds ids;
+	for_each_func(stmts, [&](size_t begin, size_t end)
+	{
+		DeadCode dce(ids, stmts.data() + begin, stmts.data() + end, removed.begin() + begin);
+		changed += dce.run();
+	});
+	compact(stmts, removed);
+	return changed;
+}
+
+size_t simplify_copies(EeyoreStmtVec &stmts)
+{
+	utils::ScopedTimer timer("simplify copies");
+	size_t changed = 0;
+	// Removed statements may let more copies through, and folding in
+	// `propagate_copies' may remove paths and make new copies, so it may find
+	// more after either. `remove_dead_code' finds all it can at once, so only
+	// replaced uses give it more to do. Both come to an end, as the uses only
+	// get resolved further and folded statements do not come back.
+	for(bool first = true; ; first = false)
+	{
+		size_t replaced = propagate_copies(stmts);
+		if(replaced == 0 && !first)
+			break;
+		size_t removed = remove_dead_code(stmts);
+		changed += replaced + removed;
+		if(replaced == 0 && removed == 0)
+			break;
+	}
+	return changed;
+}
+
+} // namespace compiler_skeleton::eeyore
@@ -0,0 +1,58 @@
+#ifndef SKELETON_COPY_PROP_H
+#define SKELETON_COPY_PROP_H
+
+/*
+ * Copy propagation and dead code elimination on Eeyore, for the MoveStmt
+ * chains (`t1 = T0', `t2 = t1', `T3 = t2') and the unread temporaries that a
+ * straightforward lowering leaves behind.
+ *
+ *  + `propagate_copies' replaces each use of a variable by the source of the
+ *    copy it holds, following chains of copies, when the copy reaches the use
+ *    on every path (a forward dataflow over the CFG, see cfg.h). Copies of
+ *    immediates are propagated too, except into the array of a ReadArrStmt or
+ *    WriteArrStmt, and the statements left with immediates only are folded
+ *    (see const_eval.h).
+ *  + `remove_dead_code' removes the moves, operations and array reads whose
+ *    result is never read but by other such statements, and the self moves.
+ *    Liveness is computed without the uses of the statements being removed,
+ *    so a chain of dead statements goes at once, and so does a loop counter
+ *    nothing else reads. The dead result of a call is dropped, but the call
+ *    stays. Stores to a local array are removed if the array is never read
+ *    nor passed anywhere, and so are the declarations of the local variables
+ *    left unused.
+ *  + `simplify_copies' runs both until neither changes anything.
+ *
+ * Variables are T-, t- and p-type variables alike. A T-type variable that is
+ * not declared in the function is a global: a call may read or write it, and
+ * it is live when the function returns. Array elements are memory, not
+ * variables, so stores to them are only removed as said above; no copy is
+ * made of an element either.
+ *
+ * The statements may hold a whole program or single functions (e.g. as a
+ * pass of EeyoreStream). The passes insert no statements, and the block
+ * structure of the functions they change is not preserved (see analysis.h).
+ *
+ * Example:
+ *     using namespace compiler_skeleton::eeyore;
+ *     simplify_copies(program);
+ *     stream.add_pass([](EeyoreStmtVec &func) { simplify_copies(func); });
+ *     if(remove_dead_code(func))
+ *         am.invalidate(func_name, AnalysisManager::CFG);
+ */
+
+#include <cstddef>
+#include "eeyore.h"
+
+namespace compiler_skeleton::eeyore
+{
+
+// Returns the number of uses replaced.
+size_t propagate_copies(EeyoreStmtVec &stmts);
+// Returns the number of statements removed or changed.
+size_t remove_dead_code(EeyoreStmtVec &stmts);
+// Returns the number of uses replaced and statements removed or changed.
+size_t simplify_copies(EeyoreStmtVec &stmts);
+
+} // namespace compiler_skeleton::eeyore
+
+#endif
@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <cassert>
 #include "lambda_visitor.h"
 #include "eeyore.h"
 
@@ -6,17 +8,12 @@ using std::endl;
 namespace
 {
 
-std::vector<compiler_skeleton::eeyore::Operand> &
-remove_int_from_vec(std::vector<compiler_skeleton::eeyore::Operand> &oprs)
+// Append the operands that are variables (i.e. not ints) to `oprs'.
+template<class ...Oprs>
+inline void push_vars(std::vector<compiler_skeleton::eeyore::Operand> &oprs,
+	const Oprs &...var_oprs)
 {
-	for(auto iter = oprs.begin(); iter != oprs.end(); )
-	{
-		if(std::holds_alternative<int>(*iter))
-			iter = oprs.erase(iter);
-		else
-			++iter;
-	}
-	return oprs;
+	((std::holds_alternative<int>(var_oprs)? void() : oprs.push_back(var_oprs)), ...);
 }
 
 } // namespace
@@ -24,58 +21,98 @@ remove_int_from_vec(std::vector<compiler_skeleton::eeyore::Operand> &oprs)
 namespace compiler_skeleton::eeyore
 {
 
+void InitData::set(int offset, int val)
+{
+	assert(offset >= 0 && offset < word_cnt);
+	assert(runs.empty() || offset >= runs.back().offset + runs.back().len);
+	if(val == 0)
+		return;
+	int gap = runs.empty()? -1 : offset - (runs.back().offset + runs.back().len);
+	if(gap < 0 || gap > MAX_ZERO_GAP)
+		runs.push_back(Run{offset, 0, static_cast<int>(vals.size())});
+	else
+		vals.insert(vals.end(), gap, 0);
+	vals.push_back(val);
+	runs.back().len = offset - runs.back().offset + 1;
+}
+
+int InitData::get(int offset) const
+{
+	// The last run starting at or before `offset'.
+	auto run = std::upper_bound(runs.begin(), runs.end(), offset,
+		[](int offset, const Run &run) { return offset < run.offset; });
+	if(run == runs.begin())
+		return 0;
+	--run;
+	if(offset >= run->offset + run->len)
+		return 0;
+	return vals[run->val_idx + offset - run->offset];
+}
+
 std::vector<Operand> used_vars(const EeyoreStatement &stmt)
 {
-	using OperandVec = std::vector<Operand>;
-	static utils::LambdaVisitor used_opr_getter =
+	std::vector<Operand> used_oprs;
+	used_vars(stmt, used_oprs);
+	return used_oprs;
+}
+
+std::vector<Operand> defined_vars(const EeyoreStatement &stmt)
+{
+	std::vector<Operand> defined_oprs;
+	defined_vars(stmt, defined_oprs);
+	return defined_oprs;
+}
+
+void used_vars(const EeyoreStatement &stmt, std::vector<Operand> &oprs)
+{
+	utils::LambdaVisitor used_opr_getter =
 	{
-		[](const ParamStmt &stmt) { return OperandVec{stmt.param}; },
-		[](const RetStmt &stmt)
+		[&oprs](const ParamStmt &stmt) { push_vars(oprs, stmt.param); },
+		[&oprs](const RetStmt &stmt)
 		{
-			const auto &retval = stmt.retval;
-			return retval.has_value()? OperandVec{retval.value()} : OperandVec{};
+			if(stmt.retval.has_value())
+				push_vars(oprs, stmt.retval.value());
 		},
-		[](const CondGotoStmt &stmt) { return OperandVec{stmt.opr1, stmt.opr2}; },
-		[](const UnaryOpStmt &stmt) { return OperandVec{stmt.opr1}; },
-		[](const BinaryOpStmt &stmt) { return OperandVec{stmt.opr1, stmt.opr2}; },
-		[](const MoveStmt &stmt) { return OperandVec{stmt.opr1}; },
-		[](const ReadArrStmt &stmt) { return OperandVec{stmt.arr_opr, stmt.idx_opr}; },
-		[](const WriteArrStmt &stmt) { return OperandVec{stmt.opr, stmt.arr_opr, stmt.idx_opr}; },
+		[&oprs](const CondGotoStmt &stmt) { push_vars(oprs, stmt.opr1, stmt.opr2); },
+		[&oprs](const UnaryOpStmt &stmt) { push_vars(oprs, stmt.opr1); },
+		[&oprs](const BinaryOpStmt &stmt) { push_vars(oprs, stmt.opr1, stmt.opr2); },
+		[&oprs](const MoveStmt &stmt) { push_vars(oprs, stmt.opr1); },
+		[&oprs](const ReadArrStmt &stmt) { push_vars(oprs, stmt.arr_opr, stmt.idx_opr); },
+		[&oprs](const WriteArrStmt &stmt)
+			{ push_vars(oprs, stmt.opr, stmt.arr_opr, stmt.idx_opr); },
 		[](const FuncCallStmt &stmt)
 		{
 			// This is intended. A function use all the variable in its body,
 			// but we do not know what is actually used here in this function.
 			// You should add the variables used after calling `used_vars', or
 			// implement this case by passing some other arguments to `used_vars'.
-			return OperandVec{};
 		},
-		[](const auto &stmt) { return OperandVec{}; }
+		[](const auto &stmt) {}
 	};
 
-	OperandVec used_oprs = std::visit(used_opr_getter, stmt); 
-	return remove_int_from_vec(used_oprs);
+	oprs.clear();
+	std::visit(used_opr_getter, stmt);
 }
 
-std::vector<Operand> defined_vars(const EeyoreStatement &stmt)
+void defined_vars(const EeyoreStatement &stmt, std::vector<Operand> &oprs)
 {
-	using OperandVec = std::vector<Operand>;
-	static utils::LambdaVisitor defined_opr_getter =
+	utils::LambdaVisitor defined_opr_getter =
 	{
-		[](const DeclStmt &stmt) { return OperandVec{stmt.var}; },
-		[](const UnaryOpStmt &stmt) { return OperandVec{stmt.opr}; },
-		[](const BinaryOpStmt &stmt) { return OperandVec{stmt.opr}; },
-		[](const MoveStmt &stmt) { return OperandVec{stmt.opr}; },
+		[&oprs](const DeclStmt &stmt) { push_vars(oprs, stmt.var); },
+		[&oprs](const UnaryOpStmt &stmt) { push_vars(oprs, stmt.opr); },
+		[&oprs](const BinaryOpStmt &stmt) { push_vars(oprs, stmt.opr); },
+		[&oprs](const MoveStmt &stmt) { push_vars(oprs, stmt.opr); },
+		[&oprs](const ReadArrStmt &stmt) { push_vars(oprs, stmt.opr); },
 		[](const FuncCallStmt &stmt)
 		{
 			// This is intended. See the comment in the case of FuncCallStmt
 			// in function `used_vars'.
-			return OperandVec{};
 		},
-		[](const auto &stmt) { return OperandVec{}; }
+		[](const auto &stmt) {}
 	};
 
-	OperandVec defined_oprs = std::visit(defined_opr_getter, stmt);
-	return remove_int_from_vec(defined_oprs);
+	oprs.clear();
+	std::visit(defined_opr_getter, stmt);
 }
 
 void OprPrinter::operator() (const OrigVar &var)
@@ -103,24 +140,27 @@ void EeyorePrinter::operator() (const DeclStmt &stmt)
 	_print_indent();
 	_out << "var ";
 	// for original variable, it may have a size
-	if(std::holds_alternative<OrigVar>(stmt.var))
-	{
-		OrigVar var = std::get<OrigVar>(stmt.var);
-		if(var.size != 4)
-			_out << var.size << ' ';
-	}
+	if(stmt.is_arr)
+		_out << std::get<OrigVar>(stmt.var).size << ' ';
 	_out << stmt.var << endl;
+	// Globals start as zeros, so only the other words are initialized.
+	if(stmt.init != nullptr)
+		stmt.init->for_each_nonzero([&](int offset, int val)
+		{
+			_print_indent();
+			_out << stmt.var << '[' << offset * 4 << "] = " << val << endl;
+		});
 }
 
 void EeyorePrinter::operator() (const FuncDefStmt &stmt)
 {
-	_out << stmt.func_name << " [" << stmt.arg_cnt << ']' << endl;
+	_out << "f_" << stmt.func_name << " [" << stmt.arg_cnt << ']' << endl;
 	_indent = true;
 }
 
 void EeyorePrinter::operator() (const EndFuncDefStmt &stmt)
 {
-	_out << "end " << stmt.func_name << endl;
+	_out << "end f_" << stmt.func_name << endl;
 	_indent = false;
 }
 
@@ -135,7 +175,7 @@ void EeyorePrinter::operator() (const FuncCallStmt &stmt)
 	_print_indent();
 	if(stmt.retval_receiver.has_value())
 		_out << stmt.retval_receiver.value() << " = ";
-	_out << "call " << stmt.func_name << endl;
+	_out << "call f_" << stmt.func_name << endl;
 }
 
 void EeyorePrinter::operator() (const RetStmt &stmt)
@@ -245,6 +285,22 @@ std::ostream &operator << (std::ostream &out, const compiler_skeleton::eeyore::E
 	return out;
 }
 
+std::ostream &operator << (std::ostream &out, const compiler_skeleton::eeyore::InitData &data)
+{
+	out << '{';
+	int next_offset = 0;
+	const int *val = data.vals.data();
+	for(const auto &run : data.runs)
+	{
+		if(run.offset > next_offset)
+			out << (next_offset > 0? ", " : "") << "zero " << run.offset - next_offset;
+		for(int i = 0; i < run.len; i++)
+			out << (run.offset + i > 0? ", " : "") << *val++;
+		next_offset = run.offset + run.len;
+	}
+	return out << '}';
+}
+
 /*
 
 Test case (also serve as an example):
@@ -254,7 +310,7 @@ int main()
 	using namespace compiler_skeleton::eeyore;
 	std::vector<EeyoreStatement> stmts;
 	stmts.push_back(DeclStmt(OrigVar(0)));
-	stmts.push_back(DeclStmt(OrigVar(1, 40)));
+	stmts.push_back(DeclStmt(OrigVar(1, 40), true));
 	stmts.push_back(FuncDefStmt("main", 0));
 	stmts.push_back(DeclStmt(OrigVar(2)));
 	stmts.push_back(DeclStmt(OrigVar(3)));
@@ -273,4 +329,4 @@ int main()
 	return 0;
 }
 
-*/
\ No newline at end of file
+*/
@@ -2,10 +2,13 @@
 #define SKELETON_EEYORE_H
 
 #include <iostream>
+#include <memory_resource>
 #include <string>
 #include <vector>
 #include <variant>
 #include <optional>
+#include "profiler.h"
+#include "symbol.h"
 
 namespace compiler_skeleton::eeyore
 {
@@ -50,30 +53,83 @@ enum class BinaryOp
 	ADD, SUB, MUL, DIV, MOD, OR, AND, GT, LT, GE, LE, EQ, NE
 };
 
+// The initial data of a global array, in words, with zero spans run-length
+// encoded: only runs of stored words are kept, and every other word is zero.
+// Short zero gaps (up to MAX_ZERO_GAP words) are kept inside a run, since a
+// new run costs more than a few zeros.
+//
+// Eeyore and Tigger have no syntax for it, so the text printers emit standard
+// code instead: Eeyore initializations after the declaration, and stores at
+// the start of f_main in Tigger. The RISC-V emitter puts the data in .data.
+// `operator <<' shows the data itself as e.g. "{1, 2, zero 97, 3}", with
+// trailing zeros left out, which is only meant for debugging.
+//
+// Like other IR, the data of a unit lives in its arena. Statements only keep
+// pointers to it, so copying them does not copy the data.
+struct InitData
+{
+	struct Run
+	{
+		int offset, len; // in words
+		int val_idx; // of the first word in `vals'
+	};
+
+	static constexpr int MAX_ZERO_GAP = 2;
+
+	int word_cnt;
+	std::pmr::vector<Run> runs; // sorted by offset, not overlapping
+	std::pmr::vector<int> vals; // of all the runs, in order
+
+	InitData(int _word_cnt, std::pmr::memory_resource *res)
+	  : word_cnt(_word_cnt), runs(res), vals(res) {}
+
+	// Set the word at `offset'. Offsets must be set in increasing order.
+	void set(int offset, int val);
+	// The word at `offset', which is 0 if it has not been set.
+	int get(int offset) const;
+	bool all_zero() const { return runs.empty(); }
+	// Call `fn(offset, val)' on each word that is not zero, in order.
+	template<class Fn>
+	void for_each_nonzero(Fn &&fn) const
+	{
+		for(const auto &run : runs)
+			for(int i = 0; i < run.len; i++)
+				if(int val = vals[run.val_idx + i]; val != 0)
+					fn(run.offset + i, val);
+	}
+};
+
 // Eeyore statements.
 
 struct DeclStmt
 {
 	Operand var;
-	
-	DeclStmt(Operand _var): var(_var) {}
+	bool is_arr; // of OrigVars; `var 4 T0' (int a[1]) is an array too
+	const InitData *init; // of global arrays only, nullptr if all zero
+
+	DeclStmt(Operand _var, const InitData *_init=nullptr)
+	  : var(_var), is_arr(false), init(_init) {}
+	DeclStmt(Operand _var, bool _is_arr, const InitData *_init=nullptr)
+	  : var(_var), is_arr(_is_arr), init(_init) {}
 };
 
+// Function names are the SysY names, e.g. "main"; the "f_" prefix is only
+// added when the statements are printed.
 struct FuncDefStmt
 {
-	std::string func_name;
+	utils::Symbol func_name;
 	int arg_cnt;
 
-	FuncDefStmt(std::string _func_name, int _arg_cnt)
-	  : func_name("f_" + _func_name), arg_cnt(_arg_cnt) {}
+	FuncDefStmt(utils::Symbol _func_name, int _arg_cnt)
+	  : func_name(_func_name), arg_cnt(_arg_cnt) {}
 };
 
 struct EndFuncDefStmt
 {
-	std::string func_name;
+	utils::Symbol func_name;
 
-	EndFuncDefStmt(std::string _func_name)
-	  : func_name("f_" + _func_name) {}
+	EndFuncDefStmt(utils::Symbol _func_name)
+	  : func_name(_func_name) {}
 };
 
 struct ParamStmt
@@ -85,14 +141,14 @@ struct ParamStmt
 
 struct FuncCallStmt
 {
-	std::string func_name;
+	utils::Symbol func_name;
 	std::optional<Operand> retval_receiver;
 
-	FuncCallStmt(std::string _func_name)
-	  : func_name("f_" + _func_name), retval_receiver(std::nullopt)
+	FuncCallStmt(utils::Symbol _func_name)
+	  : func_name(_func_name), retval_receiver(std::nullopt)
 	{}
-	FuncCallStmt(std::string _func_name, Operand _retval_receiver)
-	  : func_name("f_" + _func_name), retval_receiver(_retval_receiver)
+	FuncCallStmt(utils::Symbol _func_name, Operand _retval_receiver)
+	  : func_name(_func_name), retval_receiver(_retval_receiver)
 	{}
 };
 
@@ -192,9 +248,18 @@ using EeyoreStatement = std::variant
 	LabelStmt
 >;
 
+// A list of statements whose memory comes from a std::pmr resource, e.g. the
+// arena of the compilation unit.
+using EeyoreStmtVec = std::pmr::vector<EeyoreStatement>;
+
 std::vector<Operand> used_vars(const EeyoreStatement &stmt);
 std::vector<Operand> defined_vars(const EeyoreStatement &stmt);
 
+// Same as above, but write the result into `oprs' (clearing it first). Reusing
+// the same vector in a dataflow loop avoids allocating on every call.
+void used_vars(const EeyoreStatement &stmt, std::vector<Operand> &oprs);
+void defined_vars(const EeyoreStatement &stmt, std::vector<Operand> &oprs);
+
 
 // Printer classes
 
@@ -245,13 +310,17 @@ std::ostream &operator << (std::ostream &out, const compiler_skeleton::eeyore::U
 std::ostream &operator << (std::ostream &out, const compiler_skeleton::eeyore::BinaryOp &op);
 std::ostream &operator << (std::ostream &out, const compiler_skeleton::eeyore::Operand &opr);
 std::ostream &operator << (std::ostream &out, const compiler_skeleton::eeyore::EeyoreStatement &stmt);
+std::ostream &operator << (std::ostream &out, const compiler_skeleton::eeyore::InitData &data);
 
 // Printer of container (e.g. vector, list ...) of EeyoreStatements. Since
 // indents are kept in the printer, you may want to use this method instead of
 // printing statements one by one.
-template<template<class...> class Container>
-std::ostream &operator << (std::ostream &out, const Container<compiler_skeleton::eeyore::EeyoreStatement> &stmts)
+// For large programs, see eeyore_stream.h, which prints each function as soon
+// as it is complete instead.
+template<template<class...> class Container, class ...Ts>
+std::ostream &operator << (std::ostream &out, const Container<compiler_skeleton::eeyore::EeyoreStatement, Ts...> &stmts)
 {
+	compiler_skeleton::utils::ScopedTimer timer("print eeyore");
 	compiler_skeleton::eeyore::EeyorePrinter printer{out};
 	for(const auto &stmt : stmts)
 		std::visit(printer, stmt);
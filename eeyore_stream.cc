@@ -0,0 +1,64 @@
+#include <algorithm>
+#include <cassert>
+#include "profiler.h"
+#include "eeyore_stream.h"
+
+namespace
+{
+
+compiler_skeleton::utils::Statistic funcs_streamed("eeyore stream", "functions streamed");
+compiler_skeleton::utils::Statistic stmts_streamed("eeyore stream", "statements streamed");
+
+} // namespace
+
+namespace compiler_skeleton::eeyore
+{
+
+EeyoreStream::EeyoreStream(std::ostream &out)
+  : _out(out), _printer(out), _func_stmts(&_func_arena), _in_func(false), _func_cnt(0),
+	_max_func_size(0)
+{
+}
+
+void EeyoreStream::push_back(const EeyoreStatement &stmt)
+{
+	++stmts_streamed;
+	if(std::holds_alternative<FuncDefStmt>(stmt))
+	{
+		assert(!_in_func);
+		_in_func = true;
+	}
+	if(!_in_func)
+	{
+		std::visit(_printer, stmt);
+		return;
+	}
+	_func_stmts.push_back(stmt);
+	if(std::holds_alternative<EndFuncDefStmt>(stmt))
+		_end_func();
+}
+
+void EeyoreStream::_end_func()
+{
+	_max_func_size = std::max(_max_func_size, _func_stmts.size());
+	{
+		utils::ArenaScope scope(_func_arena);
+		utils::ScopedTimer timer("eeyore stream passes");
+		for(auto &pass : _passes)
+			pass(_func_stmts);
+	}
+	{
+		utils::ScopedTimer timer("print eeyore");
+		for(const auto &stmt : _func_stmts)
+			std::visit(_printer, stmt);
+	}
+
+	// Drop the buffer before the arena goes away under it.
+	EeyoreStmtVec(&_func_arena).swap(_func_stmts);
+	_func_arena.release();
+	_in_func = false;
+	_func_cnt++;
+	++funcs_streamed;
+}
+
+} // namespace compiler_skeleton::eeyore
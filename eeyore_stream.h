@@ -0,0 +1,81 @@
+#ifndef SKELETON_EEYORE_STREAM_H
+#define SKELETON_EEYORE_STREAM_H
+
+/*
+ * Streaming output of Eeyore programs, one function at a time.
+ *
+ * Printing a container of statements (see eeyore.h) needs the whole program in
+ * memory first. An EeyoreStream instead takes the statements one by one, in
+ * program order, as a code generator produces them:
+ *  + Global declarations are printed right away.
+ *  + The statements of a function are buffered until its EndFuncDefStmt. Then
+ *    the function passes (e.g. optimizations) run on the buffered function in
+ *    the order they were added, the result is printed, and all the memory of
+ *    the function is released.
+ *
+ * So the memory held at any time is bounded by the largest function rather
+ * than by the whole program. The buffer and everything the passes allocate
+ * from `utils::unit_resource()' live in an arena owned by the stream, which is
+ * installed (see arena.h) while the passes run and released after each
+ * function. Passes must not keep such memory across functions.
+ *
+ * The stream has `push_back', so generators templated on the container (e.g.
+ * those of synth.h) can write into it directly.
+ *
+ * Example:
+ *     using namespace compiler_skeleton::eeyore;
+ *     EeyoreStream stream(std::cout);
+ *     stream.add_pass([](EeyoreStmtVec &func) { ... }); // optional
+ *     stream << FuncDefStmt("main", 0) << RetStmt(0) << EndFuncDefStmt("main");
+ *     // "f_main" has been printed by now
+ */
+
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include "arena.h"
+#include "eeyore.h"
+
+namespace compiler_skeleton::eeyore
+{
+
+class EeyoreStream
+{
+  public:
+	// A pass on one function, from its FuncDefStmt to its EndFuncDefStmt
+	// (inclusive). It may modify the statements freely.
+	using FuncPass = std::function<void (EeyoreStmtVec &func)>;
+
+  protected:
+	std::ostream &_out;
+	EeyorePrinter _printer;
+	std::vector<FuncPass> _passes;
+	utils::Arena _func_arena;
+	EeyoreStmtVec _func_stmts; // of the current function, in `_func_arena'
+	bool _in_func;
+	size_t _func_cnt, _max_func_size;
+
+	void _end_func();
+
+  public:
+	EeyoreStream(std::ostream &out);
+	EeyoreStream(const EeyoreStream &) = delete;
+	EeyoreStream &operator = (const EeyoreStream &) = delete;
+
+	void add_pass(FuncPass pass) { _passes.push_back(std::move(pass)); }
+
+	void push_back(const EeyoreStatement &stmt);
+	EeyoreStream &operator << (const EeyoreStatement &stmt) { push_back(stmt); return *this; }
+
+	// Functions emitted so far, and the statement count of the largest one
+	// (before the passes).
+	size_t func_cnt() const { return _func_cnt; }
+	size_t max_func_size() const { return _max_func_size; }
+	// True between a FuncDefStmt and its EndFuncDefStmt.
+	bool in_func() const { return _in_func; }
+};
+
+} // namespace compiler_skeleton::eeyore
+
+#endif
@@ -6,6 +6,26 @@
 	// Include your headers here.
 	#include <iostream>
 	#include <string>
+	#include "arena.h"
+	#include "source_file.h"
+	#include "symbol.h"
+
+	// The handle of a reentrant flex scanner, as flex itself defines it.
+	typedef void *yyscan_t;
+	class Scanner; // see below
+}
+
+%code
+{
+	#include <algorithm>
+	#include <cstdlib>
+	#include <cstring>
+	#include <fstream>
+	#include <sstream>
+	#include <vector>
+	#include "compile_server.h"
+	#include "front_end.h"
+	#include "profiler.h"
 }
 
 %code provides
@@ -15,22 +35,53 @@
 	typedef yy::parser::semantic_type YYSTYPE;
 	typedef yy::parser::location_type YYLTYPE;
 
-	// Call yylex in C style.
-	extern "C"
-		int yylex(YYSTYPE *yylval,YYLTYPE *yylloc);
+	// A reentrant scanner of a whole file, mapped into memory (see example.l).
+	// All the state of a scan lives in the object, so several files can be
+	// scanned at once, on different threads.
+	class Scanner
+	{
+	  protected:
+		yyscan_t _scanner;
+		compiler_skeleton::utils::SourceFile _file;
+		std::string _filename; // the token locations point to it
+
+	  public:
+		yy::location loc; // of the current token
+
+		Scanner();
+		~Scanner();
+		Scanner(const Scanner &) = delete;
+		Scanner &operator = (const Scanner &) = delete;
+
+		// Scan the file `filename', or stdin if it is nullptr, from the start.
+		// Returns false if the file cannot be read.
+		bool open(const char *filename);
+		yyscan_t handle() { return _scanner; }
+	};
+
+	// The scanner generated by flex, and the form the parser calls.
+	int yylex(YYSTYPE *yylval, YYLTYPE *yylloc, yyscan_t scanner);
+	inline int yylex(YYSTYPE *yylval, YYLTYPE *yylloc, Scanner &scanner)
+	{
+		return yylex(yylval, yylloc, scanner.handle());
+	}
 }
 
 %defines "example.tab.h" // Generate a header file with specific filename.
 %locations // Track token locations.
 %define api.location.file "./location.h" // Generate a location.h header file so
 						// that other files (e.g. ast.h) could include only them.
+// The parser keeps no global state: it reads tokens from its own scanner and
+// writes to its own streams, so a parser per file may run on each thread.
+%parse-param {Scanner &scanner} {std::ostream &out} {std::ostream &err}
+%lex-param {Scanner &scanner}
 %parse-param {int &stmt_cnt} // To return something from a bison parser, you
 							// should add references its argument.
 
 %define api.value.type variant; // Define the return value of all symbols to be a
 								// variant. (i.e. to be any type)
 %token<int> NUMBER; // The return value of terminal NUMBER is an int, and so forth.
-%token<std::string> WORD;
+%token<compiler_skeleton::utils::Symbol> WORD; // Identifiers are interned.
 %token<int> EQUAL; // We never use the return value of EQUAL, simply define it as int.
 %nterm<int> statement file; // %nterm is used to mark non-terminals.
 
@@ -43,7 +94,7 @@
 file		: file statement
 				{
 					stmt_cnt++;
-					std::cout << " statement ends!" << std::endl;
+					out << " statement ends!" << std::endl;
 				}
 			| %empty
 				{ stmt_cnt = 0; }
@@ -51,7 +102,7 @@ file		: file statement
 // A statement looks like "xx = yy = 3"
 statement	: WORD EQUAL statement[substmt]
 				{
-					std::cout << " " << $WORD << " = " << $substmt << std::endl;
+					out << " " << $WORD << " = " << $substmt << std::endl;
 					$$ = $substmt;
 				}
 			| NUMBER
@@ -65,15 +116,177 @@ namespace yy
 {
 	void parser::error(const location_type &loc, const std::string& msg)
 	{
-		std::cerr << "error at line " << loc.begin.line
-			<< ": " << msg << std::endl;
+		err << "error at ";
+		if(loc.begin.filename != nullptr)
+			err << *loc.begin.filename << ' ';
+		err << "line " << loc.begin.line << ": " << msg << std::endl;
 	}
 
 }
 
-int main()
+// Parse the files with the hand-written SysY parser instead of bison, and
+// check them, on `jobs' threads. The results are printed in input order.
+static int parse_with_rd_parser(const std::vector<const char *> &filenames, int jobs)
 {
-	int stmt_cnt;
-	yy::parser(stmt_cnt).parse();
-	std::cout << "matched " << stmt_cnt << " statements." << std::endl;
-}
\ No newline at end of file
+	compiler_skeleton::utils::ThreadPool pool(jobs);
+	auto results = compiler_skeleton::sysy::check_files(filenames, pool);
+	int ret = 0;
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		// Name the file only if there are several of them.
+		compiler_skeleton::sysy::print_result(results[i], filenames[i], filenames.size() > 1,
+			std::cout, std::cerr);
+		ret = results[i].ok()? ret : 1;
+	}
+	return ret;
+}
+
+// Parse the files with the bison parser on `jobs' threads, with a scanner
+// and a parser per file. The outputs are printed in input order.
+static int parse_with_bison(const std::vector<const char *> &filenames, int jobs)
+{
+	std::vector<std::string> outs(filenames.size()), errs(filenames.size());
+	std::vector<char> failed(filenames.size(), false);
+	compiler_skeleton::utils::ThreadPool pool(jobs);
+	pool.parallel_for(filenames.size(), [&](size_t i)
+	{
+		// Everything allocated for the compilation unit goes into this arena,
+		// and is freed at once when the scope ends.
+		compiler_skeleton::utils::Arena unit_arena;
+		compiler_skeleton::utils::ArenaScope unit_scope(unit_arena);
+		std::ostringstream out, err;
+		Scanner scanner;
+		// Read from the file given in the command line, or from stdin otherwise.
+		if(!scanner.open(filenames[i]))
+		{
+			err << "cannot open " << (filenames[i] != nullptr? filenames[i] : "stdin") << std::endl;
+			failed[i] = true;
+		}
+		else
+		{
+			compiler_skeleton::utils::ScopedTimer parse_timer("bison parse");
+			int stmt_cnt;
+			failed[i] = yy::parser(scanner, out, err, stmt_cnt).parse() != 0;
+			out << "matched " << stmt_cnt << " statements." << std::endl;
+		}
+		outs[i] = out.str();
+		errs[i] = err.str();
+	});
+
+	for(size_t i = 0; i < filenames.size(); i++)
+	{
+		std::cout << outs[i];
+		std::cerr << errs[i];
+	}
+	return std::find(failed.begin(), failed.end(), true) != failed.end()? 1 : 0;
+}
+
+// Send the files to the compile server at `socket_path' (see
+// compile_server.h), and print the results in input order. Ask the server to
+// quit afterwards if `quit' is set.
+static int compile_on_server(const char *socket_path, const std::vector<const char *> &filenames,
+	bool quit)
+{
+	std::vector<compiler_skeleton::server::Request> reqs;
+	for(const char *filename : filenames)
+	{
+		compiler_skeleton::utils::SourceFile file;
+		if(!file.open(filename))
+		{
+			std::cerr << "cannot open " << (filename != nullptr? filename : "stdin") << std::endl;
+			return 1;
+		}
+		// Name the file only if there are several of them.
+		reqs.push_back({filenames.size() > 1? filename : "", std::string(file.text())});
+	}
+	std::vector<compiler_skeleton::server::Response> resps;
+	if(!compile_remote(socket_path, reqs, resps, quit))
+	{
+		std::cerr << "cannot reach the compile server at " << socket_path << std::endl;
+		return 1;
+	}
+	int ret = 0;
+	for(const auto &resp : resps)
+	{
+		std::cout << resp.out;
+		std::cerr << resp.err;
+		ret = std::max(ret, resp.status);
+	}
+	return ret;
+}
+
+// Usage: example [-r] [--jobs=N] [--profile] [--trace=FILE]
+//                [--serve=SOCKET | --connect=SOCKET [--quit]] [file...]
+//   -r: parse SysY with the hand-written recursive-descent parser (parser.h),
+//       and check it (sema.h). Several files are parsed and checked in
+//       parallel (see front_end.h), as the bison parser does.
+//   --jobs=N: use N threads; 0 (the default) means one per hardware thread.
+//   --profile: print the time of each phase and the statistics to stderr.
+//   --trace=FILE: write the phases as a Chrome trace to FILE.
+//   --serve=SOCKET: run as a compile server on the Unix socket SOCKET until
+//       a client asks it to quit. The server checks SysY as `-r' does.
+//   --connect=SOCKET: have the files compiled by the server on SOCKET.
+//   --quit: ask the server to quit after that.
+// Without files, stdin is read.
+int main(int argc, char **argv)
+{
+	bool use_rd_parser = false, print_prof = false;
+	int jobs = 0;
+	bool quit_server = false;
+	const char *trace_file = nullptr, *serve_socket = nullptr, *server_socket = nullptr;
+	std::vector<const char *> filenames;
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-r") == 0)
+			use_rd_parser = true;
+		else if(strncmp(argv[i], "--jobs=", 7) == 0)
+			jobs = atoi(argv[i] + 7);
+		else if(strcmp(argv[i], "--profile") == 0)
+			print_prof = true;
+		else if(strncmp(argv[i], "--trace=", 8) == 0)
+			trace_file = argv[i] + 8;
+		else if(strncmp(argv[i], "--serve=", 8) == 0)
+			serve_socket = argv[i] + 8;
+		else if(strncmp(argv[i], "--connect=", 10) == 0)
+			server_socket = argv[i] + 10;
+		else if(strcmp(argv[i], "--quit") == 0)
+			quit_server = true;
+		else
+			filenames.push_back(argv[i]);
+	}
+	if(filenames.empty() && !(server_socket != nullptr && quit_server))
+		filenames.push_back(nullptr);
+	if(print_prof || trace_file != nullptr)
+		compiler_skeleton::utils::enable_profiling();
+
+	int ret = 0;
+	{
+		compiler_skeleton::utils::ScopedTimer timer("total");
+		if(serve_socket != nullptr)
+		{
+			compiler_skeleton::server::CompileServer server(jobs);
+			if(!server.listen(serve_socket))
+			{
+				std::cerr << "cannot listen at " << serve_socket << std::endl;
+				ret = 1;
+			}
+			else
+				server.serve();
+		}
+		else if(server_socket != nullptr)
+			ret = compile_on_server(server_socket, filenames, quit_server);
+		else if(use_rd_parser)
+			ret = parse_with_rd_parser(filenames, jobs);
+		else
+			ret = parse_with_bison(filenames, jobs);
+	}
+
+	if(print_prof)
+		compiler_skeleton::utils::print_profile(std::cerr);
+	if(trace_file != nullptr)
+	{
+		std::ofstream trace_out(trace_file);
+		compiler_skeleton::utils::write_chrome_trace(trace_out);
+	}
+	return ret;
+}
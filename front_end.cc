@@ -0,0 +1,77 @@
+#include <string>
+#include "profiler.h"
+#include "source_file.h"
+#include "front_end.h"
+
+namespace
+{
+
+compiler_skeleton::utils::Statistic files_checked("front end", "files checked");
+
+} // namespace
+
+namespace compiler_skeleton::sysy
+{
+
+FileResult check_source(std::string_view src, utils::Arena &arena, utils::ThreadPool *pool)
+{
+	FileResult res;
+	res.opened = true;
+	++files_checked;
+
+	utils::ArenaScope unit_scope(arena);
+	SyntaxError err;
+	CompUnit *unit = parse_sysy(src, arena, err);
+	if(unit == nullptr)
+	{
+		res.syntax_error = std::move(err);
+		return res;
+	}
+	res.global_item_cnt = unit->items.size();
+	res.diags = pool != nullptr? analyze(*unit, *pool) : analyze(*unit);
+	return res;
+}
+
+FileResult check_file(const char *filename, utils::ThreadPool *pool)
+{
+	utils::ScopedTimer timer("check file");
+	utils::SourceFile file;
+	if(!file.open(filename))
+		return FileResult();
+	utils::Arena unit_arena;
+	return check_source(file.text(), unit_arena, pool);
+}
+
+std::vector<FileResult> check_files(const std::vector<const char *> &filenames,
+	utils::ThreadPool &pool)
+{
+	utils::ScopedTimer timer("check files");
+	std::vector<FileResult> results(filenames.size());
+	// parallel_for does not nest, so a lone file takes the whole pool instead.
+	if(filenames.size() == 1)
+		results[0] = check_file(filenames[0], &pool);
+	else
+		pool.parallel_for(filenames.size(),
+			[&](size_t i) { results[i] = check_file(filenames[i]); });
+	return results;
+}
+
+void print_result(const FileResult &res, const char *filename, bool name_file,
+	std::ostream &out, std::ostream &err)
+{
+	const char *name = filename != nullptr? filename : "stdin";
+	std::string prefix = name_file? std::string(name) + ": " : "";
+	if(!res.opened)
+		err << "cannot open " << name << std::endl;
+	else if(res.syntax_error)
+		err << prefix << "error at " << res.syntax_error->loc
+			<< ": " << res.syntax_error->msg << std::endl;
+	else
+	{
+		out << prefix << "matched " << res.global_item_cnt << " global items." << std::endl;
+		for(const auto &diag : res.diags)
+			err << prefix << "error at " << diag.loc << ": " << diag.msg << std::endl;
+	}
+}
+
+} // namespace compiler_skeleton::sysy
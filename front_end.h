@@ -0,0 +1,70 @@
+#ifndef SKELETON_FRONT_END_H
+#define SKELETON_FRONT_END_H
+
+/*
+ * The front end over many SysY files at once: each file is mapped (see
+ * source_file.h), parsed by the hand-written parser and checked (see sema.h).
+ *
+ * The files are independent, so they are spread over a thread pool, one file
+ * per work item. Each file gets its own arena, installed as the unit resource
+ * of the thread working on it, and the parser keeps all its state in its own
+ * objects. Only the symbol table and the types are shared, and both are
+ * thread-safe. A single file has its function bodies checked on the pool
+ * instead.
+ *
+ * The results come back in input order whatever the order of completion, so
+ * the output does not depend on the number of threads.
+ *
+ * Example:
+ *     using namespace compiler_skeleton;
+ *     utils::ThreadPool pool;
+ *     auto results = sysy::check_files(filenames, pool);
+ *     for(size_t i = 0; i < results.size(); i++)
+ *         if(!results[i].ok())
+ *             ... // report the errors of filenames[i]
+ */
+
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+#include "thread_pool.h"
+#include "parser.h"
+#include "sema.h"
+
+namespace compiler_skeleton::sysy
+{
+
+struct FileResult
+{
+	bool opened = false; // false if the file cannot be read
+	std::optional<SyntaxError> syntax_error;
+	std::vector<Diagnostic> diags;
+	size_t global_item_cnt = 0;
+
+	bool ok() const { return opened && !syntax_error && diags.empty(); }
+};
+
+// Parse and check a source text, with the AST in `arena' (which is left as
+// is). The function bodies are checked on `pool' if given.
+FileResult check_source(std::string_view src, utils::Arena &arena,
+	utils::ThreadPool *pool=nullptr);
+
+// Parse and check a single file (stdin if `filename' is nullptr) in an arena
+// of its own. The function bodies are checked on `pool' if given.
+FileResult check_file(const char *filename, utils::ThreadPool *pool=nullptr);
+
+// Parse and check all the files on `pool'. The results are in input order.
+std::vector<FileResult> check_files(const std::vector<const char *> &filenames,
+	utils::ThreadPool &pool);
+
+// Print the result of the file `filename' (nullptr for stdin) as the example
+// driver does: a summary to `out' and the errors to `err'. The messages name
+// the file if `name_file' is set.
+void print_result(const FileResult &res, const char *filename, bool name_file,
+	std::ostream &out, std::ostream &err);
+
+} // namespace compiler_skeleton::sysy
+
+#endif
@@ -0,0 +1,242 @@
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+#include "lambda_visitor.h"
+#include "profiler.h"
+#include "func_cache.h"
+
+namespace
+{
+
+using namespace compiler_skeleton::eeyore;
+
+// Bump this whenever the output of the back end changes, so that old entries
+// are not reused.
+constexpr uint64_t CACHE_FORMAT_VERSION = 2;
+
+compiler_skeleton::utils::Statistic cache_hits("func cache", "hits");
+compiler_skeleton::utils::Statistic cache_misses("func cache", "misses");
+
+// 64-bit FNV-1a.
+class HashBuilder
+{
+  protected:
+	uint64_t _hash;
+
+  public:
+	HashBuilder(uint64_t seed): _hash(14695981039346656037ull ^ seed) {}
+
+	void add_bytes(const void *data, size_t len)
+	{
+		auto p = static_cast<const unsigned char *>(data);
+		for(size_t i = 0; i < len; i++)
+		{
+			_hash ^= p[i];
+			_hash *= 1099511628211ull;
+		}
+	}
+	void add(uint64_t val) { add_bytes(&val, sizeof(val)); }
+	void add(std::string_view str) { add(str.size()); add_bytes(str.data(), str.size()); }
+	void add(const Operand &opr)
+	{
+		add(opr.index());
+		std::visit(compiler_skeleton::utils::LambdaVisitor
+		{
+			[this](int val) { add(static_cast<uint64_t>(val)); },
+			[this](const OrigVar &var) { add(var.id); add(var.size); },
+			[this](const auto &var) { add(var.id); }
+		}, opr);
+	}
+	uint64_t get() const { return _hash; }
+};
+
+inline bool is_func_def(const EeyoreStatement &stmt)
+{
+	return std::holds_alternative<FuncDefStmt>(stmt);
+}
+
+inline bool is_end_func_def(const EeyoreStatement &stmt)
+{
+	return std::holds_alternative<EndFuncDefStmt>(stmt);
+}
+
+} // namespace
+
+namespace compiler_skeleton::eeyore
+{
+
+uint64_t hash_stmts(const EeyoreStatement *begin, const EeyoreStatement *end,
+	const FuncTypeMap &func_types, uint64_t seed)
+{
+	HashBuilder hb(seed);
+	utils::LambdaVisitor stmt_hasher =
+	{
+		// Global declarations are never cached, but f_main stores the
+		// initial data in Tigger, so the data goes into the hashes of all
+		// the functions.
+		[&](const DeclStmt &stmt)
+		{
+			hb.add(stmt.var);
+			hb.add(stmt.is_arr);
+			if(stmt.init != nullptr)
+				stmt.init->for_each_nonzero([&](int offset, int val) { hb.add(offset); hb.add(val); });
+		},
+		[&](const FuncDefStmt &stmt) { hb.add(stmt.func_name.str()); hb.add(stmt.arg_cnt); },
+		[&](const EndFuncDefStmt &stmt) { hb.add(stmt.func_name.str()); },
+		[&](const ParamStmt &stmt) { hb.add(stmt.param); },
+		[&](const FuncCallStmt &stmt)
+		{
+			hb.add(stmt.func_name.str());
+			hb.add(stmt.retval_receiver.has_value());
+			if(stmt.retval_receiver.has_value())
+				hb.add(stmt.retval_receiver.value());
+			// The code of a call depends on the signature of the callee.
+			auto iter = func_types.find(stmt.func_name);
+			if(iter != func_types.end())
+				hb.add(iter->second->hash());
+		},
+		[&](const RetStmt &stmt)
+		{
+			hb.add(stmt.retval.has_value());
+			if(stmt.retval.has_value())
+				hb.add(stmt.retval.value());
+		},
+		[&](const GotoStmt &stmt) { hb.add(stmt.goto_label.id); },
+		[&](const CondGotoStmt &stmt)
+		{
+			hb.add(static_cast<uint64_t>(stmt.op));
+			hb.add(stmt.opr1);
+			hb.add(stmt.opr2);
+			hb.add(stmt.goto_label.id);
+		},
+		[&](const UnaryOpStmt &stmt)
+		{
+			hb.add(static_cast<uint64_t>(stmt.op_type));
+			hb.add(stmt.opr);
+			hb.add(stmt.opr1);
+		},
+		[&](const BinaryOpStmt &stmt)
+		{
+			hb.add(static_cast<uint64_t>(stmt.op_type));
+			hb.add(stmt.opr);
+			hb.add(stmt.opr1);
+			hb.add(stmt.opr2);
+		},
+		[&](const MoveStmt &stmt) { hb.add(stmt.opr); hb.add(stmt.opr1); },
+		[&](const ReadArrStmt &stmt)
+			{ hb.add(stmt.opr); hb.add(stmt.arr_opr); hb.add(stmt.idx_opr); },
+		[&](const WriteArrStmt &stmt)
+			{ hb.add(stmt.arr_opr); hb.add(stmt.idx_opr); hb.add(stmt.opr); },
+		[&](const LabelStmt &stmt) { hb.add(stmt.label.id); }
+	};
+
+	for(auto stmt = begin; stmt != end; ++stmt)
+	{
+		hb.add(stmt->index());
+		std::visit(stmt_hasher, *stmt);
+	}
+	return hb.get();
+}
+
+FuncCache::FuncCache(std::filesystem::path dir): _dir(std::move(dir))
+{
+	std::error_code ec;
+	std::filesystem::create_directories(_dir, ec);
+}
+
+std::filesystem::path FuncCache::_path_of(uint64_t hash) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.tigger", static_cast<unsigned long long>(hash));
+	return _dir / name;
+}
+
+std::optional<std::string> FuncCache::lookup(uint64_t hash) const
+{
+	std::ifstream in(_path_of(hash), std::ios::binary);
+	if(!in)
+		return std::nullopt;
+	return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+void FuncCache::store(uint64_t hash, std::string_view output) const
+{
+	std::filesystem::path path = _path_of(hash), tmp_path = path;
+	tmp_path += ".tmp." + std::to_string(getpid()) + '.'
+		+ std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+	{
+		std::ofstream out(tmp_path, std::ios::binary);
+		if(!out.write(output.data(), output.size()))
+			return;
+	}
+	std::error_code ec;
+	std::filesystem::rename(tmp_path, path, ec);
+	if(ec)
+		std::filesystem::remove(tmp_path, ec);
+}
+
+CacheStats compile_with_cache(const EeyoreStatement *begin, const EeyoreStatement *end,
+	const FuncTypeMap &func_types, const FuncCache &cache, std::ostream &out,
+	const FuncCompiler &compile)
+{
+	utils::ScopedTimer timer("compile with cache");
+	// Global declarations decide the numbering of global variables in Tigger,
+	// so every function hash depends on them.
+	HashBuilder global_hb(CACHE_FORMAT_VERSION);
+	bool in_func = false;
+	for(auto stmt = begin; stmt != end; ++stmt)
+	{
+		if(is_func_def(*stmt))
+			in_func = true;
+		else if(is_end_func_def(*stmt))
+			in_func = false;
+		else if(!in_func)
+			global_hb.add(hash_stmts(stmt, stmt + 1, func_types));
+	}
+	uint64_t seed = global_hb.get();
+
+	CacheStats stats;
+	for(auto stmt = begin; stmt != end; )
+	{
+		if(!is_func_def(*stmt))
+		{
+			auto globals_end = stmt;
+			while(globals_end != end && !is_func_def(*globals_end))
+				++globals_end;
+			compile(stmt, globals_end, out);
+			stmt = globals_end;
+			continue;
+		}
+
+		auto func_end = stmt;
+		while(func_end != end && !is_end_func_def(*func_end))
+			++func_end;
+		if(func_end != end)
+			++func_end;
+
+		uint64_t hash = hash_stmts(stmt, func_end, func_types, seed);
+		if(auto cached = cache.lookup(hash); cached.has_value())
+		{
+			out << cached.value();
+			stats.hits++;
+			++cache_hits;
+		}
+		else
+		{
+			std::ostringstream func_out;
+			compile(stmt, func_end, func_out);
+			std::string output = func_out.str();
+			cache.store(hash, output);
+			out << output;
+			stats.misses++;
+			++cache_misses;
+		}
+		stmt = func_end;
+	}
+	return stats;
+}
+
+} // namespace compiler_skeleton::eeyore
@@ -0,0 +1,82 @@
+#ifndef SKELETON_FUNC_CACHE_H
+#define SKELETON_FUNC_CACHE_H
+
+/*
+ * Incremental compilation at the granularity of functions.
+ *
+ * Each Eeyore function (from its FuncDefStmt to its EndFuncDefStmt) is hashed
+ * together with the signatures (FuncType) of the functions it calls and with
+ * a hash of the global declarations of the program. If an entry with the same
+ * hash is found in the on-disk cache directory, its Tigger output is reused,
+ * and the function skips optimization and register allocation altogether.
+ *
+ * The hashes only depend on the contents of the statements (names are hashed
+ * by their strings, not by symbol ids), so they are stable across runs.
+ *
+ * Example:
+ *     using namespace compiler_skeleton::eeyore;
+ *     FuncCache cache(".sysy-cache");
+ *     auto stats = compile_with_cache(stmts.data(), stmts.data() + stmts.size(),
+ *         func_types, cache, std::cout,
+ *         [](const EeyoreStatement *begin, const EeyoreStatement *end,
+ *            std::ostream &out) { ... }); // optimize, allocate registers, print
+ */
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "symbol.h"
+#include "sysy_type.h"
+#include "eeyore.h"
+
+namespace compiler_skeleton::eeyore
+{
+
+// Signatures of the functions in the program, keyed by their names.
+using FuncTypeMap = std::unordered_map<utils::Symbol, sysy::TypePtr>;
+
+// Content hash of a statement range. For a function, [begin, end) should be
+// from its FuncDefStmt to its EndFuncDefStmt (inclusive).
+uint64_t hash_stmts(const EeyoreStatement *begin, const EeyoreStatement *end,
+	const FuncTypeMap &func_types, uint64_t seed=0);
+
+// A directory of cached outputs, one file per hash.
+class FuncCache
+{
+  protected:
+	std::filesystem::path _dir;
+
+	std::filesystem::path _path_of(uint64_t hash) const;
+
+  public:
+	FuncCache(std::filesystem::path dir);
+
+	std::optional<std::string> lookup(uint64_t hash) const;
+	// The file is written to a temporary name first and then renamed, so a
+	// concurrent or interrupted compilation never sees a partial entry.
+	void store(uint64_t hash, std::string_view output) const;
+};
+
+// Compile a statement range into `out'.
+using FuncCompiler = std::function<void(const EeyoreStatement *begin,
+	const EeyoreStatement *end, std::ostream &out)>;
+
+struct CacheStats
+{
+	int hits = 0, misses = 0;
+};
+
+// Compile a whole program: global declarations always go through `compile',
+// and functions do only on a cache miss.
+CacheStats compile_with_cache(const EeyoreStatement *begin, const EeyoreStatement *end,
+	const FuncTypeMap &func_types, const FuncCache &cache, std::ostream &out,
+	const FuncCompiler &compile);
+
+} // namespace compiler_skeleton::eeyore
+
+#endif
@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <cstdint>
+#include "profiler.h"
+#include "lexer.h"
+
+namespace
+{
+
+using compiler_skeleton::sysy::TokenKind;
+
+inline bool is_ident_start(char ch)
+{
+	return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_';
+}
+
+inline bool is_digit(char ch)
+{
+	return ch >= '0' && ch <= '9';
+}
+
+inline int hex_digit_val(char ch)
+{
+	if(is_digit(ch))
+		return ch - '0';
+	if(ch >= 'a' && ch <= 'f')
+		return ch - 'a' + 10;
+	if(ch >= 'A' && ch <= 'F')
+		return ch - 'A' + 10;
+	return -1;
+}
+
+TokenKind keyword_or_ident(std::string_view word)
+{
+	static const std::pair<std::string_view, TokenKind> KEYWORDS[] =
+	{
+		{"const", TokenKind::CONST}, {"int", TokenKind::INT},
+		{"void", TokenKind::VOID}, {"if", TokenKind::IF},
+		{"else", TokenKind::ELSE}, {"while", TokenKind::WHILE},
+		{"break", TokenKind::BREAK}, {"continue", TokenKind::CONTINUE},
+		{"return", TokenKind::RETURN}
+	};
+	if(word.size() < 2 || word.size() > 8 || !(word[0] >= 'b' && word[0] <= 'w'))
+		return TokenKind::IDENT;
+	for(const auto &[keyword, kind] : KEYWORDS)
+		if(word == keyword)
+			return kind;
+	return TokenKind::IDENT;
+}
+
+compiler_skeleton::utils::Statistic tokens_scanned("lexer", "tokens");
+compiler_skeleton::utils::Statistic bytes_scanned("lexer", "bytes");
+
+} // namespace
+
+namespace compiler_skeleton::sysy
+{
+
+std::optional<LexError> tokenize(std::string_view src, std::vector<Token> &tokens)
+{
+	utils::ScopedTimer timer("lex");
+	size_t first_token = tokens.size();
+	bytes_scanned += src.size();
+	const char *p = src.data(), *end = src.data() + src.size();
+	const char *line_begin = p;
+	int line = 1;
+	auto loc_of = [&](const char *q) { return SrcLoc(line, int(q - line_begin) + 1); };
+	auto peek = [&](int off) { return p + off < end? p[off] : '\0'; };
+
+	while(p < end)
+	{
+		char ch = *p;
+		if(ch == '\n')
+		{
+			p++;
+			line++;
+			line_begin = p;
+			continue;
+		}
+		if(ch == ' ' || ch == '\t' || ch == '\r')
+		{
+			p++;
+			continue;
+		}
+		if(ch == '/' && peek(1) == '/')
+		{
+			while(p < end && *p != '\n')
+				p++;
+			continue;
+		}
+		if(ch == '/' && peek(1) == '*')
+		{
+			SrcLoc loc = loc_of(p);
+			p += 2;
+			while(p < end && !(*p == '*' && peek(1) == '/'))
+			{
+				if(*p == '\n')
+				{
+					line++;
+					line_begin = p + 1;
+				}
+				p++;
+			}
+			if(p == end)
+				return LexError{loc, "unterminated comment"};
+			p += 2;
+			continue;
+		}
+
+		SrcLoc loc = loc_of(p);
+		if(is_ident_start(ch))
+		{
+			const char *begin = p;
+			while(p < end && (is_ident_start(*p) || is_digit(*p)))
+				p++;
+			std::string_view word(begin, p - begin);
+			TokenKind kind = keyword_or_ident(word);
+			if(kind == TokenKind::IDENT)
+				tokens.emplace_back(kind, loc, 0, utils::Symbol(word));
+			else
+				tokens.emplace_back(kind, loc);
+			continue;
+		}
+		if(is_digit(ch))
+		{
+			// Literals may be 2147483648, which is negated later. Larger
+			// values are capped as they are accumulated, so they cannot wrap.
+			constexpr uint64_t MAX_LITERAL = 2147483648u;
+			uint64_t val = 0;
+			auto add_digit = [&](int base, int d) { val = std::min(val * base + d, MAX_LITERAL + 1); };
+			if(ch == '0' && (peek(1) == 'x' || peek(1) == 'X'))
+			{
+				p += 2;
+				const char *digits = p;
+				for(int d; p < end && (d = hex_digit_val(*p)) >= 0; p++)
+					add_digit(16, d);
+				if(p == digits)
+					return LexError{loc, "hexadecimal literal without digits"};
+			}
+			else if(ch == '0')
+			{
+				for(; p < end && *p >= '0' && *p <= '7'; p++)
+					add_digit(8, *p - '0');
+			}
+			else
+			{
+				for(; p < end && is_digit(*p); p++)
+					add_digit(10, *p - '0');
+			}
+			if(val > MAX_LITERAL)
+				return LexError{loc, "integer literal too large"};
+			tokens.emplace_back(TokenKind::NUMBER, loc, static_cast<int>(static_cast<uint32_t>(val)));
+			continue;
+		}
+
+		TokenKind kind;
+		int len = 1;
+		char next = peek(1);
+		switch(ch)
+		{
+			case '+': kind = TokenKind::PLUS; break;
+			case '-': kind = TokenKind::MINUS; break;
+			case '*': kind = TokenKind::STAR; break;
+			case '/': kind = TokenKind::SLASH; break;
+			case '%': kind = TokenKind::PERCENT; break;
+			case ';': kind = TokenKind::SEMICOLON; break;
+			case ',': kind = TokenKind::COMMA; break;
+			case '(': kind = TokenKind::LPAREN; break;
+			case ')': kind = TokenKind::RPAREN; break;
+			case '[': kind = TokenKind::LBRACKET; break;
+			case ']': kind = TokenKind::RBRACKET; break;
+			case '{': kind = TokenKind::LBRACE; break;
+			case '}': kind = TokenKind::RBRACE; break;
+			case '<':
+				kind = next == '='? (len = 2, TokenKind::LE) : TokenKind::LT;
+				break;
+			case '>':
+				kind = next == '='? (len = 2, TokenKind::GE) : TokenKind::GT;
+				break;
+			case '=':
+				kind = next == '='? (len = 2, TokenKind::EQ) : TokenKind::ASSIGN;
+				break;
+			case '!':
+				kind = next == '='? (len = 2, TokenKind::NE) : TokenKind::NOT;
+				break;
+			case '&':
+				if(next != '&')
+					return LexError{loc, "unrecognized character"};
+				kind = TokenKind::AND;
+				len = 2;
+				break;
+			case '|':
+				if(next != '|')
+					return LexError{loc, "unrecognized character"};
+				kind = TokenKind::OR;
+				len = 2;
+				break;
+			default:
+				return LexError{loc, "unrecognized character"};
+		}
+		tokens.emplace_back(kind, loc);
+		p += len;
+	}
+	tokens.emplace_back(TokenKind::END, loc_of(p));
+	tokens_scanned += tokens.size() - first_token;
+	return std::nullopt;
+}
+
+} // namespace compiler_skeleton::sysy
+
+std::ostream &operator << (std::ostream &out, const compiler_skeleton::sysy::TokenKind &kind)
+{
+	static const char *NAMES[] =
+	{
+		"end of file", "identifier", "number",
+		"const", "int", "void", "if", "else", "while", "break", "continue", "return",
+		"+", "-", "*", "/", "%", "!", "&&", "||",
+		"<", ">", "<=", ">=", "==", "!=", "=",
+		";", ",", "(", ")", "[", "]", "{", "}"
+	};
+	return out << NAMES[static_cast<int>(kind)];
+}
+
+std::ostream &operator << (std::ostream &out, const compiler_skeleton::sysy::SrcLoc &loc)
+{
+	return out << loc.line << ':' << loc.col;
+}
@@ -0,0 +1,76 @@
+#ifndef SKELETON_LEXER_H
+#define SKELETON_LEXER_H
+
+/*
+ * A hand-written SysY lexer that turns a whole source buffer into a token
+ * array in one pass. It is the front half of the recursive-descent parser in
+ * parser.h, and does not depend on flex.
+ *
+ * Identifiers are interned as symbols, and integer literals (decimal, octal
+ * and hexadecimal) are converted to ints. A literal may be 2147483648 at most,
+ * which is only meaningful negated. Comments and white spaces are skipped.
+ * Each token records its line and column (both starting from 1).
+ *
+ * Example:
+ *     using namespace compiler_skeleton::sysy;
+ *     std::vector<Token> tokens;
+ *     std::optional<LexError> err = tokenize(source_text, tokens);
+ *     if(err.has_value())
+ *         std::cerr << err->loc << ": " << err->msg << std::endl;
+ */
+
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "symbol.h"
+
+namespace compiler_skeleton::sysy
+{
+
+struct SrcLoc
+{
+	int line, col;
+	SrcLoc(int _line=0, int _col=0): line(_line), col(_col) {}
+};
+
+enum class TokenKind
+{
+	END, // end of input
+	IDENT, NUMBER,
+	// keywords
+	CONST, INT, VOID, IF, ELSE, WHILE, BREAK, CONTINUE, RETURN,
+	// operators and punctuations
+	PLUS, MINUS, STAR, SLASH, PERCENT, NOT, AND, OR,
+	LT, GT, LE, GE, EQ, NE, ASSIGN,
+	SEMICOLON, COMMA, LPAREN, RPAREN, LBRACKET, RBRACKET, LBRACE, RBRACE
+};
+
+struct Token
+{
+	TokenKind kind;
+	SrcLoc loc;
+	int num; // value of a NUMBER
+	utils::Symbol ident; // name of an IDENT
+
+	Token(TokenKind _kind, SrcLoc _loc, int _num=0, utils::Symbol _ident=utils::Symbol())
+	  : kind(_kind), loc(_loc), num(_num), ident(_ident) {}
+};
+
+struct LexError
+{
+	SrcLoc loc;
+	const char *msg;
+};
+
+// Append the tokens of `src' to `tokens', ended with an END token. Returns the
+// first error, if any: a character that cannot start a token, a comment that
+// is never closed, or a malformed or too large literal.
+std::optional<LexError> tokenize(std::string_view src, std::vector<Token> &tokens);
+
+} // namespace compiler_skeleton::sysy
+
+std::ostream &operator << (std::ostream &out, const compiler_skeleton::sysy::TokenKind &kind);
+std::ostream &operator << (std::ostream &out, const compiler_skeleton::sysy::SrcLoc &loc);
+
+#endif
@@ -0,0 +1,335 @@
+#include <sstream>
+#include "profiler.h"
+#include "parser.h"
+
+namespace
+{
+
+using namespace compiler_skeleton::sysy;
+
+// Precedence of binary operators, 0 if the token is not one.
+inline int binary_prec(TokenKind kind, BinaryOp &op)
+{
+	switch(kind)
+	{
+		case TokenKind::OR: op = BinaryOp::OR; return 1;
+		case TokenKind::AND: op = BinaryOp::AND; return 2;
+		case TokenKind::EQ: op = BinaryOp::EQ; return 3;
+		case TokenKind::NE: op = BinaryOp::NE; return 3;
+		case TokenKind::LT: op = BinaryOp::LT; return 4;
+		case TokenKind::GT: op = BinaryOp::GT; return 4;
+		case TokenKind::LE: op = BinaryOp::LE; return 4;
+		case TokenKind::GE: op = BinaryOp::GE; return 4;
+		case TokenKind::PLUS: op = BinaryOp::ADD; return 5;
+		case TokenKind::MINUS: op = BinaryOp::SUB; return 5;
+		case TokenKind::STAR: op = BinaryOp::MUL; return 6;
+		case TokenKind::SLASH: op = BinaryOp::DIV; return 6;
+		case TokenKind::PERCENT: op = BinaryOp::MOD; return 6;
+		default: return 0;
+	}
+}
+
+} // namespace
+
+namespace compiler_skeleton::sysy
+{
+
+bool Parser::_accept(TokenKind kind)
+{
+	if(!_at(kind))
+		return false;
+	_pos++;
+	return true;
+}
+
+const Token &Parser::_expect(TokenKind kind)
+{
+	if(!_at(kind))
+	{
+		std::ostringstream msg;
+		msg << "expected " << kind << ", found " << _peek().kind;
+		_fail(msg.str());
+	}
+	return _tokens[_pos++];
+}
+
+void Parser::_fail(const std::string &msg) const
+{
+	// Unwinds to `parse()'.
+	throw SyntaxError{_peek().loc, msg};
+}
+
+CompUnit *Parser::parse(SyntaxError &err)
+{
+	utils::ScopedTimer timer("parse");
+	try
+	{
+		auto unit = _make<CompUnit>(&_arena);
+		while(!_at(TokenKind::END))
+		{
+			// `int f(' starts a function, `int a' a variable.
+			if((_at(TokenKind::INT) || _at(TokenKind::VOID))
+				&& _peek(1).kind == TokenKind::IDENT
+				&& _peek(2).kind == TokenKind::LPAREN)
+			{
+				unit->items.push_back(_parse_func_def());
+			}
+			else
+				unit->items.push_back(_make<VarDeclStmt>(_parse_var_decl()));
+		}
+		return unit;
+	}
+	catch(SyntaxError &e)
+	{
+		err = std::move(e);
+		return nullptr;
+	}
+}
+
+VarDeclStmt Parser::_parse_var_decl()
+{
+	SrcLoc loc = _peek().loc;
+	bool is_const = _accept(TokenKind::CONST);
+	_expect(TokenKind::INT);
+	std::pmr::vector<VarDef *> defs(&_arena);
+	do
+		defs.push_back(_parse_var_def(is_const));
+	while(_accept(TokenKind::COMMA));
+	_expect(TokenKind::SEMICOLON);
+	return VarDeclStmt(loc, is_const, std::move(defs));
+}
+
+VarDef *Parser::_parse_var_def(bool is_const)
+{
+	const Token &ident = _expect(TokenKind::IDENT);
+	bool has_empty_first;
+	ExprVec dims = _parse_dims(false, has_empty_first);
+	InitVal *init = nullptr;
+	if(_accept(TokenKind::ASSIGN))
+		init = _parse_init_val();
+	else if(is_const)
+		_fail("constant definition without an initializer");
+	return _make<VarDef>(ident.loc, ident.ident, std::move(dims), init);
+}
+
+InitVal *Parser::_parse_init_val()
+{
+	if(!_accept(TokenKind::LBRACE))
+		return _make<InitVal>(_parse_expr(), &_arena);
+	auto init = _make<InitVal>(nullptr, &_arena);
+	if(!_accept(TokenKind::RBRACE))
+	{
+		do
+			init->elems.push_back(_parse_init_val());
+		while(_accept(TokenKind::COMMA));
+		_expect(TokenKind::RBRACE);
+	}
+	return init;
+}
+
+FuncDef *Parser::_parse_func_def()
+{
+	SrcLoc loc = _peek().loc;
+	TypePtr retval_type = _accept(TokenKind::VOID)?
+		make_void() : (_expect(TokenKind::INT), make_int());
+	utils::Symbol name = _expect(TokenKind::IDENT).ident;
+	_expect(TokenKind::LPAREN);
+	std::pmr::vector<FuncParam *> params(&_arena);
+	if(!_accept(TokenKind::RPAREN))
+	{
+		do
+			params.push_back(_parse_func_param());
+		while(_accept(TokenKind::COMMA));
+		_expect(TokenKind::RPAREN);
+	}
+	BlockStmt *body = _make<BlockStmt>(_parse_block());
+	return _make<FuncDef>(loc, retval_type, name, std::move(params), body);
+}
+
+FuncParam *Parser::_parse_func_param()
+{
+	_expect(TokenKind::INT);
+	const Token &ident = _expect(TokenKind::IDENT);
+	bool is_ptr;
+	ExprVec dims = _parse_dims(true, is_ptr);
+	return _make<FuncParam>(ident.loc, ident.ident, is_ptr, std::move(dims));
+}
+
+// Parse `[e1][e2]...'. If allow_empty_first is set, the first pair of brackets
+// may be empty (as in function parameters), which is then not in the result.
+ExprVec Parser::_parse_dims(bool allow_empty_first, bool &has_empty_first)
+{
+	ExprVec dims(&_arena);
+	has_empty_first = false;
+	if(allow_empty_first && _at(TokenKind::LBRACKET)
+		&& _peek(1).kind == TokenKind::RBRACKET)
+	{
+		_pos += 2;
+		has_empty_first = true;
+	}
+	while(_accept(TokenKind::LBRACKET))
+	{
+		dims.push_back(_parse_expr());
+		_expect(TokenKind::RBRACKET);
+	}
+	return dims;
+}
+
+BlockStmt Parser::_parse_block()
+{
+	SrcLoc loc = _expect(TokenKind::LBRACE).loc;
+	StmtVec stmts(&_arena);
+	while(!_accept(TokenKind::RBRACE))
+	{
+		if(_at(TokenKind::CONST) || _at(TokenKind::INT))
+			stmts.push_back(_make<Stmt>(_parse_var_decl()));
+		else
+			stmts.push_back(_parse_stmt());
+	}
+	return BlockStmt(loc, std::move(stmts));
+}
+
+Stmt *Parser::_parse_stmt()
+{
+	SrcLoc loc = _peek().loc;
+	switch(_peek().kind)
+	{
+		case TokenKind::LBRACE:
+			return _make<Stmt>(_parse_block());
+		case TokenKind::IF:
+		{
+			_pos++;
+			_expect(TokenKind::LPAREN);
+			Expr *cond = _parse_expr();
+			_expect(TokenKind::RPAREN);
+			Stmt *then_stmt = _parse_stmt();
+			Stmt *else_stmt = _accept(TokenKind::ELSE)? _parse_stmt() : nullptr;
+			return _make<Stmt>(IfStmt(loc, cond, then_stmt, else_stmt));
+		}
+		case TokenKind::WHILE:
+		{
+			_pos++;
+			_expect(TokenKind::LPAREN);
+			Expr *cond = _parse_expr();
+			_expect(TokenKind::RPAREN);
+			return _make<Stmt>(WhileStmt(loc, cond, _parse_stmt()));
+		}
+		case TokenKind::BREAK:
+			_pos++;
+			_expect(TokenKind::SEMICOLON);
+			return _make<Stmt>(BreakStmt(loc));
+		case TokenKind::CONTINUE:
+			_pos++;
+			_expect(TokenKind::SEMICOLON);
+			return _make<Stmt>(ContinueStmt(loc));
+		case TokenKind::RETURN:
+		{
+			_pos++;
+			Expr *retval = _at(TokenKind::SEMICOLON)? nullptr : _parse_expr();
+			_expect(TokenKind::SEMICOLON);
+			return _make<Stmt>(ReturnStmt(loc, retval));
+		}
+		case TokenKind::SEMICOLON:
+			_pos++;
+			return _make<Stmt>(ExprStmt(loc, nullptr));
+		default:
+		{
+			// Either `lval = exp;' or `exp;'. Both start with an expression.
+			Expr *expr = _parse_expr();
+			if(_accept(TokenKind::ASSIGN))
+			{
+				if(!std::holds_alternative<LValExpr>(*expr))
+					_fail("the left hand side of an assignment is not assignable");
+				Expr *rval = _parse_expr();
+				_expect(TokenKind::SEMICOLON);
+				return _make<Stmt>(AssignStmt(loc, expr, rval));
+			}
+			_expect(TokenKind::SEMICOLON);
+			return _make<Stmt>(ExprStmt(loc, expr));
+		}
+	}
+}
+
+Expr *Parser::_parse_expr(int min_prec)
+{
+	Expr *lhs = _parse_unary();
+	BinaryOp op = BinaryOp::ADD; // set by binary_prec
+	int prec;
+	while((prec = binary_prec(_peek().kind, op)) >= min_prec)
+	{
+		SrcLoc loc = _peek().loc;
+		_pos++;
+		Expr *rhs = _parse_expr(prec + 1); // all operators are left associative
+		lhs = _make<Expr>(BinaryExpr(loc, lhs, op, rhs));
+	}
+	return lhs;
+}
+
+Expr *Parser::_parse_unary()
+{
+	SrcLoc loc = _peek().loc;
+	if(_accept(TokenKind::PLUS))
+		return _parse_unary();
+	if(_accept(TokenKind::MINUS))
+		return _make<Expr>(UnaryExpr(loc, UnaryOp::NEG, _parse_unary()));
+	if(_accept(TokenKind::NOT))
+		return _make<Expr>(UnaryExpr(loc, UnaryOp::NOT, _parse_unary()));
+	return _parse_primary();
+}
+
+Expr *Parser::_parse_primary()
+{
+	const Token &tok = _peek();
+	switch(tok.kind)
+	{
+		case TokenKind::LPAREN:
+		{
+			_pos++;
+			Expr *expr = _parse_expr();
+			_expect(TokenKind::RPAREN);
+			return expr;
+		}
+		case TokenKind::NUMBER:
+			_pos++;
+			return _make<Expr>(NumberExpr(tok.loc, tok.num));
+		case TokenKind::IDENT:
+		{
+			_pos++;
+			if(_accept(TokenKind::LPAREN))
+			{
+				ExprVec args(&_arena);
+				if(!_accept(TokenKind::RPAREN))
+				{
+					do
+						args.push_back(_parse_expr());
+					while(_accept(TokenKind::COMMA));
+					_expect(TokenKind::RPAREN);
+				}
+				return _make<Expr>(CallExpr(tok.loc, tok.ident, std::move(args)));
+			}
+			bool unused;
+			ExprVec indices = _parse_dims(false, unused);
+			return _make<Expr>(LValExpr(tok.loc, tok.ident, std::move(indices)));
+		}
+		default:
+		{
+			std::ostringstream msg;
+			msg << "expected an expression, found " << tok.kind;
+			_fail(msg.str());
+		}
+	}
+}
+
+CompUnit *parse_sysy(std::string_view src, utils::Arena &arena, SyntaxError &err)
+{
+	std::vector<Token> tokens;
+	tokens.reserve(src.size() / 4 + 1);
+	if(auto lex_err = tokenize(src, tokens); lex_err.has_value())
+	{
+		err = SyntaxError{lex_err->loc, lex_err->msg};
+		return nullptr;
+	}
+	return Parser(tokens, arena).parse(err);
+}
+
+} // namespace compiler_skeleton::sysy
@@ -0,0 +1,84 @@
+#ifndef SKELETON_PARSER_H
+#define SKELETON_PARSER_H
+
+/*
+ * A hand-written recursive-descent parser of SysY. It reads the token array
+ * produced by `tokenize()' and builds the AST (see ast.h) directly in an
+ * arena, which makes it an alternative to the bison driver in example.y.
+ *
+ * Expressions are parsed by precedence climbing, so each binary operator costs
+ * one loop iteration instead of one call per precedence level.
+ *
+ * Errors are not printed. Parsing stops at the first syntax error, and the
+ * error is returned to the caller.
+ *
+ * Example:
+ *     using namespace compiler_skeleton;
+ *     utils::Arena arena;
+ *     sysy::SyntaxError err;
+ *     sysy::CompUnit *unit = sysy::parse_sysy(source_text, arena, err);
+ *     if(unit == nullptr)
+ *         std::cerr << err.loc << ": " << err.msg << std::endl;
+ */
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+#include "lexer.h"
+#include "ast.h"
+
+namespace compiler_skeleton::sysy
+{
+
+struct SyntaxError
+{
+	SrcLoc loc;
+	std::string msg;
+};
+
+class Parser
+{
+  protected:
+	const std::vector<Token> &_tokens;
+	size_t _pos;
+	utils::Arena &_arena;
+
+	inline const Token &_peek(int off=0) const
+		{ return _tokens[std::min(_pos + off, _tokens.size() - 1)]; }
+	inline bool _at(TokenKind kind) const { return _peek().kind == kind; }
+	bool _accept(TokenKind kind);
+	const Token &_expect(TokenKind kind);
+	[[noreturn]] void _fail(const std::string &msg) const;
+
+	template<class T, class ...Args>
+	T *_make(Args &&...args) { return _arena.make<T>(std::forward<Args>(args)...); }
+
+	VarDeclStmt _parse_var_decl();
+	VarDef *_parse_var_def(bool is_const);
+	InitVal *_parse_init_val();
+	FuncDef *_parse_func_def();
+	FuncParam *_parse_func_param();
+	BlockStmt _parse_block();
+	Stmt *_parse_stmt();
+	Expr *_parse_expr(int min_prec=1);
+	Expr *_parse_unary();
+	Expr *_parse_primary();
+	ExprVec _parse_dims(bool allow_empty_first, bool &has_empty_first);
+
+  public:
+	Parser(const std::vector<Token> &tokens, utils::Arena &arena)
+	  : _tokens(tokens), _pos(0), _arena(arena) {}
+
+	// Parse the whole token array. Returns nullptr on a syntax error, which
+	// is then stored to `err'.
+	CompUnit *parse(SyntaxError &err);
+};
+
+// Tokenize and parse a SysY source.
+CompUnit *parse_sysy(std::string_view src, utils::Arena &arena, SyntaxError &err);
+
+} // namespace compiler_skeleton::sysy
+
+#endif
@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "profiler.h"
+
+namespace
+{
+
+using compiler_skeleton::utils::Statistic;
+using compiler_skeleton::utils::StatisticBlock;
+
+struct PhaseEvent
+{
+	const char *name;
+	int64_t start_ns, end_ns;
+	int tid;
+};
+
+struct ProfileData
+{
+	std::mutex mutex;
+	std::vector<PhaseEvent> events;
+	Statistic *statistics = nullptr;
+	int statistic_cnt = 0;
+	std::atomic<StatisticBlock *> blocks{nullptr};
+	int64_t start_ns = 0;
+	int thread_cnt = 0;
+};
+
+ProfileData &profile_data()
+{
+	static ProfileData data;
+	return data;
+}
+
+// A small, stable id for each thread, in the order they first record.
+int current_tid()
+{
+	thread_local int tid = -1;
+	if(tid < 0)
+	{
+		auto &data = profile_data();
+		std::lock_guard lock(data.mutex);
+		tid = data.thread_cnt++;
+	}
+	return tid;
+}
+
+// Escape a string for JSON. Names are plain identifiers in practice.
+void write_json_str(std::ostream &out, const char *str)
+{
+	out << '"';
+	for(const char *p = str; *p != '\0'; p++)
+	{
+		if(*p == '"' || *p == '\\')
+			out << '\\';
+		out << *p;
+	}
+	out << '"';
+}
+
+} // namespace
+
+namespace compiler_skeleton::utils
+{
+
+void enable_profiling(bool enabled)
+{
+	auto &data = profile_data();
+	if(enabled && data.start_ns == 0)
+		data.start_ns = profile_clock_ns();
+	profiling_on.store(enabled, std::memory_order_relaxed);
+}
+
+void record_phase(const char *name, int64_t start_ns, int64_t end_ns)
+{
+	int tid = current_tid();
+	auto &data = profile_data();
+	std::lock_guard lock(data.mutex);
+	data.events.push_back(PhaseEvent{name, start_ns, end_ns, tid});
+}
+
+StatisticBlock *register_thread_statistics()
+{
+	auto *block = new StatisticBlock;
+	for(auto &val : block->vals)
+		val.store(0, std::memory_order_relaxed);
+	auto &data = profile_data();
+	{
+		std::lock_guard lock(data.mutex);
+		block->next = data.blocks.load(std::memory_order_relaxed);
+		data.blocks.store(block, std::memory_order_release);
+	}
+	thread_statistics = block;
+	return block;
+}
+
+Statistic::Statistic(const char *group, const char *desc)
+  : _group(group), _desc(desc), _val(0)
+{
+	auto &data = profile_data();
+	std::lock_guard lock(data.mutex);
+	_idx = data.statistic_cnt < MAX_THREAD_STATISTICS? data.statistic_cnt++ : -1;
+	_next = data.statistics;
+	data.statistics = this;
+}
+
+uint64_t Statistic::value() const
+{
+	uint64_t res = _val.load(std::memory_order_relaxed);
+	if(_idx < 0)
+		return res;
+	// Blocks are only ever pushed to the front of the list, so walking it needs
+	// no lock.
+	auto &data = profile_data();
+	for(const StatisticBlock *block = data.blocks.load(std::memory_order_acquire);
+		block != nullptr; block = block->next)
+		res += block->vals[_idx].load(std::memory_order_relaxed);
+	return res;
+}
+
+void print_profile(std::ostream &out)
+{
+	auto &data = profile_data();
+	std::lock_guard lock(data.mutex);
+
+	// Phases with the same name are summed up. Nested phases are counted in
+	// their parents as well.
+	struct PhaseTotal { int64_t ns = 0; int calls = 0; };
+	std::map<std::string, PhaseTotal> totals;
+	for(const auto &e : data.events)
+	{
+		auto &total = totals[e.name];
+		total.ns += e.end_ns - e.start_ns;
+		total.calls++;
+	}
+
+	std::ios_base::fmtflags old_flags = out.flags();
+	std::streamsize old_precision = out.precision();
+	out << "===== compile time =====" << std::endl;
+	out << std::left << std::setw(32) << "phase" << std::right
+		<< std::setw(10) << "calls" << std::setw(14) << "total (ms)" << std::endl;
+	for(const auto &[name, total] : totals)
+	{
+		out << std::left << std::setw(32) << name << std::right
+			<< std::setw(10) << total.calls << std::setw(14) << std::fixed
+			<< std::setprecision(3) << total.ns / 1e6 << std::endl;
+	}
+
+	std::vector<const Statistic *> stats;
+	for(const Statistic *stat = data.statistics; stat != nullptr; stat = stat->next())
+		if(stat->value() != 0)
+			stats.push_back(stat);
+	std::sort(stats.begin(), stats.end(), [](const Statistic *a, const Statistic *b)
+	{
+		int cmp = strcmp(a->group(), b->group());
+		return cmp != 0? cmp < 0 : strcmp(a->desc(), b->desc()) < 0;
+	});
+
+	out << "===== statistics =====" << std::endl;
+	for(const Statistic *stat : stats)
+	{
+		std::string name = std::string(stat->group()) + ": " + stat->desc();
+		out << std::left << std::setw(48) << name << std::right
+			<< std::setw(14) << stat->value() << std::endl;
+	}
+	out.flags(old_flags);
+	out.precision(old_precision);
+}
+
+void write_chrome_trace(std::ostream &out)
+{
+	auto &data = profile_data();
+	std::lock_guard lock(data.mutex);
+	int64_t end_ns = data.start_ns;
+	std::ios_base::fmtflags old_flags = out.flags();
+	std::streamsize old_precision = out.precision();
+	out << std::fixed << std::setprecision(3);
+
+	out << "{\"traceEvents\":[";
+	bool first = true;
+	for(const auto &e : data.events)
+	{
+		out << (first? "\n" : ",\n") << "{\"name\":";
+		write_json_str(out, e.name);
+		out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.tid
+			<< ",\"ts\":" << (e.start_ns - data.start_ns) / 1000.0
+			<< ",\"dur\":" << (e.end_ns - e.start_ns) / 1000.0 << '}';
+		end_ns = std::max(end_ns, e.end_ns);
+		first = false;
+	}
+	// Statistics are reported as counters at the end of the trace.
+	for(const Statistic *stat = data.statistics; stat != nullptr; stat = stat->next())
+	{
+		if(stat->value() == 0)
+			continue;
+		std::string name = std::string(stat->group()) + ": " + stat->desc();
+		out << (first? "\n" : ",\n") << "{\"name\":";
+		write_json_str(out, name.c_str());
+		out << ",\"ph\":\"C\",\"pid\":1,\"ts\":" << (end_ns - data.start_ns) / 1000.0
+			<< ",\"args\":{\"value\":" << stat->value() << "}}";
+		first = false;
+	}
+	out << "\n]}" << std::endl;
+	out.flags(old_flags);
+	out.precision(old_precision);
+}
+
+} // namespace compiler_skeleton::utils
@@ -0,0 +1,147 @@
+#ifndef SKELETON_PROFILER_H
+#define SKELETON_PROFILER_H
+
+/*
+ * Compile-time instrumentation: scoped phase timers and named statistics.
+ *
+ * Profiling is off by default, in which case a timer or a statistic costs a
+ * single relaxed atomic load and a branch. Turn it on with
+ * `enable_profiling()' (the example driver does so for `--profile' and
+ * `--trace=FILE').
+ *
+ *  + ScopedTimer records the time spent in a scope as an event of the current
+ *    thread. Use it for phases and passes, not for tiny hot functions.
+ *  + Statistic is a named counter, defined once as a static object, e.g. the
+ *    number of statements in and out of a pass, Bitmap operations or
+ *    iterations to a fixpoint. Each thread counts in its own slot, and the
+ *    slots are summed up when the value is read, so incrementing a
+ *    statistic from parallel passes does not contend on a shared counter.
+ *    Increment it in hot paths freely.
+ *  + `print_profile()' prints the per-phase totals and all the statistics as
+ *    text, and `write_chrome_trace()' writes the events as a Chrome trace
+ *    (load it in chrome://tracing or Perfetto).
+ *
+ * Example:
+ *     using namespace compiler_skeleton::utils;
+ *     static Statistic stmts_removed("dce", "statements removed");
+ *     void run_dce(...)
+ *     {
+ *         ScopedTimer timer("dce");
+ *         ...
+ *         stmts_removed += cnt;
+ *     }
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+namespace compiler_skeleton::utils
+{
+
+inline std::atomic<bool> profiling_on{false};
+
+inline bool profiling_enabled()
+{
+	return profiling_on.load(std::memory_order_relaxed);
+}
+
+void enable_profiling(bool enabled=true);
+
+// Monotonic time in nanoseconds.
+inline int64_t profile_clock_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Record a finished phase [start_ns, end_ns) of the current thread.
+void record_phase(const char *name, int64_t start_ns, int64_t end_ns);
+
+class ScopedTimer
+{
+  protected:
+	const char *_name; // must be a string literal or outlive the report
+	int64_t _start_ns;
+	bool _active;
+
+  public:
+	ScopedTimer(const char *name)
+	  : _name(name), _start_ns(0), _active(profiling_enabled())
+	{
+		if(_active)
+			_start_ns = profile_clock_ns();
+	}
+	ScopedTimer(const ScopedTimer &) = delete;
+	ScopedTimer &operator = (const ScopedTimer &) = delete;
+	~ScopedTimer()
+	{
+		if(_active)
+			record_phase(_name, _start_ns, profile_clock_ns());
+	}
+};
+
+// The per-thread slots of the statistics. A block is only written by its own
+// thread, and is never freed so that the counts of finished threads are kept.
+constexpr int MAX_THREAD_STATISTICS = 256;
+struct StatisticBlock
+{
+	std::atomic<uint64_t> vals[MAX_THREAD_STATISTICS];
+	StatisticBlock *next; // all blocks form a linked list
+};
+
+inline thread_local StatisticBlock *thread_statistics = nullptr;
+
+// Create and register the block of the current thread.
+StatisticBlock *register_thread_statistics();
+
+class Statistic
+{
+  protected:
+	const char *_group, *_desc;
+	int _idx; // slot in the per-thread blocks, -1 if they are full
+	std::atomic<uint64_t> _val; // used instead of the slots if _idx is -1
+	Statistic *_next; // all statistics form a linked list
+
+  public:
+	// Statistics should be static objects, since they are never unregistered.
+	Statistic(const char *group, const char *desc);
+	Statistic(const Statistic &) = delete;
+	Statistic &operator = (const Statistic &) = delete;
+
+	inline void add(uint64_t n)
+	{
+		if(!profiling_enabled())
+			return;
+		if(_idx < 0)
+		{
+			_val.fetch_add(n, std::memory_order_relaxed);
+			return;
+		}
+		StatisticBlock *block = thread_statistics;
+		if(block == nullptr)
+			block = register_thread_statistics();
+		// Only this thread writes the slot, so no read-modify-write is needed.
+		auto &slot = block->vals[_idx];
+		slot.store(slot.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+	}
+	inline Statistic &operator ++ () { add(1); return *this; }
+	inline Statistic &operator += (uint64_t n) { add(n); return *this; }
+
+	const char *group() const { return _group; }
+	const char *desc() const { return _desc; }
+	uint64_t value() const; // the sum over all threads
+	const Statistic *next() const { return _next; }
+};
+
+// Print the total time of each phase and the non-zero statistics.
+void print_profile(std::ostream &out);
+
+// Write all the recorded phases (and the statistics as counters) in the
+// Chrome trace event format.
+void write_chrome_trace(std::ostream &out);
+
+} // namespace compiler_skeleton::utils
+
+#endif
@@ -0,0 +1,505 @@
+#include <charconv>
+#include <cstdint>
+#include <utility>
+#include "lambda_visitor.h"
+#include "riscv.h"
+
+namespace
+{
+
+using namespace compiler_skeleton::tigger;
+
+inline bool is_imm12(long long val)
+{
+	return val >= -2048 && val < 2048;
+}
+
+// Returns k if val == 2^k (k >= 1), or -1 otherwise.
+int log2_if_pow2(int val)
+{
+	if(val <= 1 || (val & (val - 1)) != 0)
+		return -1;
+	int k = 0;
+	while((1 << k) != val)
+		k++;
+	return k;
+}
+
+inline bool same_reg(const Reg &reg1, const Reg &reg2)
+{
+	return reg1.index() == reg2.index()
+		&& std::visit([](const auto &r) { return r.id; }, reg1)
+			== std::visit([](const auto &r) { return r.id; }, reg2);
+}
+
+inline int frame_size_of(int stack_size)
+{
+	return (stack_size / 4 + 1) * 16;
+}
+
+// Registers that are invisible to Tigger programs, so they are emitted by name.
+constexpr std::string_view RA_REG = "ra";
+constexpr std::string_view SP_REG = "sp";
+
+} // namespace
+
+namespace compiler_skeleton::riscv
+{
+
+using namespace tigger;
+using eeyore::BinaryOp;
+using eeyore::UnaryOp;
+
+RiscvEmitter::RiscvEmitter(std::ostream &out, Reg scratch)
+  : _out(out), _scratch(scratch), _frame_size(0), _after_tail_call(false)
+{
+	_buf.reserve(BUF_FLUSH_SIZE + 256);
+}
+
+RiscvEmitter::~RiscvEmitter()
+{
+	flush();
+}
+
+void RiscvEmitter::flush()
+{
+	_out.write(_buf.data(), _buf.size());
+	_buf.clear();
+}
+
+void RiscvEmitter::_flush_if_full()
+{
+	if(_buf.size() >= BUF_FLUSH_SIZE)
+		flush();
+}
+
+void RiscvEmitter::_emit(int val)
+{
+	char tmp[16];
+	auto [end, ec] = std::to_chars(tmp, tmp + sizeof(tmp), val);
+	_buf.append(tmp, end);
+}
+
+void RiscvEmitter::_emit(const Reg &reg)
+{
+	static utils::LambdaVisitor reg_prefix =
+	{
+		[](const ZeroReg &) { return 'x'; },
+		[](const CalleeSavedReg &) { return 's'; },
+		[](const CallerSavedReg &) { return 't'; },
+		[](const ArgReg &) { return 'a'; }
+	};
+	_emit(std::visit(reg_prefix, reg));
+	_emit(std::visit([](const auto &r) { return r.id; }, reg));
+}
+
+void RiscvEmitter::_emit(const Label &label)
+{
+	_emit(".l");
+	_emit(label.id);
+}
+
+void RiscvEmitter::_emit(const GlobalVar &var)
+{
+	_emit('v');
+	_emit(var.id);
+}
+
+void RiscvEmitter::_end_line()
+{
+	_emit('\n');
+	_flush_if_full();
+}
+
+template<class RegT, class BaseT>
+void RiscvEmitter::_mem_inst(std::string_view mnemonic, const RegT &reg,
+	int offset, const BaseT &base)
+{
+	if(is_imm12(offset))
+	{
+		_emit("  ");
+		_emit(mnemonic);
+		_emit(' ');
+		_emit(reg);
+		_emit(", ");
+		_emit(offset);
+		_emit('(');
+		_emit(base);
+		_emit(')');
+		_end_line();
+		return;
+	}
+	_inst("li", _scratch, offset);
+	_inst("add", _scratch, _scratch, base);
+	_mem_inst(mnemonic, reg, 0, _scratch);
+}
+
+void RiscvEmitter::_emit_sp_adjust(int delta)
+{
+	if(is_imm12(delta))
+		_inst("addi", SP_REG, SP_REG, delta);
+	else
+	{
+		_inst("li", _scratch, delta);
+		_inst("add", SP_REG, SP_REG, _scratch);
+	}
+}
+
+void RiscvEmitter::_emit_signed_div_pow2(const Reg &rd, const Reg &rs, int shift)
+{
+	// Signed division rounds towards zero, so add (2^k - 1) to negative
+	// dividends before shifting.
+	const Reg &tmp = same_reg(rd, rs)? _scratch : rd;
+	_inst("srai", tmp, rs, 31);
+	_inst("srli", tmp, tmp, 32 - shift);
+	_inst("add", tmp, tmp, rs);
+	_inst("srai", rd, tmp, shift);
+}
+
+void RiscvEmitter::_emit_binary_imm(BinaryOp op, const Reg &rd, const Reg &rs, int imm)
+{
+	int shift = log2_if_pow2(imm);
+	switch(op)
+	{
+		case BinaryOp::ADD:
+			if(is_imm12(imm))
+				return _inst("addi", rd, rs, imm);
+			break;
+		case BinaryOp::SUB:
+			if(imm != INT32_MIN && is_imm12(-imm))
+				return _inst("addi", rd, rs, -imm);
+			break;
+		case BinaryOp::MUL:
+			if(imm == 0)
+				return _inst("li", rd, 0);
+			if(imm == 1)
+				return _inst("mv", rd, rs);
+			if(imm == -1)
+				return _inst("neg", rd, rs);
+			if(shift > 0)
+				return _inst("slli", rd, rs, shift);
+			break;
+		case BinaryOp::DIV:
+			if(imm == 1)
+				return _inst("mv", rd, rs);
+			if(imm == -1)
+				return _inst("neg", rd, rs);
+			if(shift > 0)
+				return _emit_signed_div_pow2(rd, rs, shift);
+			break;
+		case BinaryOp::MOD:
+			if(imm == 1 || imm == -1)
+				return _inst("li", rd, 0);
+			if(shift > 0 && !same_reg(rd, rs))
+			{
+				// rd = rs - ((rs / 2^k) << k)
+				_emit_signed_div_pow2(_scratch, rs, shift);
+				_inst("slli", _scratch, _scratch, shift);
+				return _inst("sub", rd, rs, _scratch);
+			}
+			break;
+		case BinaryOp::LT:
+			if(is_imm12(imm))
+				return _inst("slti", rd, rs, imm);
+			break;
+		case BinaryOp::GE:
+			if(is_imm12(imm))
+			{
+				_inst("slti", rd, rs, imm);
+				return _inst("xori", rd, rd, 1);
+			}
+			break;
+		case BinaryOp::LE:
+			if(is_imm12(imm + 1ll))
+				return _inst("slti", rd, rs, imm + 1);
+			break;
+		case BinaryOp::GT:
+			if(is_imm12(imm + 1ll))
+			{
+				_inst("slti", rd, rs, imm + 1);
+				return _inst("xori", rd, rd, 1);
+			}
+			break;
+		case BinaryOp::EQ:
+		case BinaryOp::NE:
+			if(imm == 0)
+				return _inst(op == BinaryOp::EQ? "seqz" : "snez", rd, rs);
+			if(imm != INT32_MIN && is_imm12(-imm))
+			{
+				_inst("addi", rd, rs, -imm);
+				return _inst(op == BinaryOp::EQ? "seqz" : "snez", rd, rd);
+			}
+			break;
+		case BinaryOp::AND:
+			if(imm == 0)
+				return _inst("li", rd, 0);
+			return _inst("snez", rd, rs);
+		case BinaryOp::OR:
+			if(imm != 0)
+				return _inst("li", rd, 1);
+			return _inst("snez", rd, rs);
+	}
+
+	// Fall back to a register-register operation.
+	const Reg &tmp = same_reg(rd, rs)? _scratch : rd;
+	_inst("li", tmp, imm);
+	_emit_binary_reg(op, rd, rs, tmp);
+}
+
+void RiscvEmitter::_emit_binary_reg(BinaryOp op, const Reg &rd,
+	const Reg &rs1, const Reg &rs2)
+{
+	switch(op)
+	{
+		case BinaryOp::ADD: return _inst("add", rd, rs1, rs2);
+		case BinaryOp::SUB: return _inst("sub", rd, rs1, rs2);
+		case BinaryOp::MUL: return _inst("mul", rd, rs1, rs2);
+		case BinaryOp::DIV: return _inst("div", rd, rs1, rs2);
+		case BinaryOp::MOD: return _inst("rem", rd, rs1, rs2);
+		case BinaryOp::LT: return _inst("slt", rd, rs1, rs2);
+		case BinaryOp::GT: return _inst("sgt", rd, rs1, rs2);
+		case BinaryOp::LE:
+			_inst("sgt", rd, rs1, rs2);
+			return _inst("seqz", rd, rd);
+		case BinaryOp::GE:
+			_inst("slt", rd, rs1, rs2);
+			return _inst("seqz", rd, rd);
+		case BinaryOp::EQ:
+			_inst("xor", rd, rs1, rs2);
+			return _inst("seqz", rd, rd);
+		case BinaryOp::NE:
+			_inst("xor", rd, rs1, rs2);
+			return _inst("snez", rd, rd);
+		case BinaryOp::OR:
+			_inst("or", rd, rs1, rs2);
+			return _inst("snez", rd, rd);
+		case BinaryOp::AND:
+		{
+			// rd = (-(a != 0) & b) != 0, where b is an operand that does not
+			// alias rd, so no scratch register is needed.
+			if(same_reg(rd, rs1) && same_reg(rd, rs2))
+				return _inst("snez", rd, rd);
+			const Reg &a = same_reg(rd, rs2)? rs2 : rs1;
+			const Reg &b = same_reg(rd, rs2)? rs1 : rs2;
+			_inst("snez", rd, a);
+			_inst("neg", rd, rd);
+			_inst("and", rd, rd, b);
+			return _inst("snez", rd, rd);
+		}
+	}
+}
+
+void RiscvEmitter::operator() (const GlobalVarDeclStmt &stmt)
+{
+	_emit("  .global "); _emit(stmt.var); _end_line();
+	_emit("  .section .sdata"); _end_line();
+	_emit("  .align 2"); _end_line();
+	_emit("  .type "); _emit(stmt.var); _emit(", @object"); _end_line();
+	_emit("  .size "); _emit(stmt.var); _emit(", 4"); _end_line();
+	_emit(stmt.var); _emit(':'); _end_line();
+	_emit("  .word "); _emit(stmt.initial_val); _end_line();
+}
+
+void RiscvEmitter::operator() (const GlobalArrDeclStmt &stmt)
+{
+	if(stmt.init == nullptr)
+	{
+		_emit("  .comm "); _emit(stmt.var); _emit(", "); _emit(stmt.size);
+		_emit(", 4"); _end_line();
+		return;
+	}
+	_emit("  .global "); _emit(stmt.var); _end_line();
+	_emit("  .section .data"); _end_line();
+	_emit("  .align 2"); _end_line();
+	_emit("  .type "); _emit(stmt.var); _emit(", @object"); _end_line();
+	_emit("  .size "); _emit(stmt.var); _emit(", "); _emit(stmt.size); _end_line();
+	_emit(stmt.var); _emit(':'); _end_line();
+	_emit_init_data(*stmt.init, stmt.size);
+}
+
+void RiscvEmitter::_emit_init_data(const eeyore::InitData &data, int size)
+{
+	// Runs of words become .word lines, and zero spans become .zero
+	// directives, so the object size does not grow with the zeros.
+	static constexpr int WORDS_PER_LINE = 16;
+	int next_offset = 0;
+	for(const auto &run : data.runs)
+	{
+		if(run.offset > next_offset)
+		{
+			_emit("  .zero "); _emit((run.offset - next_offset) * 4); _end_line();
+		}
+		for(int i = 0; i < run.len; i++)
+		{
+			_emit(i % WORDS_PER_LINE == 0? "  .word " : ", ");
+			_emit(data.vals[run.val_idx + i]);
+			if(i % WORDS_PER_LINE == WORDS_PER_LINE - 1 || i == run.len - 1)
+				_end_line();
+		}
+		next_offset = run.offset + run.len;
+	}
+	if(size > next_offset * 4)
+	{
+		_emit("  .zero "); _emit(size - next_offset * 4); _end_line();
+	}
+}
+
+void RiscvEmitter::operator() (const FuncHeaderStmt &stmt)
+{
+	std::string_view name = stmt.func_name.str();
+	_frame_size = frame_size_of(stmt.stack_size);
+	_emit("  .text"); _end_line();
+	_emit("  .align 2"); _end_line();
+	_emit("  .global "); _emit(name); _end_line();
+	_emit("  .type "); _emit(name); _emit(", @function"); _end_line();
+	_emit(name); _emit(':'); _end_line();
+	_emit_sp_adjust(-_frame_size);
+	_mem_inst("sw", RA_REG, _frame_size - 4, SP_REG);
+	_after_tail_call = false;
+}
+
+void RiscvEmitter::operator() (const FuncEndStmt &stmt)
+{
+	std::string_view name = stmt.func_name.str();
+	_emit("  .size "); _emit(name); _emit(", .-"); _emit(name); _end_line();
+}
+
+void RiscvEmitter::operator() (const tigger::UnaryOpStmt &stmt)
+{
+	switch(stmt.op_type)
+	{
+		case UnaryOp::NEG: return _inst("neg", stmt.opr, stmt.opr1);
+		case UnaryOp::NOT: return _inst("seqz", stmt.opr, stmt.opr1);
+	}
+}
+
+void RiscvEmitter::operator() (const tigger::BinaryOpStmt &stmt)
+{
+	if(std::holds_alternative<int>(stmt.opr2))
+		_emit_binary_imm(stmt.op_type, stmt.opr, stmt.opr1, std::get<int>(stmt.opr2));
+	else
+		_emit_binary_reg(stmt.op_type, stmt.opr, stmt.opr1, std::get<Reg>(stmt.opr2));
+}
+
+void RiscvEmitter::operator() (const tigger::MoveStmt &stmt)
+{
+	if(std::holds_alternative<int>(stmt.opr1))
+		_inst("li", stmt.opr, std::get<int>(stmt.opr1));
+	else
+		_inst("mv", stmt.opr, std::get<Reg>(stmt.opr1));
+}
+
+void RiscvEmitter::operator() (const tigger::ReadArrStmt &stmt)
+{
+	_mem_inst("lw", stmt.opr, stmt.idx, stmt.opr1);
+}
+
+void RiscvEmitter::operator() (const tigger::WriteArrStmt &stmt)
+{
+	_mem_inst("sw", stmt.opr, stmt.idx, stmt.opr1);
+}
+
+void RiscvEmitter::operator() (const tigger::CondGotoStmt &stmt)
+{
+	std::string_view mnemonic;
+	switch(stmt.op_type)
+	{
+		case BinaryOp::LT: mnemonic = "blt"; break;
+		case BinaryOp::GT: mnemonic = "bgt"; break;
+		case BinaryOp::LE: mnemonic = "ble"; break;
+		case BinaryOp::GE: mnemonic = "bge"; break;
+		case BinaryOp::EQ: mnemonic = "beq"; break;
+		case BinaryOp::NE: mnemonic = "bne"; break;
+		default: // Arithmetic conditions are not valid in Tigger.
+			_emit_binary_reg(stmt.op_type, _scratch, stmt.opr1, stmt.opr2);
+			return _inst("bnez", _scratch, stmt.goto_label);
+	}
+	_inst(mnemonic, stmt.opr1, stmt.opr2, stmt.goto_label);
+}
+
+void RiscvEmitter::operator() (const tigger::GotoStmt &stmt)
+{
+	_inst("j", stmt.goto_label);
+}
+
+void RiscvEmitter::operator() (const tigger::LabelStmt &stmt)
+{
+	_emit(stmt.label);
+	_emit(':');
+	_end_line();
+}
+
+void RiscvEmitter::operator() (const tigger::FuncCallStmt &stmt)
+{
+	if(!stmt.is_tail)
+		return _inst("call", stmt.func_name.str());
+	_mem_inst("lw", RA_REG, _frame_size - 4, SP_REG);
+	_emit_sp_adjust(_frame_size);
+	_inst("tail", stmt.func_name.str());
+	_after_tail_call = true;
+}
+
+void RiscvEmitter::operator() (const tigger::ReturnStmt &stmt)
+{
+	if(std::exchange(_after_tail_call, false))
+		return;
+	_mem_inst("lw", RA_REG, _frame_size - 4, SP_REG);
+	_emit_sp_adjust(_frame_size);
+	_emit("  ret");
+	_end_line();
+}
+
+void RiscvEmitter::operator() (const tigger::StoreStmt &stmt)
+{
+	_mem_inst("sw", stmt.opr, stmt.stack_offset * 4, SP_REG);
+}
+
+void RiscvEmitter::operator() (const tigger::LoadStmt &stmt)
+{
+	if(std::holds_alternative<int>(stmt.src))
+		return _mem_inst("lw", stmt.opr, std::get<int>(stmt.src) * 4, SP_REG);
+	const GlobalVar &var = std::get<GlobalVar>(stmt.src);
+	_emit("  lui "); _emit(stmt.opr); _emit(", %hi("); _emit(var); _emit(')');
+	_end_line();
+	_emit("  lw "); _emit(stmt.opr); _emit(", %lo("); _emit(var); _emit(")(");
+	_emit(stmt.opr); _emit(')');
+	_end_line();
+}
+
+void RiscvEmitter::operator() (const tigger::LoadAddrStmt &stmt)
+{
+	if(std::holds_alternative<int>(stmt.src))
+	{
+		int offset = std::get<int>(stmt.src) * 4;
+		if(is_imm12(offset))
+			return _inst("addi", stmt.opr, SP_REG, offset);
+		_inst("li", stmt.opr, offset);
+		return _inst("add", stmt.opr, stmt.opr, SP_REG);
+	}
+	_inst("la", stmt.opr, std::get<GlobalVar>(stmt.src));
+}
+
+} // namespace compiler_skeleton::riscv
+
+/*
+
+Test case (also serve as an example):
+
+int main()
+{
+	using namespace compiler_skeleton::tigger;
+	std::vector<TiggerStatement> stmts;
+	stmts.push_back(GlobalVarDeclStmt(GlobalVar(0), 5));
+	stmts.push_back(FuncHeaderStmt("main", 0, 2));
+	stmts.push_back(LoadStmt(CallerSavedReg(0), GlobalVar(0)));
+	stmts.push_back(BinaryOpStmt(CallerSavedReg(1), CallerSavedReg(0), BinaryOp::MUL, 8));
+	stmts.push_back(BinaryOpStmt(CallerSavedReg(1), CallerSavedReg(1), BinaryOp::DIV, 4));
+	stmts.push_back(StoreStmt(1, CallerSavedReg(1)));
+	stmts.push_back(LoadStmt(ArgReg(0), 1));
+	stmts.push_back(ReturnStmt());
+	stmts.push_back(FuncEndStmt("main"));
+	compiler_skeleton::riscv::emit_riscv(std::cout, stmts);
+	return 0;
+}
+
+*/
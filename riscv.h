@@ -0,0 +1,138 @@
+#ifndef SKELETON_RISCV_H
+#define SKELETON_RISCV_H
+
+/*
+ * Lowering from Tigger statements to RV32IM assembly.
+ *
+ * The emitter is a visitor over TiggerStatement, just like TiggerPrinter, but
+ * it writes the assembly text into an internal buffer that is only handed to
+ * the std::ostream in large blocks (when the buffer is full, on `flush()' and
+ * on destruction).
+ *
+ * Instruction selection:
+ *  + `reg = reg op int' uses the I-type form (addi, slti, xori, ...) when the
+ *    immediate fits in 12 bits, and multiplication, division and modulo by a
+ *    power of two are turned into shifts.
+ *  + Everything else falls back to materializing the immediate with `li'.
+ *    When the destination register is also the source register, this needs a
+ *    scratch register, which the register allocator must keep free.
+ *
+ * Global arrays with initial data (see eeyore::InitData) are emitted into
+ * .data, with .zero directives for the zero spans; the others are .comm.
+ *
+ * Stack frame: a function with `stack_size' slots (in words) gets a frame of
+ * STK = (stack_size / 4 + 1) * 16 bytes. Slot i of StoreStmt/LoadStmt/
+ * LoadAddrStmt lives at i*4(sp), and ra is saved at STK-4(sp). A tail call
+ * pops the frame and jumps to the callee with `tail', so the callee returns
+ * to our caller.
+ *
+ * Example:
+ *     using namespace compiler_skeleton;
+ *     std::vector<tigger::TiggerStatement> stmts = ...;
+ *     riscv::emit_riscv(std::cout, stmts);
+ */
+
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <variant>
+#include "profiler.h"
+#include "tigger.h"
+
+namespace compiler_skeleton::riscv
+{
+
+class RiscvEmitter
+{
+  protected:
+	std::ostream &_out;
+	std::string _buf;
+	tigger::Reg _scratch;
+	int _frame_size; // STK of the function being emitted.
+	bool _after_tail_call; // the ReturnStmt after a tail call is not reached
+
+	static constexpr size_t BUF_FLUSH_SIZE = 1 << 16;
+
+	// Low-level emission helpers.
+	inline void _emit(std::string_view str) { _buf.append(str); }
+	inline void _emit(char ch) { _buf.push_back(ch); }
+	void _emit(int val);
+	void _emit(const tigger::Reg &reg);
+	void _emit(const tigger::Label &label);
+	void _emit(const tigger::GlobalVar &var);
+	void _end_line();
+
+	// Emit a whole instruction with 1~3 operands, e.g. "  add a0, a1, a2".
+	template<class T1, class ...Ts>
+	void _inst(std::string_view mnemonic, const T1 &opr1, const Ts &...oprs)
+	{
+		_emit("  ");
+		_emit(mnemonic);
+		_emit(' ');
+		_emit(opr1);
+		((_emit(", "), _emit(oprs)), ...);
+		_end_line();
+	}
+
+	// Memory access "op reg, offset(base)", taking care of offsets that do
+	// not fit in 12 bits. The registers are Tigger registers or the names of
+	// the ones Tigger cannot refer to (ra, sp).
+	template<class RegT, class BaseT>
+	void _mem_inst(std::string_view mnemonic, const RegT &reg,
+		int offset, const BaseT &base);
+
+	// Select instructions for `rd = rs op imm'.
+	void _emit_binary_imm(eeyore::BinaryOp op, const tigger::Reg &rd,
+		const tigger::Reg &rs, int imm);
+	void _emit_binary_reg(eeyore::BinaryOp op, const tigger::Reg &rd,
+		const tigger::Reg &rs1, const tigger::Reg &rs2);
+	void _emit_signed_div_pow2(const tigger::Reg &rd, const tigger::Reg &rs,
+		int shift);
+	void _emit_sp_adjust(int delta);
+	// Initialized global arrays go to .data instead of .comm.
+	void _emit_init_data(const eeyore::InitData &data, int size);
+
+	void _flush_if_full();
+
+  public:
+	// `scratch' is only used for the cases listed above that need an extra
+	// register. By default it is t6.
+	RiscvEmitter(std::ostream &out,
+		tigger::Reg scratch=tigger::CallerSavedReg(6));
+	~RiscvEmitter();
+
+	// Write everything buffered so far to the output stream.
+	void flush();
+
+	void operator() (const tigger::GlobalVarDeclStmt &stmt);
+	void operator() (const tigger::GlobalArrDeclStmt &stmt);
+	void operator() (const tigger::FuncHeaderStmt &stmt);
+	void operator() (const tigger::FuncEndStmt &stmt);
+	void operator() (const tigger::UnaryOpStmt &stmt);
+	void operator() (const tigger::BinaryOpStmt &stmt);
+	void operator() (const tigger::MoveStmt &stmt);
+	void operator() (const tigger::ReadArrStmt &stmt);
+	void operator() (const tigger::WriteArrStmt &stmt);
+	void operator() (const tigger::CondGotoStmt &stmt);
+	void operator() (const tigger::GotoStmt &stmt);
+	void operator() (const tigger::LabelStmt &stmt);
+	void operator() (const tigger::FuncCallStmt &stmt);
+	void operator() (const tigger::ReturnStmt &stmt);
+	void operator() (const tigger::StoreStmt &stmt);
+	void operator() (const tigger::LoadStmt &stmt);
+	void operator() (const tigger::LoadAddrStmt &stmt);
+};
+
+// Emit a container (e.g. vector, list ...) of TiggerStatements as assembly.
+template<class Container>
+void emit_riscv(std::ostream &out, const Container &stmts)
+{
+	utils::ScopedTimer timer("emit riscv");
+	RiscvEmitter emitter{out};
+	for(const auto &stmt : stmts)
+		std::visit(emitter, stmt);
+}
+
+} // namespace compiler_skeleton::riscv
+
+#endif
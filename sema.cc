@@ -0,0 +1,618 @@
+#include <algorithm>
+#include <deque>
+#include <new>
+#include <optional>
+#include <sstream>
+#include <unordered_map>
+#include "arena.h"
+#include "const_eval.h"
+#include "lambda_visitor.h"
+#include "profiler.h"
+#include "sema.h"
+
+namespace
+{
+
+using namespace compiler_skeleton::sysy;
+using compiler_skeleton::utils::Symbol;
+
+compiler_skeleton::utils::Statistic funcs_checked("sema", "functions checked");
+compiler_skeleton::utils::Statistic diags_reported("sema", "diagnostics");
+compiler_skeleton::utils::Statistic exprs_folded("sema", "expressions folded");
+
+struct VarInfo: public ConstValue
+{
+	size_t item_idx; // index of the global declaration in the CompUnit
+
+	VarInfo(TypePtr _type, size_t _item_idx)
+	  : ConstValue{std::move(_type), std::nullopt, nullptr}, item_idx(_item_idx) {}
+};
+
+struct FuncInfo
+{
+	TypePtr type;
+	size_t item_idx;
+	bool is_runtime; // provided by the SysY runtime library
+};
+
+// The global scope. It is built by phase 1 and only read by phase 2.
+struct GlobalScope
+{
+	std::unordered_map<Symbol, VarInfo> vars;
+	std::unordered_map<Symbol, FuncInfo> funcs;
+};
+
+void add_runtime_funcs(GlobalScope &globals)
+{
+	// Types are interned for the whole program, so the signatures are built
+	// once and shared by all the units (a compile server checks many).
+	static const std::vector<std::pair<Symbol, FuncInfo>> runtime_funcs = []()
+	{
+		std::vector<std::pair<Symbol, FuncInfo>> funcs;
+		TypePtr int_arr = make_ptr(make_int());
+		auto add = [&](const char *name, TypePtr retval_type, std::vector<TypePtr> arg_types)
+		{
+			funcs.emplace_back(Symbol(name), FuncInfo{
+				make_func(retval_type, arg_types.begin(), arg_types.end()), 0, true});
+		};
+		add("getint", make_int(), {});
+		add("getch", make_int(), {});
+		add("getarray", make_int(), {int_arr});
+		add("putint", make_void(), {make_int()});
+		add("putch", make_void(), {make_int()});
+		add("putarray", make_void(), {make_int(), int_arr});
+		add("starttime", make_void(), {});
+		add("stoptime", make_void(), {});
+		return funcs;
+	}();
+	globals.funcs.insert(runtime_funcs.begin(), runtime_funcs.end());
+}
+
+// Checks the declarations and statements of one global item. Nothing outside
+// the item is written, so checkers of different functions can run at once.
+class Checker: public ConstScope
+{
+  protected:
+	const GlobalScope &_globals;
+	size_t _item_idx; // only the globals declared before this item are visible
+	const FuncDef *_func; // nullptr for global declarations
+	std::vector<std::unordered_map<Symbol, VarInfo>> _scopes;
+	int _loop_depth;
+	std::vector<Diagnostic> &_diags;
+	// Data of local const arrays, which only the checker needs.
+	std::deque<compiler_skeleton::eeyore::InitData> _local_data;
+
+	void _error(SrcLoc loc, const std::string &msg) { _diags.push_back(Diagnostic{loc, msg}); }
+
+	const VarInfo *_lookup_var(Symbol name) const;
+	const FuncInfo *_lookup_func(Symbol name) const;
+
+	// Each returns the type of the expression (also stored in the AST), or
+	// nullptr if it is erroneous, in which case an error has been reported.
+	// Constant int expressions are folded into NumberExprs unless `fold' is
+	// false.
+	TypePtr _check_expr(Expr &expr, bool fold=true);
+	TypePtr _check_lval(LValExpr &expr);
+	TypePtr _check_call(CallExpr &expr);
+	TypePtr _check_int_expr(Expr &expr, const char *what);
+
+	std::optional<int> _eval_const_expr(Expr &expr, const char *what);
+	TypePtr _check_dims(const ExprVec &dims, TypePtr base_type);
+	void _check_init_val(InitVal &init, bool need_const);
+	compiler_skeleton::eeyore::InitData *_flatten_arr_init(VarDef &def, const TypePtr &type,
+		bool is_const, bool is_global);
+	template<class LeafFunc>
+	bool _flatten_init(InitVal &list, const std::vector<int> &strides, size_t level,
+		int &pos, SrcLoc loc, const LeafFunc &leaf);
+
+	void _check_stmt(Stmt &stmt);
+	void _check_block(BlockStmt &block, bool new_scope);
+
+  public:
+	Checker(const GlobalScope &globals, size_t item_idx, const FuncDef *func,
+		std::vector<Diagnostic> &diags)
+	  : _globals(globals), _item_idx(item_idx), _func(func), _loop_depth(0), _diags(diags) {}
+
+	const ConstValue *lookup_const(Symbol name) const override { return _lookup_var(name); }
+
+	// Check a variable definition, returning what the scope should know about
+	// it. Global variables need constant initializers.
+	VarInfo check_var_def(VarDef &def, bool is_const, bool is_global);
+	// Set the types of the parameters and of the function.
+	void check_signature(FuncDef &func);
+	void check_body(FuncDef &func);
+};
+
+const VarInfo *Checker::_lookup_var(Symbol name) const
+{
+	for(auto scope = _scopes.rbegin(); scope != _scopes.rend(); ++scope)
+		if(auto iter = scope->find(name); iter != scope->end())
+			return &iter->second;
+	auto iter = _globals.vars.find(name);
+	if(iter != _globals.vars.end() && iter->second.item_idx <= _item_idx)
+		return &iter->second;
+	return nullptr;
+}
+
+const FuncInfo *Checker::_lookup_func(Symbol name) const
+{
+	auto iter = _globals.funcs.find(name);
+	if(iter == _globals.funcs.end())
+		return nullptr;
+	const FuncInfo &info = iter->second;
+	// A function may call itself.
+	if(info.is_runtime || info.item_idx <= _item_idx)
+		return &info;
+	return nullptr;
+}
+
+TypePtr Checker::_check_expr(Expr &expr, bool fold)
+{
+	TypePtr type = std::visit(compiler_skeleton::utils::LambdaVisitor
+	{
+		[](NumberExpr &e) { return make_int(true); },
+		[this](LValExpr &e) { return _check_lval(e); },
+		[this](CallExpr &e) { return _check_call(e); },
+		[this](UnaryExpr &e)
+		{
+			TypePtr opr_type = _check_expr(*e.opr);
+			if(opr_type == nullptr)
+				return e.type = nullptr;
+			if(!can_operate(opr_type, opr_type))
+			{
+				_error(e.loc, "invalid operand of a unary operator");
+				return e.type = nullptr;
+			}
+			return e.type = common_type(opr_type, opr_type);
+		},
+		[this](BinaryExpr &e)
+		{
+			TypePtr type1 = _check_expr(*e.opr1), type2 = _check_expr(*e.opr2);
+			if(type1 == nullptr || type2 == nullptr)
+				return e.type = nullptr;
+			if(!can_operate(type1, type2))
+			{
+				_error(e.loc, "invalid operands of a binary operator");
+				return e.type = nullptr;
+			}
+			return e.type = common_type(type1, type2);
+		}
+	}, expr);
+
+	// Sub-expressions have been folded already, so this does not go deep.
+	if(fold && type != nullptr && is_int(type) && is_const_type(type)
+		&& !std::holds_alternative<NumberExpr>(expr))
+	{
+		if(auto val = eval_const(expr, *this); val.has_value())
+		{
+			expr = NumberExpr(loc_of(expr), val.value());
+			++exprs_folded;
+		}
+	}
+	return type;
+}
+
+TypePtr Checker::_check_lval(LValExpr &expr)
+{
+	const VarInfo *var = _lookup_var(expr.name);
+	if(var == nullptr)
+	{
+		_error(expr.loc, "use of undeclared variable '" + std::string(expr.name.str()) + "'");
+		return expr.type = nullptr;
+	}
+	TypePtr type = var->type;
+	bool ok = true;
+	for(Expr *idx : expr.indices)
+	{
+		if(_check_int_expr(*idx, "array index") == nullptr)
+			ok = false;
+		if(is_arr(type))
+			type = type->element_type();
+		else if(is_ptr(type))
+			type = type->base_type();
+		else
+		{
+			_error(expr.loc, "subscripted value '" + std::string(expr.name.str())
+				+ "' is not an array");
+			return expr.type = nullptr;
+		}
+	}
+	return expr.type = ok? type : nullptr;
+}
+
+TypePtr Checker::_check_call(CallExpr &expr)
+{
+	const FuncInfo *func = _lookup_func(expr.func_name);
+	std::string name(expr.func_name.str());
+	bool ok = true;
+	std::vector<TypePtr> arg_types;
+	for(Expr *arg : expr.args)
+	{
+		arg_types.push_back(_check_expr(*arg));
+		ok = ok && arg_types.back() != nullptr;
+	}
+	if(func == nullptr)
+	{
+		_error(expr.loc, "call to undeclared function '" + name + "'");
+		return expr.type = nullptr;
+	}
+
+	const TypePtr &func_type = func->type;
+	if(func_type->arg_cnt() != static_cast<int>(expr.args.size()))
+	{
+		std::ostringstream msg;
+		msg << "function '" << name << "' takes " << func_type->arg_cnt()
+			<< " argument(s), but " << expr.args.size() << " given";
+		_error(expr.loc, msg.str());
+		return expr.type = nullptr;
+	}
+	for(size_t i = 0; i < arg_types.size(); i++)
+	{
+		if(arg_types[i] != nullptr && !can_accept(func_type->arg_type(i), arg_types[i]))
+		{
+			std::ostringstream msg;
+			msg << "argument " << i + 1 << " of '" << name << "' has type "
+				<< arg_types[i] << ", but " << func_type->arg_type(i) << " is expected";
+			_error(loc_of(*expr.args[i]), msg.str());
+			ok = false;
+		}
+	}
+	return expr.type = ok? func_type->retval_type() : nullptr;
+}
+
+TypePtr Checker::_check_int_expr(Expr &expr, const char *what)
+{
+	TypePtr type = _check_expr(expr);
+	if(type != nullptr && !is_int(type))
+	{
+		_error(loc_of(expr), std::string(what) + " is not an int");
+		return nullptr;
+	}
+	return type;
+}
+
+std::optional<int> Checker::_eval_const_expr(Expr &expr, const char *what)
+{
+	if(_check_int_expr(expr, what) == nullptr)
+		return std::nullopt;
+	auto val = eval_const(expr, *this);
+	if(!val.has_value())
+		_error(loc_of(expr), std::string(what) + " is not a constant expression");
+	return val;
+}
+
+// Build `base_type[d1][d2]...' for constant dimensions. Returns nullptr if any
+// dimension is invalid.
+TypePtr Checker::_check_dims(const ExprVec &dims, TypePtr base_type)
+{
+	std::vector<int> lens;
+	for(Expr *dim : dims)
+	{
+		auto len = _eval_const_expr(*dim, "array dimension");
+		if(!len.has_value())
+			return nullptr;
+		if(len.value() <= 0)
+		{
+			_error(loc_of(*dim), "array dimension is not positive");
+			return nullptr;
+		}
+		lens.push_back(len.value());
+	}
+	return make_arr(base_type, lens.begin(), lens.end());
+}
+
+void Checker::_check_init_val(InitVal &init, bool need_const)
+{
+	if(!init.is_list())
+	{
+		if(need_const)
+			_eval_const_expr(*init.expr, "initializer");
+		else
+			_check_int_expr(*init.expr, "initializer");
+		return;
+	}
+	for(InitVal *elem : init.elems)
+		_check_init_val(*elem, need_const);
+}
+
+// Walk the leaves of an initializer list of an array, calling `leaf(offset,
+// expr)' with the word offset of each of them. `strides[l]' is the number of
+// words of a level `l' sub-array. As in C, a nested list initializes the
+// largest sub-array that starts at the current offset. Returns false if the
+// list does not fit.
+template<class LeafFunc>
+bool Checker::_flatten_init(InitVal &list, const std::vector<int> &strides, size_t level,
+	int &pos, SrcLoc loc, const LeafFunc &leaf)
+{
+	int start = pos;
+	for(InitVal *elem : list.elems)
+	{
+		if(pos >= start + strides[level])
+		{
+			_error(loc, "excess elements in array initializer");
+			return false;
+		}
+		if(!elem->is_list())
+		{
+			leaf(pos++, *elem->expr);
+			continue;
+		}
+		size_t sub_level = level + 1;
+		while(sub_level < strides.size() && (pos - start) % strides[sub_level] != 0)
+			sub_level++;
+		if(sub_level == strides.size())
+		{
+			_error(loc, "braces around scalar initializer");
+			return false;
+		}
+		int sub_start = pos;
+		if(!_flatten_init(*elem, strides, sub_level, pos, loc, leaf))
+			return false;
+		pos = sub_start + strides[sub_level];
+	}
+	return true;
+}
+
+compiler_skeleton::eeyore::InitData *Checker::_flatten_arr_init(VarDef &def,
+	const TypePtr &type, bool is_const, bool is_global)
+{
+	using compiler_skeleton::eeyore::InitData;
+	std::vector<int> strides;
+	for(TypePtr sub_type = type; is_arr(sub_type); sub_type = sub_type->element_type())
+		strides.push_back(sub_type->size() / 4);
+
+	// Global arrays keep their data in the unit for code generation. Local
+	// const arrays only need it for folding their elements here, and other
+	// local arrays are initialized by code, but their lists are still checked.
+	InitData *data = nullptr;
+	if(is_global)
+	{
+		auto res = compiler_skeleton::utils::unit_resource();
+		data = ::new(res->allocate(sizeof(InitData), alignof(InitData))) InitData(strides[0], res);
+	}
+	else if(is_const)
+		data = &_local_data.emplace_back(strides[0], std::pmr::new_delete_resource());
+	int pos = 0;
+	bool ok = _flatten_init(*def.init, strides, 0, pos, def.loc, [&](int offset, Expr &expr)
+	{
+		if(data == nullptr)
+			return;
+		if(auto val = eval_const(expr, *this); val.has_value())
+			data->set(offset, val.value());
+	});
+	return ok && data != nullptr && !data->all_zero()? data : nullptr;
+}
+
+VarInfo Checker::check_var_def(VarDef &def, bool is_const, bool is_global)
+{
+	VarInfo info(nullptr, _item_idx);
+	TypePtr type = _check_dims(def.dims, make_int(is_const));
+	if(type == nullptr)
+		return info;
+	if(def.init != nullptr)
+	{
+		bool need_const = is_const || is_global;
+		if(is_int(type) && def.init->is_list())
+			_error(def.loc, "scalar '" + std::string(def.name.str())
+				+ "' is initialized with a list");
+		else if(is_arr(type) && !def.init->is_list())
+			_error(def.loc, "array '" + std::string(def.name.str())
+				+ "' is initialized with an expression");
+		else
+		{
+			_check_init_val(*def.init, need_const);
+			if(is_arr(type))
+			{
+				auto data = _flatten_arr_init(def, type, is_const, is_global);
+				if(is_global)
+					def.init_data = data;
+				if(is_const)
+					info.data = data;
+			}
+		}
+		if(is_const && is_int(type) && !def.init->is_list())
+			info.scalar = eval_const(*def.init->expr, *this);
+	}
+	info.type = def.type = type;
+	return info;
+}
+
+void Checker::check_signature(FuncDef &func)
+{
+	std::vector<TypePtr> arg_types;
+	for(FuncParam *param : func.params)
+	{
+		TypePtr type = make_int();
+		if(param->is_ptr)
+		{
+			TypePtr base_type = _check_dims(param->dims, make_int());
+			type = base_type != nullptr? make_ptr(base_type) : nullptr;
+		}
+		param->type = type;
+		arg_types.push_back(type != nullptr? type : make_int());
+	}
+	func.type = make_func(func.retval_type, arg_types.begin(), arg_types.end());
+}
+
+void Checker::check_body(FuncDef &func)
+{
+	_scopes.emplace_back();
+	for(FuncParam *param : func.params)
+	{
+		if(param->type == nullptr)
+			continue;
+		if(!_scopes.back().emplace(param->name, VarInfo(param->type, 0)).second)
+			_error(param->loc, "redefinition of parameter '" + std::string(param->name.str()) + "'");
+	}
+	// The parameters and the outermost block share one scope.
+	_check_block(*func.body, false);
+	_scopes.pop_back();
+}
+
+void Checker::_check_block(BlockStmt &block, bool new_scope)
+{
+	if(new_scope)
+		_scopes.emplace_back();
+	for(Stmt *stmt : block.stmts)
+		_check_stmt(*stmt);
+	if(new_scope)
+		_scopes.pop_back();
+}
+
+void Checker::_check_stmt(Stmt &stmt)
+{
+	std::visit(compiler_skeleton::utils::LambdaVisitor
+	{
+		[this](VarDeclStmt &s)
+		{
+			for(VarDef *def : s.defs)
+			{
+				VarInfo info = check_var_def(*def, s.is_const, false);
+				if(info.type != nullptr && !_scopes.back().emplace(def->name, info).second)
+					_error(def->loc, "redefinition of '" + std::string(def->name.str()) + "'");
+			}
+		},
+		[this](AssignStmt &s)
+		{
+			TypePtr lval_type = _check_expr(*s.lval, false);
+			TypePtr rval_type = _check_int_expr(*s.rval, "assigned value");
+			if(lval_type == nullptr || rval_type == nullptr)
+				return;
+			if(!is_int(lval_type))
+				_error(s.loc, "assignment to an array");
+			else if(is_const_type(lval_type))
+				_error(s.loc, "assignment to a constant");
+		},
+		[this](ExprStmt &s)
+		{
+			if(s.expr != nullptr)
+				_check_expr(*s.expr);
+		},
+		[this](BlockStmt &s) { _check_block(s, true); },
+		[this](IfStmt &s)
+		{
+			_check_int_expr(*s.cond, "condition");
+			_check_stmt(*s.then_stmt);
+			if(s.else_stmt != nullptr)
+				_check_stmt(*s.else_stmt);
+		},
+		[this](WhileStmt &s)
+		{
+			_check_int_expr(*s.cond, "condition");
+			_loop_depth++;
+			_check_stmt(*s.body);
+			_loop_depth--;
+		},
+		[this](BreakStmt &s)
+		{
+			if(_loop_depth == 0)
+				_error(s.loc, "break statement not within a loop");
+		},
+		[this](ContinueStmt &s)
+		{
+			if(_loop_depth == 0)
+				_error(s.loc, "continue statement not within a loop");
+		},
+		[this](ReturnStmt &s)
+		{
+			bool returns_void = is_void(_func->retval_type);
+			if(s.retval == nullptr)
+			{
+				if(!returns_void)
+					_error(s.loc, "non-void function should return a value");
+			}
+			else if(returns_void)
+				_error(s.loc, "void function should not return a value");
+			else
+				_check_int_expr(*s.retval, "return value");
+		}
+	}, stmt);
+}
+
+} // namespace
+
+namespace compiler_skeleton::sysy
+{
+
+std::vector<Diagnostic> analyze(CompUnit &unit, utils::ThreadPool &pool)
+{
+	utils::ScopedTimer timer("sema");
+	GlobalScope globals;
+	std::vector<Diagnostic> diags;
+	std::vector<std::pair<FuncDef *, size_t>> funcs; // and their item indices
+	add_runtime_funcs(globals);
+
+	// Phase 1: global declarations and function signatures.
+	{
+		utils::ScopedTimer phase_timer("sema: globals");
+		for(size_t idx = 0; idx < unit.items.size(); idx++)
+		{
+			Checker checker(globals, idx, nullptr, diags);
+			if(auto decl = std::get_if<VarDeclStmt *>(&unit.items[idx]))
+			{
+				for(VarDef *def : (*decl)->defs)
+				{
+					VarInfo info = checker.check_var_def(*def, (*decl)->is_const, true);
+					if(info.type == nullptr)
+						continue;
+					if(globals.funcs.count(def->name) != 0
+						|| !globals.vars.emplace(def->name, info).second)
+					{
+						diags.push_back(Diagnostic{def->loc,
+							"redefinition of '" + std::string(def->name.str()) + "'"});
+					}
+				}
+				continue;
+			}
+
+			FuncDef *func = std::get<FuncDef *>(unit.items[idx]);
+			checker.check_signature(*func);
+			if(globals.vars.count(func->name) != 0
+				|| !globals.funcs.emplace(func->name, FuncInfo{func->type, idx, false}).second)
+			{
+				diags.push_back(Diagnostic{func->loc,
+					"redefinition of '" + std::string(func->name.str()) + "'"});
+				continue;
+			}
+			funcs.emplace_back(func, idx);
+		}
+		auto main_iter = globals.funcs.find(utils::Symbol("main"));
+		if(main_iter == globals.funcs.end())
+			diags.push_back(Diagnostic{SrcLoc(1, 1), "no main function"});
+		else if(!is_int(main_iter->second.type->retval_type())
+			|| main_iter->second.type->arg_cnt() != 0)
+		{
+			diags.push_back(Diagnostic{SrcLoc(1, 1), "main should be `int main()'"});
+		}
+	}
+
+	// Phase 2: function bodies.
+	{
+		utils::ScopedTimer phase_timer("sema: functions");
+		std::vector<std::vector<Diagnostic>> func_diags(funcs.size());
+		pool.parallel_for(funcs.size(), [&](size_t i)
+		{
+			auto [func, idx] = funcs[i];
+			Checker(globals, idx, func, func_diags[i]).check_body(*func);
+			++funcs_checked;
+		});
+		for(auto &d : func_diags)
+			diags.insert(diags.end(), std::make_move_iterator(d.begin()),
+				std::make_move_iterator(d.end()));
+	}
+
+	// Within a function (or phase 1), diagnostics are already in a fixed
+	// order, so a stable sort gives the same result for any thread count.
+	std::stable_sort(diags.begin(), diags.end(), [](const Diagnostic &a, const Diagnostic &b)
+		{ return a.loc.line != b.loc.line? a.loc.line < b.loc.line : a.loc.col < b.loc.col; });
+	diags_reported += diags.size();
+	return diags;
+}
+
+std::vector<Diagnostic> analyze(CompUnit &unit)
+{
+	utils::ThreadPool pool(1);
+	return analyze(unit, pool);
+}
+
+} // namespace compiler_skeleton::sysy
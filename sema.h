@@ -0,0 +1,58 @@
+#ifndef SKELETON_SEMA_H
+#define SKELETON_SEMA_H
+
+/*
+ * Semantic analysis of SysY: name resolution and type checking of the AST
+ * built by the parser. It fills in the `type' fields of the AST and reports
+ * all the errors it finds. The constant initializers of global arrays are also
+ * flattened into `VarDef::init_data' (see eeyore::InitData), taken from the
+ * unit resource of the calling thread.
+ *
+ * Constant int expressions (see const_eval.h) are folded in place: the Expr
+ * node becomes a NumberExpr, except for the left-hand sides of assignments.
+ *
+ * The analysis runs in two phases:
+ *  1. The global declarations and the signatures of all the functions are
+ *     checked serially, in source order. This builds the global scope, which
+ *     is never written afterwards.
+ *  2. The bodies of the functions are checked concurrently on a thread pool.
+ *     A function body only reads the global scope and the (interned, thread
+ *     safe) types, and only writes the AST nodes of its own body.
+ *
+ * As in C, a name is only visible after its declaration, even though phase 1
+ * knows every signature up front. The SysY runtime functions (getint, putint,
+ * ...) are always visible.
+ *
+ * Diagnostics of each function are collected separately and merged by source
+ * location, so the result does not depend on the number of threads.
+ *
+ * Example:
+ *     using namespace compiler_skeleton;
+ *     utils::ThreadPool pool;
+ *     for(const auto &diag : sysy::analyze(*unit, pool))
+ *         std::cerr << diag.loc << ": " << diag.msg << std::endl;
+ */
+
+#include <string>
+#include <vector>
+#include "thread_pool.h"
+#include "ast.h"
+
+namespace compiler_skeleton::sysy
+{
+
+struct Diagnostic
+{
+	SrcLoc loc;
+	std::string msg;
+};
+
+// Check `unit', checking the function bodies on `pool'. Returns the errors
+// sorted by location; the AST is well-typed if there are none.
+std::vector<Diagnostic> analyze(CompUnit &unit, utils::ThreadPool &pool);
+// Same as above, but on the calling thread only.
+std::vector<Diagnostic> analyze(CompUnit &unit);
+
+} // namespace compiler_skeleton::sysy
+
+#endif
@@ -0,0 +1,97 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "profiler.h"
+#include "source_file.h"
+
+namespace
+{
+
+compiler_skeleton::utils::Statistic files_mapped("source file", "files mapped");
+compiler_skeleton::utils::Statistic files_read("source file", "files read into buffers");
+compiler_skeleton::utils::Statistic bytes_in("source file", "bytes of source");
+
+} // namespace
+
+namespace compiler_skeleton::utils
+{
+
+bool SourceFile::_map(int fd, size_t size)
+{
+	// Reserve zeroed pages for the text and the padding, then map the file
+	// over them. The tail of the last page of the file reads as zeros as well.
+	size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	size_t map_size = (size + PADDING + page - 1) / page * page;
+	void *base = mmap(nullptr, map_size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(base == MAP_FAILED)
+		return false;
+	if(mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+	{
+		munmap(base, map_size);
+		return false;
+	}
+	madvise(base, size, MADV_SEQUENTIAL);
+	_data = static_cast<char *>(base);
+	_size = size;
+	_map_size = map_size;
+	++files_mapped;
+	return true;
+}
+
+bool SourceFile::_read(int fd)
+{
+	_buf.clear();
+	for(size_t len = 0; ; )
+	{
+		_buf.resize(len + 65536);
+		ssize_t got = read(fd, _buf.data() + len, _buf.size() - len);
+		if(got < 0)
+			return false;
+		if(got == 0)
+		{
+			_size = len;
+			break;
+		}
+		len += got;
+	}
+	_buf.resize(_size);
+	_buf.resize(_size + PADDING, '\0');
+	_data = _buf.data();
+	++files_read;
+	return true;
+}
+
+bool SourceFile::open(const char *filename)
+{
+	ScopedTimer timer("open source");
+	close();
+	int fd = filename != nullptr? ::open(filename, O_RDONLY) : STDIN_FILENO;
+	if(fd < 0)
+		return false;
+	struct stat st;
+	bool ok = fstat(fd, &st) == 0;
+	if(ok)
+	{
+		ok = (S_ISREG(st.st_mode) && st.st_size > 0 && _map(fd, st.st_size)) || _read(fd);
+		if(!ok)
+			close();
+	}
+	if(filename != nullptr)
+		::close(fd);
+	bytes_in += _size;
+	return ok;
+}
+
+void SourceFile::close()
+{
+	if(_map_size != 0)
+		munmap(_data, _map_size);
+	_buf.clear();
+	_buf.shrink_to_fit();
+	_data = nullptr;
+	_size = _map_size = 0;
+}
+
+} // namespace compiler_skeleton::utils
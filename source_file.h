@@ -0,0 +1,62 @@
+#ifndef SKELETON_SOURCE_FILE_H
+#define SKELETON_SOURCE_FILE_H
+
+/*
+ * Read-only access to a whole source file, memory-mapped when possible.
+ *
+ * A regular file is mapped privately instead of being read, so opening it
+ * costs no copy, and the pages are shared with the page cache until they are
+ * written. Other inputs (stdin, pipes) and empty files are read into a buffer.
+ *
+ * Either way the text is followed by PADDING zero bytes, and the buffer may
+ * be written (a write never reaches the file). This is what flex wants from
+ * `yy_scan_buffer()', so a scanner can run on the mapping directly.
+ *
+ * Example:
+ *     using compiler_skeleton::utils::SourceFile;
+ *     SourceFile file;
+ *     if(!file.open(filename)) // nullptr for stdin
+ *         ... // cannot read the file
+ *     std::string_view src = file.text();
+ */
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+namespace compiler_skeleton::utils
+{
+
+class SourceFile
+{
+  protected:
+	char *_data;
+	size_t _size;
+	size_t _map_size; // 0 if the text is in `_buf' instead
+	std::vector<char> _buf;
+
+	bool _map(int fd, size_t size);
+	bool _read(int fd);
+
+  public:
+	static constexpr size_t PADDING = 2;
+
+	SourceFile(): _data(nullptr), _size(0), _map_size(0) {}
+	~SourceFile() { close(); }
+	SourceFile(const SourceFile &) = delete;
+	SourceFile &operator = (const SourceFile &) = delete;
+
+	// Open the file `filename', or stdin if it is nullptr, closing the one
+	// opened before. Returns false if the file cannot be read.
+	bool open(const char *filename);
+	void close();
+
+	// The text, followed by PADDING zero bytes.
+	char *data() { return _data; }
+	size_t size() const { return _size; }
+	std::string_view text() const { return std::string_view(_data, _size); }
+};
+
+} // namespace compiler_skeleton::utils
+
+#endif
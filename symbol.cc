@@ -0,0 +1,146 @@
+#include <cassert>
+#include <mutex>
+#include "symbol.h"
+
+namespace
+{
+
+inline int block_of(uint32_t id, int first_block_bits, uint32_t &offset)
+{
+	uint32_t v = (id >> first_block_bits) + 1;
+	int block = 31 - __builtin_clz(v);
+	offset = id - (((1u << block) - 1) << first_block_bits);
+	return block;
+}
+
+} // namespace
+
+namespace compiler_skeleton::utils
+{
+
+Symbol::Symbol(): _id(0) {}
+
+Symbol::Symbol(std::string_view str): _id(symbol_table().intern(str)) {}
+
+SymbolTable::SymbolTable(): _size(0), _index(1024, 0)
+{
+	for(auto &block : _blocks)
+		block.store(nullptr, std::memory_order_relaxed);
+	intern(""); // id 0, i.e. the default symbol.
+}
+
+SymbolTable::~SymbolTable()
+{
+	for(auto &block : _blocks)
+		delete[] block.load(std::memory_order_relaxed);
+}
+
+uint32_t SymbolTable::_hash_str(std::string_view str)
+{
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for(char ch : str)
+	{
+		hash ^= static_cast<unsigned char>(ch);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+bool SymbolTable::_find(std::string_view str, uint32_t hash, uint32_t &id) const
+{
+	size_t mask = _index.size() - 1;
+	for(size_t i = hash & mask; _index[i] != 0; i = (i + 1) & mask)
+	{
+		const Entry &e = entry(_index[i] - 1);
+		if(e.hash == hash && std::string_view(e.str, e.len) == str)
+		{
+			id = _index[i] - 1;
+			return true;
+		}
+	}
+	return false;
+}
+
+void SymbolTable::_grow_index()
+{
+	std::vector<uint32_t> new_index(_index.size() * 2, 0);
+	size_t mask = new_index.size() - 1;
+	for(uint32_t slot : _index)
+	{
+		if(slot == 0)
+			continue;
+		size_t i = entry(slot - 1).hash & mask;
+		while(new_index[i] != 0)
+			i = (i + 1) & mask;
+		new_index[i] = slot;
+	}
+	_index.swap(new_index);
+}
+
+uint32_t SymbolTable::_insert(std::string_view str, uint32_t hash)
+{
+	uint32_t id = _size, offset;
+	int block = block_of(id, FIRST_BLOCK_BITS, offset);
+	assert(block < MAX_BLOCK_CNT);
+	Entry *entries = _blocks[block].load(std::memory_order_relaxed);
+	if(entries == nullptr)
+	{
+		entries = new Entry[size_t(1) << (FIRST_BLOCK_BITS + block)];
+		_blocks[block].store(entries, std::memory_order_release);
+	}
+
+	char *copy = static_cast<char *>(_strings.allocate(str.size() + 1, 1));
+	str.copy(copy, str.size());
+	copy[str.size()] = '\0';
+	entries[offset] = Entry{copy, static_cast<uint32_t>(str.size()), hash};
+	_size++;
+
+	if(_size * 2 > _index.size())
+		_grow_index();
+	size_t mask = _index.size() - 1, i = hash & mask;
+	while(_index[i] != 0)
+		i = (i + 1) & mask;
+	_index[i] = id + 1;
+	return id;
+}
+
+uint32_t SymbolTable::intern(std::string_view str)
+{
+	uint32_t hash = _hash_str(str), id;
+	{
+		std::shared_lock lock(_mutex);
+		if(_find(str, hash, id))
+			return id;
+	}
+	std::unique_lock lock(_mutex);
+	if(_find(str, hash, id))
+		return id;
+	return _insert(str, hash);
+}
+
+const SymbolTable::Entry &SymbolTable::entry(uint32_t id) const
+{
+	uint32_t offset;
+	int block = block_of(id, FIRST_BLOCK_BITS, offset);
+	return _blocks[block].load(std::memory_order_acquire)[offset];
+}
+
+uint32_t SymbolTable::size() const
+{
+	std::shared_lock lock(_mutex);
+	return _size;
+}
+
+SymbolTable &symbol_table()
+{
+	static SymbolTable table;
+	return table;
+}
+
+std::ostream &operator << (std::ostream &out, const Symbol &sym)
+{
+	return out << sym.str();
+}
+
+} // namespace compiler_skeleton::utils
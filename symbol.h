@@ -0,0 +1,121 @@
+#ifndef SKELETON_SYMBOL_H
+#define SKELETON_SYMBOL_H
+
+/*
+ * Interned strings (symbols) for identifiers and function names.
+ *
+ * Every distinct string is stored exactly once in a global table and is named
+ * by a stable 32-bit id, so a Symbol is as cheap to copy, compare and hash as
+ * an int. The hash of the string is computed once when it is interned.
+ *
+ *  + Build a Symbol from a string (`Symbol("main")'); equal strings always
+ *    give the same id.
+ *  + `str()' gives back the string and `hash()' the precomputed hash.
+ *  + The table is thread-safe: interning takes a lock only on a miss in the
+ *    hash index, and `str()'/`hash()' never lock.
+ *
+ * Example:
+ *     using compiler_skeleton::utils::Symbol;
+ *     Symbol a("foo"), b(std::string("foo"));
+ *     std::cout << (a == b) << ' ' << a << std::endl; // "1 foo"
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "arena.h"
+
+namespace compiler_skeleton::utils
+{
+
+class Symbol
+{
+  protected:
+	uint32_t _id;
+
+  public:
+	Symbol(); // The empty string.
+	Symbol(std::string_view str);
+	Symbol(const char *str): Symbol(std::string_view(str)) {}
+	Symbol(const std::string &str): Symbol(std::string_view(str)) {}
+
+	static Symbol from_id(uint32_t id) { Symbol sym; sym._id = id; return sym; }
+
+	uint32_t id() const { return _id; }
+	std::string_view str() const;
+	uint32_t hash() const;
+
+	bool operator == (const Symbol &other) const { return _id == other._id; }
+	bool operator != (const Symbol &other) const { return _id != other._id; }
+	bool operator < (const Symbol &other) const { return _id < other._id; }
+};
+
+class SymbolTable
+{
+  public:
+	struct Entry
+	{
+		const char *str;
+		uint32_t len;
+		uint32_t hash;
+	};
+
+  protected:
+	// Entries live in blocks of geometrically growing sizes, so that an id can
+	// be mapped to its entry without locking, and existing entries never move.
+	static constexpr int FIRST_BLOCK_BITS = 10;
+	static constexpr int MAX_BLOCK_CNT = 32 - FIRST_BLOCK_BITS;
+
+	std::atomic<Entry *> _blocks[MAX_BLOCK_CNT];
+	uint32_t _size;
+	std::vector<uint32_t> _index; // open addressing, stores id+1 (0 = empty)
+	Arena _strings;
+	mutable std::shared_mutex _mutex;
+
+	static uint32_t _hash_str(std::string_view str);
+	bool _find(std::string_view str, uint32_t hash, uint32_t &id) const;
+	uint32_t _insert(std::string_view str, uint32_t hash);
+	void _grow_index();
+
+  public:
+	SymbolTable();
+	SymbolTable(const SymbolTable &) = delete;
+	SymbolTable &operator = (const SymbolTable &) = delete;
+	~SymbolTable();
+
+	uint32_t intern(std::string_view str);
+	const Entry &entry(uint32_t id) const;
+	uint32_t size() const;
+};
+
+// The table shared by all the symbols.
+SymbolTable &symbol_table();
+
+inline std::string_view Symbol::str() const
+{
+	const auto &e = symbol_table().entry(_id);
+	return std::string_view(e.str, e.len);
+}
+
+inline uint32_t Symbol::hash() const
+{
+	return symbol_table().entry(_id).hash;
+}
+
+std::ostream &operator << (std::ostream &out, const Symbol &sym);
+
+} // namespace compiler_skeleton::utils
+
+template<>
+struct std::hash<compiler_skeleton::utils::Symbol>
+{
+	size_t operator() (const compiler_skeleton::utils::Symbol &sym) const
+		{ return sym.hash(); }
+};
+
+#endif
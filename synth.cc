@@ -0,0 +1,545 @@
+#include <algorithm>
+#include <queue>
+#include <random>
+#include <sstream>
+#include "synth.h"
+
+namespace
+{
+
+using namespace compiler_skeleton;
+using synth::SysYGenOptions;
+using synth::EeyoreGenOptions;
+
+const int GLOBAL_SCALAR_CNT = 4;
+
+std::string func_name(int idx)
+{
+	return "func" + std::to_string(idx);
+}
+
+// Pick `cnt' positions in [0, range), sorted, possibly with duplicates.
+std::vector<int> random_positions(std::mt19937 &rng, int cnt, int range)
+{
+	std::vector<int> pos(cnt);
+	for(auto &p : pos)
+		p = range > 0? rng() % range : 0;
+	std::sort(pos.begin(), pos.end());
+	return pos;
+}
+
+class SysYGenerator
+{
+  protected:
+	std::ostream &_out;
+	const SysYGenOptions &_opts;
+	std::mt19937 _rng;
+
+	// State of the function being generated.
+	int _func_idx;
+	int _stmt_idx, _stmt_budget;
+	std::vector<int> _call_pos; // statement indices where calls are made
+	size_t _next_call;
+	std::vector<int> _loop_counters; // of the enclosing while loops
+	int _counter_cnt;
+
+	inline int _rand(int n) { return n > 0? static_cast<int>(_rng() % n) : 0; }
+	inline bool _chance(int percent) { return _rand(100) < percent; }
+	void _indent(int depth) { for(int i = 0; i <= depth; i++) _out << "  "; }
+
+	void _gen_arr_decl_dims(bool is_param);
+	void _gen_arr_access(bool use_param);
+	void _gen_expr(int depth);
+	void _gen_cond(int depth);
+	void _gen_call(int depth);
+	void _gen_block(int depth, int max_stmts);
+	void _gen_stmt(int depth);
+	void _gen_func(int idx);
+
+  public:
+	SysYGenerator(std::ostream &out, const SysYGenOptions &opts)
+	  : _out(out), _opts(opts), _rng(opts.seed), _func_idx(0), _stmt_idx(0),
+		_stmt_budget(0), _next_call(0), _counter_cnt(0) {}
+
+	void generate();
+};
+
+void SysYGenerator::_gen_arr_decl_dims(bool is_param)
+{
+	for(int i = 0; i < _opts.arr_dims; i++)
+	{
+		if(i == 0 && is_param)
+			_out << "[]";
+		else
+			_out << "[N]";
+	}
+}
+
+// An element of the global array or of the array parameter. Indices are
+// constants, or counters of the enclosing loops, which never reach N.
+void SysYGenerator::_gen_arr_access(bool use_param)
+{
+	_out << (use_param? "a" : "arr");
+	for(int i = 0; i < _opts.arr_dims; i++)
+	{
+		if(!_loop_counters.empty() && _chance(50))
+			_out << "[w" << _loop_counters[_rand(_loop_counters.size())] << ']';
+		else
+			_out << '[' << _rand(_opts.arr_dim_len) << ']';
+	}
+}
+
+void SysYGenerator::_gen_expr(int depth)
+{
+	if(depth >= _opts.max_expr_depth || _chance(30))
+	{
+		switch(_rand(6))
+		{
+			case 0: _out << _rand(1000); break;
+			case 1: _out << 'n'; break;
+			case 2: _out << 'g' << _rand(GLOBAL_SCALAR_CNT); break;
+			case 3:
+				if(_opts.arr_dims > 0)
+				{
+					_gen_arr_access(_chance(50));
+					break;
+				}
+				[[fallthrough]];
+			default: _out << 'v' << _rand(_opts.local_cnt);
+		}
+		return;
+	}
+	switch(_rand(8))
+	{
+		case 0:
+			_out << '-';
+			_gen_expr(depth + 1);
+			break;
+		case 1:
+		case 2:
+			// Divisors are non-zero constants.
+			_out << '(';
+			_gen_expr(depth + 1);
+			_out << (_chance(50)? " / " : " % ") << _rand(99) + 1 << ')';
+			break;
+		default:
+			_out << '(';
+			_gen_expr(depth + 1);
+			_out << " " << "+-*"[_rand(3)] << " ";
+			_gen_expr(depth + 1);
+			_out << ')';
+	}
+}
+
+void SysYGenerator::_gen_cond(int depth)
+{
+	static const char *REL_OPS[] = {"<", ">", "<=", ">=", "==", "!="};
+	if(depth < 2 && _chance(30))
+	{
+		_gen_cond(depth + 1);
+		_out << (_chance(50)? " && " : " || ");
+		_gen_cond(depth + 1);
+		return;
+	}
+	if(_chance(10))
+		_out << '!';
+	_gen_expr(_opts.max_expr_depth - 1);
+	_out << ' ' << REL_OPS[_rand(6)] << ' ';
+	_gen_expr(_opts.max_expr_depth - 1);
+}
+
+// `vK = funcJ(expr, arr);' for a random earlier function J.
+void SysYGenerator::_gen_call(int depth)
+{
+	_indent(depth);
+	_out << 'v' << _rand(_opts.local_cnt) << " = " << func_name(_rand(_func_idx)) << '(';
+	_gen_expr(1);
+	if(_opts.arr_dims > 0)
+		_out << (_chance(50)? ", a" : ", arr");
+	_out << ");\n";
+}
+
+void SysYGenerator::_gen_block(int depth, int max_stmts)
+{
+	int cnt = 1 + _rand(max_stmts);
+	for(int i = 0; i < cnt && _stmt_budget > 0; i++)
+		_gen_stmt(depth);
+}
+
+void SysYGenerator::_gen_stmt(int depth)
+{
+	_stmt_budget--;
+	int idx = _stmt_idx++;
+	if(_func_idx > 0 && _next_call < _call_pos.size() && _call_pos[_next_call] <= idx)
+	{
+		// Several calls may fall on the same position.
+		while(_next_call < _call_pos.size() && _call_pos[_next_call] <= idx)
+		{
+			_gen_call(depth);
+			_next_call++;
+		}
+		return;
+	}
+
+	int choice = _rand(100);
+	if(depth < _opts.max_nesting && choice < 10)
+	{
+		_indent(depth);
+		_out << "if (";
+		_gen_cond(0);
+		_out << ") {\n";
+		_gen_block(depth + 1, 8);
+		_indent(depth);
+		if(_chance(50))
+		{
+			_out << "} else {\n";
+			_gen_block(depth + 1, 8);
+			_indent(depth);
+		}
+		_out << "}\n";
+	}
+	else if(depth < _opts.max_nesting && choice < 18)
+	{
+		// while loops run at most N times, and `continue' is never used so
+		// that the counter is always increased.
+		int counter = _counter_cnt++;
+		_indent(depth);
+		_out << "{\n";
+		_indent(depth + 1);
+		_out << "int w" << counter << " = 0;\n";
+		_indent(depth + 1);
+		_out << "while (w" << counter << " < " << 1 + _rand(_opts.arr_dim_len) << ") {\n";
+		_loop_counters.push_back(counter);
+		_gen_block(depth + 2, 8);
+		if(_chance(20))
+		{
+			_indent(depth + 2);
+			_out << "if (";
+			_gen_cond(0);
+			_out << ") break;\n";
+		}
+		_loop_counters.pop_back();
+		_indent(depth + 2);
+		_out << 'w' << counter << " = w" << counter << " + 1;\n";
+		_indent(depth + 1);
+		_out << "}\n";
+		_indent(depth);
+		_out << "}\n";
+	}
+	else if(_opts.arr_dims > 0 && choice < 35)
+	{
+		_indent(depth);
+		_gen_arr_access(_chance(50));
+		_out << " = ";
+		_gen_expr(0);
+		_out << ";\n";
+	}
+	else if(choice < 38)
+	{
+		_indent(depth);
+		_out << 'g' << _rand(GLOBAL_SCALAR_CNT) << " = ";
+		_gen_expr(0);
+		_out << ";\n";
+	}
+	else
+	{
+		_indent(depth);
+		_out << 'v' << _rand(_opts.local_cnt) << " = ";
+		_gen_expr(0);
+		_out << ";\n";
+	}
+}
+
+void SysYGenerator::_gen_func(int idx)
+{
+	_func_idx = idx;
+	_stmt_idx = 0;
+	_stmt_budget = _opts.stmts_per_func;
+	_call_pos = random_positions(_rng, _opts.calls_per_func, _opts.stmts_per_func);
+	_next_call = 0;
+	_counter_cnt = 0;
+
+	_out << "int " << func_name(idx) << "(int n";
+	if(_opts.arr_dims > 0)
+	{
+		_out << ", int a";
+		_gen_arr_decl_dims(true);
+	}
+	_out << ") {\n";
+	for(int i = 0; i < _opts.local_cnt; i++)
+		_out << "  int v" << i << " = " << (i == 0? "n" : std::to_string(i)) << ";\n";
+	while(_stmt_budget > 0)
+		_gen_stmt(0);
+	_out << "  return v0;\n}\n";
+}
+
+void SysYGenerator::generate()
+{
+	_out << "const int N = " << _opts.arr_dim_len << ";\n";
+	for(int i = 0; i < GLOBAL_SCALAR_CNT; i++)
+		_out << "int g" << i << " = " << i << ";\n";
+	if(_opts.arr_dims > 0)
+	{
+		_out << "int arr";
+		_gen_arr_decl_dims(false);
+		_out << ";\n";
+	}
+	for(int i = 0; i < _opts.func_cnt; i++)
+		_gen_func(i);
+
+	_out << "int main() {\n  int r = getint();\n";
+	if(_opts.func_cnt > 0)
+	{
+		_out << "  r = " << func_name(_opts.func_cnt - 1) << "(r"
+			<< (_opts.arr_dims > 0? ", arr" : "") << ");\n";
+	}
+	_out << "  putint(r);\n  return 0;\n}\n";
+}
+
+template<class Container>
+class EeyoreGenerator
+{
+  protected:
+	Container &_stmts;
+	const EeyoreGenOptions &_opts;
+	std::mt19937 _rng;
+	int _orig_var_cnt, _label_cnt;
+
+	// State of the function being generated.
+	int _first_local;
+	std::vector<int> _placed_labels;
+	using PendingLabel = std::pair<int, int>; // (position, label id)
+	std::priority_queue<PendingLabel, std::vector<PendingLabel>, std::greater<PendingLabel>> _pending;
+
+	static const int ARR_VAR_ID = GLOBAL_SCALAR_CNT; // T4 is the global array
+
+	inline int _rand(int n) { return n > 0? static_cast<int>(_rng() % n) : 0; }
+	inline bool _chance(int percent) { return _rand(100) < percent; }
+
+	eeyore::Operand _rand_dst();
+	eeyore::Operand _rand_opr();
+	eeyore::Operand _rand_idx();
+	void _gen_branch(int pos);
+	void _gen_stmt(int pos, int func_idx, const std::vector<int> &call_pos, size_t &next_call);
+	void _gen_call(int func_idx);
+	void _gen_func(int idx);
+
+  public:
+	EeyoreGenerator(Container &stmts, const EeyoreGenOptions &opts)
+	  : _stmts(stmts), _opts(opts), _rng(opts.seed), _orig_var_cnt(0), _label_cnt(0),
+		_first_local(0) {}
+
+	void generate();
+};
+
+template<class Container>
+eeyore::Operand EeyoreGenerator<Container>::_rand_dst()
+{
+	using namespace eeyore;
+	if(_chance(70))
+		return TempVar(_rand(_opts.temp_cnt));
+	if(_chance(80))
+		return OrigVar(_first_local + _rand(_opts.local_cnt));
+	return OrigVar(_rand(GLOBAL_SCALAR_CNT));
+}
+
+template<class Container>
+eeyore::Operand EeyoreGenerator<Container>::_rand_opr()
+{
+	using namespace eeyore;
+	switch(_rand(5))
+	{
+		case 0: return _rand(1000);
+		case 1: return Param(0);
+		default: return _rand_dst();
+	}
+}
+
+// A word-aligned byte offset into an array.
+template<class Container>
+eeyore::Operand EeyoreGenerator<Container>::_rand_idx()
+{
+	if(_chance(50))
+		return 4 * _rand(_opts.arr_size);
+	return eeyore::TempVar(_rand(_opts.temp_cnt));
+}
+
+// A conditional branch, either backwards to a label already placed (a loop),
+// or forwards to a label placed a few statements later.
+template<class Container>
+void EeyoreGenerator<Container>::_gen_branch(int pos)
+{
+	using namespace eeyore;
+	int label;
+	if(!_placed_labels.empty() && _chance(30))
+		label = _placed_labels[_rand(_placed_labels.size())];
+	else
+	{
+		label = _label_cnt++;
+		_pending.emplace(pos + 1 + _rand(20), label);
+	}
+	auto op = static_cast<BinaryOp>(static_cast<int>(BinaryOp::GT) + _rand(6));
+	_stmts.push_back(CondGotoStmt(_rand_opr(), op, _rand_opr(), Label(label)));
+}
+
+template<class Container>
+void EeyoreGenerator<Container>::_gen_call(int func_idx)
+{
+	using namespace eeyore;
+	int callee = _rand(func_idx);
+	_stmts.push_back(ParamStmt(_rand_opr()));
+	_stmts.push_back(ParamStmt(_chance(50)? Operand(Param(1)) : Operand(OrigVar(ARR_VAR_ID))));
+	_stmts.push_back(FuncCallStmt(func_name(callee), _rand_dst()));
+}
+
+template<class Container>
+void EeyoreGenerator<Container>::_gen_stmt(int pos, int func_idx,
+	const std::vector<int> &call_pos, size_t &next_call)
+{
+	using namespace eeyore;
+	while(!_pending.empty() && _pending.top().first <= pos)
+	{
+		_stmts.push_back(LabelStmt(Label(_pending.top().second)));
+		_placed_labels.push_back(_pending.top().second);
+		_pending.pop();
+	}
+	if(func_idx > 0 && next_call < call_pos.size() && call_pos[next_call] <= pos)
+	{
+		while(next_call < call_pos.size() && call_pos[next_call] <= pos)
+		{
+			_gen_call(func_idx);
+			next_call++;
+		}
+		return;
+	}
+	if(_chance(_opts.branch_percent))
+	{
+		_gen_branch(pos);
+		return;
+	}
+
+	switch(_rand(10))
+	{
+		case 0:
+			_stmts.push_back(MoveStmt(_rand_dst(), _rand_opr()));
+			break;
+		case 1:
+			_stmts.push_back(UnaryOpStmt(_rand_dst(), _chance(50)? UnaryOp::NEG : UnaryOp::NOT,
+				_rand_opr()));
+			break;
+		case 2:
+			_stmts.push_back(ReadArrStmt(_rand_dst(),
+				_chance(50)? Operand(Param(1)) : Operand(OrigVar(ARR_VAR_ID)), _rand_idx()));
+			break;
+		case 3:
+			_stmts.push_back(WriteArrStmt(
+				_chance(50)? Operand(Param(1)) : Operand(OrigVar(ARR_VAR_ID)), _rand_idx(), _rand_opr()));
+			break;
+		case 4:
+			// Divisors are non-zero constants.
+			_stmts.push_back(BinaryOpStmt(_rand_dst(), _rand_opr(),
+				_chance(50)? BinaryOp::DIV : BinaryOp::MOD, 1 + _rand(99)));
+			break;
+		default:
+		{
+			static const BinaryOp OPS[] = {BinaryOp::ADD, BinaryOp::SUB, BinaryOp::MUL,
+				BinaryOp::LT, BinaryOp::EQ, BinaryOp::AND, BinaryOp::OR};
+			_stmts.push_back(BinaryOpStmt(_rand_dst(), _rand_opr(), OPS[_rand(7)], _rand_opr()));
+		}
+	}
+}
+
+template<class Container>
+void EeyoreGenerator<Container>::_gen_func(int idx)
+{
+	using namespace eeyore;
+	std::string name = func_name(idx);
+	_stmts.push_back(FuncDefStmt(name, 2));
+	_first_local = _orig_var_cnt;
+	_orig_var_cnt += _opts.local_cnt;
+	for(int i = 0; i < _opts.local_cnt; i++)
+		_stmts.push_back(DeclStmt(OrigVar(_first_local + i)));
+	for(int i = 0; i < _opts.temp_cnt; i++)
+		_stmts.push_back(DeclStmt(TempVar(i)));
+
+	_placed_labels.clear();
+	std::vector<int> call_pos = random_positions(_rng, _opts.calls_per_func, _opts.stmts_per_func);
+	size_t next_call = 0;
+	for(int pos = 0; pos < _opts.stmts_per_func; pos++)
+		_gen_stmt(pos, idx, call_pos, next_call);
+	while(!_pending.empty())
+	{
+		_stmts.push_back(LabelStmt(Label(_pending.top().second)));
+		_pending.pop();
+	}
+	_stmts.push_back(RetStmt(OrigVar(_first_local)));
+	_stmts.push_back(EndFuncDefStmt(name));
+}
+
+template<class Container>
+void EeyoreGenerator<Container>::generate()
+{
+	using namespace eeyore;
+	for(int i = 0; i < GLOBAL_SCALAR_CNT; i++)
+		_stmts.push_back(DeclStmt(OrigVar(i)));
+	_stmts.push_back(DeclStmt(OrigVar(ARR_VAR_ID, 4 * _opts.arr_size), true));
+	_orig_var_cnt = ARR_VAR_ID + 1;
+
+	for(int i = 0; i < _opts.func_cnt; i++)
+		_gen_func(i);
+
+	_stmts.push_back(FuncDefStmt("main", 0));
+	_stmts.push_back(DeclStmt(TempVar(0)));
+	_stmts.push_back(FuncCallStmt("getint", TempVar(0)));
+	if(_opts.func_cnt > 0)
+	{
+		_stmts.push_back(ParamStmt(TempVar(0)));
+		_stmts.push_back(ParamStmt(OrigVar(ARR_VAR_ID)));
+		_stmts.push_back(FuncCallStmt(func_name(_opts.func_cnt - 1), TempVar(0)));
+	}
+	_stmts.push_back(ParamStmt(TempVar(0)));
+	_stmts.push_back(FuncCallStmt("putint"));
+	_stmts.push_back(RetStmt(0));
+	_stmts.push_back(EndFuncDefStmt("main"));
+}
+
+} // namespace
+
+namespace compiler_skeleton::synth
+{
+
+void generate_sysy(std::ostream &out, const SysYGenOptions &opts)
+{
+	SysYGenerator(out, opts).generate();
+}
+
+std::string generate_sysy(const SysYGenOptions &opts)
+{
+	std::ostringstream out;
+	generate_sysy(out, opts);
+	return out.str();
+}
+
+void generate_eeyore(std::vector<eeyore::EeyoreStatement> &stmts, const EeyoreGenOptions &opts)
+{
+	EeyoreGenerator(stmts, opts).generate();
+}
+
+void generate_eeyore(eeyore::EeyoreStmtVec &stmts, const EeyoreGenOptions &opts)
+{
+	EeyoreGenerator(stmts, opts).generate();
+}
+
+void generate_eeyore(eeyore::EeyoreStream &stream, const EeyoreGenOptions &opts)
+{
+	EeyoreGenerator(stream, opts).generate();
+}
+
+std::vector<eeyore::EeyoreStatement> generate_eeyore(const EeyoreGenOptions &opts)
+{
+	std::vector<eeyore::EeyoreStatement> stmts;
+	generate_eeyore(stmts, opts);
+	return stmts;
+}
+
+} // namespace compiler_skeleton::synth
@@ -0,0 +1,75 @@
+#ifndef SKELETON_SYNTH_H
+#define SKELETON_SYNTH_H
+
+/*
+ * Seeded generators of large synthetic programs, for benchmarks, scaling and
+ * fuzz tests. The same options (and seed) always give the same program.
+ *
+ *  + `generate_sysy()' writes a valid SysY program: every name is declared
+ *    before use, functions only call the functions defined before them (so the
+ *    call graph is a DAG), loops are bounded and divisors are non-zero
+ *    constants.
+ *  + `generate_eeyore()' builds the Eeyore statements of a similar program
+ *    directly, skipping the front end.
+ *
+ * Each option scales one axis of the program: the number of functions, the
+ * statements per function, the nesting of blocks, the dimensions of arrays
+ * (`int[a][b][c]...') and the number of calls in each function (the width of
+ * the call graph).
+ *
+ * Example:
+ *     using namespace compiler_skeleton::synth;
+ *     SysYGenOptions opts;
+ *     opts.func_cnt = 10000;
+ *     opts.stmts_per_func = 20;
+ *     generate_sysy(std::cout, opts);
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "eeyore.h"
+#include "eeyore_stream.h"
+
+namespace compiler_skeleton::synth
+{
+
+struct SysYGenOptions
+{
+	unsigned seed = 1;
+	int func_cnt = 10;
+	int stmts_per_func = 100; // statements in the body, counting nested ones
+	int max_nesting = 3; // max depth of nested if/while blocks
+	int max_expr_depth = 3;
+	int arr_dims = 2; // dimensions of the global and parameter arrays
+	int arr_dim_len = 8; // length of each dimension
+	int calls_per_func = 2; // each call goes to a random earlier function
+	int local_cnt = 8; // scalar locals per function
+};
+
+struct EeyoreGenOptions
+{
+	unsigned seed = 1;
+	int func_cnt = 10;
+	int stmts_per_func = 100;
+	int temp_cnt = 64; // t-type temporaries per function
+	int local_cnt = 8; // T-type scalar locals per function
+	int arr_size = 64; // words in the global array
+	int calls_per_func = 2;
+	int branch_percent = 15; // chance of a conditional branch per statement
+};
+
+void generate_sysy(std::ostream &out, const SysYGenOptions &opts);
+std::string generate_sysy(const SysYGenOptions &opts);
+
+// Append the generated statements to `stmts'. The program starts with the
+// global declarations, followed by the functions and `main'.
+void generate_eeyore(std::vector<eeyore::EeyoreStatement> &stmts, const EeyoreGenOptions &opts);
+void generate_eeyore(eeyore::EeyoreStmtVec &stmts, const EeyoreGenOptions &opts);
+// Print the program function by function, without building it in memory.
+void generate_eeyore(eeyore::EeyoreStream &stream, const EeyoreGenOptions &opts);
+std::vector<eeyore::EeyoreStatement> generate_eeyore(const EeyoreGenOptions &opts);
+
+} // namespace compiler_skeleton::synth
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * Command line front end of the synthetic program generators (see synth.h).
+ *
+ * Usage: synth [--eeyore] [--seed=N] [--funcs=N] [--stmts=N] [--nesting=N]
+ *              [--dims=N] [--dim-len=N] [--calls=N]
+ *
+ * Writes a SysY program (or an Eeyore program with `--eeyore') to stdout.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "synth.h"
+
+int main(int argc, char **argv)
+{
+	using namespace compiler_skeleton::synth;
+	SysYGenOptions sysy_opts;
+	EeyoreGenOptions eeyore_opts;
+	bool gen_eeyore = false;
+
+	for(int i = 1; i < argc; i++)
+	{
+		const char *eq = strchr(argv[i], '=');
+		int val = eq != nullptr? atoi(eq + 1) : 0;
+		std::string opt(argv[i], eq != nullptr? eq - argv[i] : strlen(argv[i]));
+		if(opt == "--eeyore")
+			gen_eeyore = true;
+		else if(opt == "--seed")
+			sysy_opts.seed = eeyore_opts.seed = val;
+		else if(opt == "--funcs")
+			sysy_opts.func_cnt = eeyore_opts.func_cnt = val;
+		else if(opt == "--stmts")
+			sysy_opts.stmts_per_func = eeyore_opts.stmts_per_func = val;
+		else if(opt == "--calls")
+			sysy_opts.calls_per_func = eeyore_opts.calls_per_func = val;
+		else if(opt == "--nesting")
+			sysy_opts.max_nesting = val;
+		else if(opt == "--dims")
+			sysy_opts.arr_dims = val;
+		else if(opt == "--dim-len")
+			sysy_opts.arr_dim_len = val;
+		else
+		{
+			std::cerr << "unknown argument " << argv[i] << std::endl;
+			return 1;
+		}
+	}
+
+	std::ios::sync_with_stdio(false);
+	if(gen_eeyore)
+	{
+		compiler_skeleton::eeyore::EeyoreStream stream(std::cout);
+		generate_eeyore(stream, eeyore_opts);
+	}
+	else
+		generate_sysy(std::cout, sysy_opts);
+	return 0;
+}
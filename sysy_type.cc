@@ -1,169 +1,351 @@
+#include <atomic>
 #include <cassert>
-#include "lambda_visitor.h"
+#include <mutex>
+#include <new>
+#include "arena.h"
+#include "profiler.h"
 #include "sysy_type.h"
 
+namespace
+{
 
-namespace compiler_skeleton::sysy
+using namespace compiler_skeleton::sysy;
+
+// Calls (including recursive ones) of the type checking functions.
+compiler_skeleton::utils::Statistic same_type_calls("type", "is_same_type calls");
+compiler_skeleton::utils::Statistic can_accept_calls("type", "can_accept calls");
+compiler_skeleton::utils::Statistic accept_memo_hits("type", "can_accept memo hits");
+compiler_skeleton::utils::Statistic interned_types("type", "interned types");
+
+// boost::hash_combine, widened to 64 bits. Hashes do not depend on addresses,
+// so they are stable across runs.
+inline uint64_t hash_combine(uint64_t seed, uint64_t val)
 {
+	return seed ^ (val + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
 
-bool is_void(const TypePtr &type)
+// All the interned types, looked up by their hashes. Sub-types are interned
+// before their parents, so two nodes are the same type if their own fields
+// are equal and their sub-types are the same pointers.
+//
+// Parallel semantic analysis interns types from many threads at once, mostly
+// types that exist already, so lookups take no lock at all:
+//  + The table is split into shards by hash, each with its own lock, arena
+//    and bucket array. Only an insert locks, and only its own shard.
+//  + Nodes are never changed once published: an insert builds a node and then
+//    publishes it at the head of its chain with a release store, which a
+//    reader loads with acquire.
+//  + A shard grows by building a new bucket array of new nodes and publishing
+//    it the same way. The old one stays in the arena (as the types do) for
+//    the readers still walking it.
+// A reader that misses a type inserted meanwhile finds it again under the
+// lock, so each type is still interned once.
+class TypeTable
 {
-	return std::holds_alternative<VoidType>(*type);
+  protected:
+	struct Node
+	{
+		TypePtr type;
+		Node *next;
+	};
+
+	struct Buckets
+	{
+		size_t mask;
+		std::atomic<Node *> *heads;
+	};
+
+	struct alignas(64) Shard
+	{
+		std::atomic<Buckets *> buckets;
+		size_t size; // guarded by `mutex'
+		std::mutex mutex;
+		compiler_skeleton::utils::Arena arena;
+	};
+
+	static constexpr int SHARD_BITS = 6;
+	static constexpr size_t INIT_BUCKET_CNT = 16;
+
+	Shard _shards[1 << SHARD_BITS];
+	std::atomic<uint32_t> _next_id;
+
+	static bool _same_node(const Type &type1, const Type &type2);
+	static const TypePtr *_find(const Buckets *buckets, const Type &type);
+	// The following require the lock of the shard.
+	static Buckets *_new_buckets(Shard &shard, size_t cnt);
+	static void _grow(Shard &shard);
+
+  public:
+	TypeTable();
+
+	const TypePtr &intern(const Type &type);
+};
+
+TypeTable::TypeTable(): _next_id(1)
+{
+	for(auto &shard : _shards)
+	{
+		shard.size = 0;
+		shard.buckets.store(_new_buckets(shard, INIT_BUCKET_CNT), std::memory_order_relaxed);
+	}
 }
 
-bool is_int(const TypePtr &type)
+bool TypeTable::_same_node(const Type &type1, const Type &type2)
 {
-	return std::holds_alternative<IntType>(*type);
+	return type1.kind() == type2.kind() && type1.is_const() == type2.is_const()
+		&& type1.len() == type2.len() && type1.element_type() == type2.element_type()
+		&& type1.arg_types() == type2.arg_types();
 }
 
-bool is_arr(const TypePtr &type)
+const TypePtr *TypeTable::_find(const Buckets *buckets, const Type &type)
 {
-	return std::holds_alternative<ArrType>(*type);
+	const Node *node = buckets->heads[type.hash() & buckets->mask].load(std::memory_order_acquire);
+	for(; node != nullptr; node = node->next)
+		if(node->type->hash() == type.hash() && _same_node(*node->type, type))
+			return &node->type;
+	return nullptr;
 }
 
-bool is_ptr(const TypePtr &type)
+TypeTable::Buckets *TypeTable::_new_buckets(Shard &shard, size_t cnt)
 {
-	return std::holds_alternative<PtrType>(*type);
+	auto heads = static_cast<std::atomic<Node *> *>(
+		shard.arena.allocate(cnt * sizeof(std::atomic<Node *>), alignof(std::atomic<Node *>)));
+	for(size_t i = 0; i < cnt; i++)
+		::new(&heads[i]) std::atomic<Node *>(nullptr);
+	return shard.arena.make<Buckets>(Buckets{cnt - 1, heads});
 }
 
-bool is_func(const TypePtr &type)
+void TypeTable::_grow(Shard &shard)
 {
-	return std::holds_alternative<FuncType>(*type);
+	const Buckets *old_buckets = shard.buckets.load(std::memory_order_relaxed);
+	Buckets *buckets = _new_buckets(shard, (old_buckets->mask + 1) * 2);
+	for(size_t i = 0; i <= old_buckets->mask; i++)
+	{
+		const Node *node = old_buckets->heads[i].load(std::memory_order_relaxed);
+		for(; node != nullptr; node = node->next)
+		{
+			auto &head = buckets->heads[node->type->hash() & buckets->mask];
+			head.store(shard.arena.make<Node>(Node{node->type, head.load(std::memory_order_relaxed)}),
+				std::memory_order_relaxed);
+		}
+	}
+	shard.buckets.store(buckets, std::memory_order_release);
 }
 
+const TypePtr &TypeTable::intern(const Type &type)
+{
+	// The buckets take the low bits of the hash, and the shards the high bits
+	// of a multiple of it, which depend on all the bits.
+	Shard &shard = _shards[(type.hash() * 0x9e3779b97f4a7c15ull) >> (64 - SHARD_BITS)];
+	if(const TypePtr *found = _find(shard.buckets.load(std::memory_order_acquire), type))
+		return *found;
+
+	std::lock_guard lock(shard.mutex);
+	if(const TypePtr *found = _find(shard.buckets.load(std::memory_order_relaxed), type))
+		return *found;
+	if(shard.size > shard.buckets.load(std::memory_order_relaxed)->mask)
+		_grow(shard);
+	// Interned types are never freed, so the pointer has no control block,
+	// and copies of it touch no reference count.
+	Type *res = shard.arena.make<Type>(type, _next_id.fetch_add(1, std::memory_order_relaxed),
+		&shard.arena);
+	const Buckets *buckets = shard.buckets.load(std::memory_order_relaxed);
+	auto &head = buckets->heads[type.hash() & buckets->mask];
+	Node *node = shard.arena.make<Node>(Node{TypePtr(TypePtr(), res),
+		head.load(std::memory_order_relaxed)});
+	head.store(node, std::memory_order_release);
+	shard.size++;
+	++interned_types;
+	return node->type;
+}
 
-VoidType get_void(const TypePtr &type)
+TypeTable &type_table()
 {
-	return std::get<VoidType>(*type);
+	static TypeTable table;
+	return table;
 }
 
-IntType get_int(const TypePtr &type)
+// A direct-mapped cache of `can_accept' results keyed by pairs of type ids.
+// Each entry packs both ids and the result into one word, so it is read and
+// written atomically without locks; a colliding pair simply evicts the entry.
+class AcceptMemo
+{
+  protected:
+	static constexpr size_t SIZE = 1 << 14;
+	std::atomic<uint64_t> _entries[SIZE];
+
+	static inline uint64_t _key(uint32_t id1, uint32_t id2)
+		{ return static_cast<uint64_t>(id1) << 32 | static_cast<uint64_t>(id2) << 1; }
+	static inline size_t _slot(uint32_t id1, uint32_t id2)
+		{ return (id1 * 0x9e3779b1u ^ id2) & (SIZE - 1); }
+
+  public:
+	AcceptMemo()
+	{
+		for(auto &entry : _entries)
+			entry.store(0, std::memory_order_relaxed);
+	}
+
+	// Returns -1 if the pair is not cached.
+	inline int lookup(uint32_t id1, uint32_t id2) const
+	{
+		uint64_t entry = _entries[_slot(id1, id2)].load(std::memory_order_relaxed);
+		return (entry & ~1ull) == _key(id1, id2)? static_cast<int>(entry & 1) : -1;
+	}
+	inline void store(uint32_t id1, uint32_t id2, bool res)
+	{
+		_entries[_slot(id1, id2)].store(_key(id1, id2) | res, std::memory_order_relaxed);
+	}
+};
+
+AcceptMemo &accept_memo()
 {
-	return std::get<IntType>(*type);
+	static AcceptMemo memo;
+	return memo;
 }
 
-ArrType get_arr(const TypePtr &type)
+bool check_accept(const TypePtr &req_type, const TypePtr &prov_type)
 {
-	return std::get<ArrType>(*type);
+	// This is special, a pointer type can accept an array type.
+	if(is_ptr(req_type) && is_arr(prov_type))
+		return can_accept(req_type->base_type(), prov_type->element_type());
+	if(req_type->kind() != prov_type->kind())
+		return false;
+	switch(req_type->kind())
+	{
+		case TypeKind::VOID:
+			return true;
+		case TypeKind::INT:
+			return !req_type->is_const() || prov_type->is_const();
+		case TypeKind::ARR:
+			return req_type->len() == prov_type->len()
+				&& can_accept(req_type->element_type(), prov_type->element_type());
+		case TypeKind::PTR:
+			return can_accept(req_type->base_type(), prov_type->base_type());
+		case TypeKind::FUNC:
+			// Same as `is_same' for function types.
+			return is_same_type(req_type, prov_type);
+	}
+	return false;
 }
 
-PtrType get_ptr(const TypePtr &type)
+// Print the element type and the dimensions of an array separately, since
+// the dimensions go after the pointer "[]" of pointer types.
+void print_arr_base_type(std::ostream &out, const Type *arr)
 {
-	return std::get<PtrType>(*type);
+	while(is_arr(arr->element_type()))
+		arr = arr->element_type().get();
+	out << arr->element_type();
 }
 
-FuncType get_func(const TypePtr &type)
+void print_arr_dims(std::ostream &out, const Type *arr)
 {
-	return std::get<FuncType>(*type);
+	while(true)
+	{
+		out << '[' << arr->len() << ']';
+		if(!is_arr(arr->element_type()))
+			break;
+		arr = arr->element_type().get();
+	}
 }
 
+} // namespace
 
+namespace compiler_skeleton::sysy
+{
 
-TypePtr make_void()
+const TypePtr &intern_type(const Type &type)
 {
-	static const auto VOID_T = std::make_shared<Type>(VoidType());
+	return type_table().intern(type);
+}
+
+// The most common types are kept in statics to skip the table lookups.
+
+const TypePtr &make_void()
+{
+	static const TypePtr VOID_T = intern_type(Type(TypeKind::VOID));
 	return VOID_T;
 }
 
-TypePtr make_int(bool is_const)
+const TypePtr &make_int(bool is_const)
 {
-	static const auto CONST_INT_T = std::make_shared<Type>(IntType(true));
-	static const auto INT_T = std::make_shared<Type>(IntType(false));
+	static const TypePtr CONST_INT_T = intern_type(Type(TypeKind::INT, true));
+	static const TypePtr INT_T = intern_type(Type(TypeKind::INT, false));
 	return is_const? CONST_INT_T : INT_T;
 }
 
-TypePtr make_arr(TypePtr ele_type, int len)
+const TypePtr &make_arr(const TypePtr &ele_type, int len)
 {
-	return std::make_shared<Type>(ArrType(ele_type, len));
+	return intern_type(Type(ele_type, len));
 }
 
-TypePtr make_ptr(TypePtr base_type, bool is_const)
+const TypePtr &make_ptr(const TypePtr &base_type, bool is_const)
 {
-	static const auto INT_PTR_T = std::make_shared<Type>(PtrType(base_type, false));
-	if(!is_const && is_int(base_type))
+	static const TypePtr INT_PTR_T = intern_type(Type(make_int(), false));
+	if(!is_const && base_type == make_int())
 		return INT_PTR_T;
-	return std::make_shared<Type>(PtrType(base_type, is_const));
+	return intern_type(Type(base_type, is_const));
 }
 
-TypePtr make_func(TypePtr retval_type)
+const TypePtr &make_func(const TypePtr &retval_type)
 {
-	return std::make_shared<Type>(FuncType(retval_type));
+	return intern_type(Type(retval_type, TypePtrVec()));
 }
 
 
-bool is_const_type(const TypePtr &type)
-{
-	static utils::LambdaVisitor const_checker =
-	{
-		[](const auto &any_type) { return any_type.is_const(); }
-	};
-	return std::visit(const_checker, *type);
-}
-
 bool is_same_type(const TypePtr &type1, const TypePtr &type2)
 {
-	static utils::LambdaVisitor same_type_checker =
+	++same_type_calls;
+	if(type1 == type2)
+		return true;
+	if(type1->hash() != type2->hash() || type1->kind() != type2->kind())
+		return false;
+	switch(type1->kind())
 	{
-		[](const VoidType &void_type1, const VoidType &void_type2)
-			{ return true; },
-		[](const IntType &int_type1, const IntType &int_type2)
-			{ return int_type1.is_const() == int_type2.is_const(); },
-		[](const ArrType &arr_type1, const ArrType &arr_type2)
-			{ return arr_type1.len() == arr_type2.len()
-				&& is_same_type(arr_type1.element_type(), arr_type2.element_type()); },
-		[](const PtrType &ptr_type1, const PtrType &ptr_type2)
-			{ return is_same_type(ptr_type1.base_type(), ptr_type2.base_type()); },
-		[](const FuncType &func_type1, const FuncType &func_type2)
-		{
-			if(func_type1.arg_cnt() != func_type2.arg_cnt()
-				|| !is_same_type(func_type1.retval_type(), func_type2.retval_type()))
+		case TypeKind::VOID:
+			return true;
+		case TypeKind::INT:
+			return type1->is_const() == type2->is_const();
+		case TypeKind::ARR:
+			return type1->len() == type2->len()
+				&& is_same_type(type1->element_type(), type2->element_type());
+		case TypeKind::PTR:
+			return is_same_type(type1->base_type(), type2->base_type());
+		case TypeKind::FUNC:
+			if(type1->arg_cnt() != type2->arg_cnt()
+				|| !is_same_type(type1->retval_type(), type2->retval_type()))
 			{
 				return false;
 			}
-			for(int i = 0, arg_cnt = func_type1.arg_cnt(); i < arg_cnt; i++)
-				if(!is_same_type(func_type1.arg_type(i), func_type2.arg_type(i)))
+			for(int i = 0, arg_cnt = type1->arg_cnt(); i < arg_cnt; i++)
+				if(!is_same_type(type1->arg_type(i), type2->arg_type(i)))
 					return false;
 			return true;
-		},
-		[](const auto &type1, const auto &type2) { return false; }
-	};
-	return std::visit(same_type_checker, *type1, *type2);
+	}
+	return false;
 }
 
 // Check if a function argument type `req_type' can accept `prov_type' as its
 // argument type.
 bool can_accept(const TypePtr &req_type, const TypePtr &prov_type)
 {
-	static utils::LambdaVisitor can_accept_checker =
+	++can_accept_calls;
+	// Every type accepts itself, and ints are cheaper to check than to look up.
+	if(req_type == prov_type)
+		return true;
+	uint32_t req_id = req_type->id(), prov_id = prov_type->id();
+	if(req_id == 0 || prov_id == 0 || is_int(req_type))
+		return check_accept(req_type, prov_type);
+
+	auto &memo = accept_memo();
+	if(int res = memo.lookup(req_id, prov_id); res >= 0)
 	{
-		[](const VoidType &void_type1, const VoidType &void_type2)
-			{ return true; },
-		[](const IntType &int_type1, const IntType &int_type2)
-			{ return !int_type1.is_const() || int_type2.is_const(); },
-		[](const ArrType &arr_type1, const ArrType &arr_type2)
-			{ return arr_type1.len() == arr_type2.len()
-				&& can_accept(arr_type1.element_type(), arr_type2.element_type()); },
-		[](const PtrType &ptr_type1, const PtrType &ptr_type2)
-			{ return can_accept(ptr_type1.base_type(), ptr_type2.base_type()); },
-		[](const PtrType &ptr_type, const ArrType &arr_type)
-			{ return can_accept(ptr_type.base_type(), arr_type.element_type()); },
-			// This is special, a pointer type can accept an array type.
-		[](const FuncType &func_type1, const FuncType &func_type2)
-		{
-			// Same as `is_same' for FuncType and FuncType.
-			if(func_type1.arg_cnt() != func_type2.arg_cnt()
-				|| !is_same_type(func_type1.retval_type(), func_type2.retval_type()))
-			{
-				return false;
-			}
-			for(int i = 0, arg_cnt = func_type1.arg_cnt(); i < arg_cnt; i++)
-				if(!is_same_type(func_type1.arg_type(i), func_type2.arg_type(i)))
-					return false;
-			return true;
-		},
-		[](const auto &type1, const auto &type2) { return false; }
-	};
-	return std::visit(can_accept_checker, *req_type, *prov_type);
+		++accept_memo_hits;
+		return res;
+	}
+	bool res = check_accept(req_type, prov_type);
+	memo.store(req_id, prov_id, res);
+	return res;
 }
 
 bool can_operate(const TypePtr &type1, const TypePtr &type2)
@@ -175,132 +357,101 @@ bool can_operate(const TypePtr &type1, const TypePtr &type2)
 TypePtr common_type(const TypePtr &type1, const TypePtr &type2)
 {
 	assert(is_int(type1) && is_int(type2));
-	bool type1_is_const = std::get<IntType>(*type1).is_const(),
-	     type2_is_const = std::get<IntType>(*type2).is_const();
-	return make_int(type1_is_const && type2_is_const);
+	return make_int(type1->is_const() && type2->is_const());
 }
 
-int size_of_type(const TypePtr &type)
-{
-	// As for size, assume the code is run in 32-bit enviroinment.
-	static utils::LambdaVisitor size_getter =
-	{
-		[](const auto &any_type) { return any_type.size(); }
-	};
-	return std::visit(size_getter, *type);
-}
 
-bool TypeBase::is_const() const { return false; }
-int TypeBase::size() const { return 0; }
-
-IntType::IntType(bool is_const): _is_const(is_const) {}
-bool IntType::is_const() const { return _is_const; }
-int IntType::size() const  { return 4; }
-void IntType::set_is_const(bool is_const) { _is_const = is_const; }
-
-ArrType::ArrType(TypePtr ele_type, int len): _len(len), _ele_type(ele_type) {}
-bool ArrType::is_const() const  { return is_const_type(_ele_type); }
-int ArrType::size() const { return _len * size_of_type(_ele_type); }
-int ArrType::len() const { return _len; }
-TypePtr ArrType::element_type() const { return _ele_type; }
-int ArrType::element_size() const { return size_of_type(_ele_type); }
-void ArrType::set_len(int len) { _len = len; }
-void ArrType::set_ele_type(TypePtr ele_type) { _ele_type = ele_type; }
-
-PtrType::PtrType(TypePtr base_type, bool is_const)
-  : _base_type(base_type), _is_const(is_const) {}
-bool PtrType::is_const() const  { return _is_const; }
-int PtrType::size() const { return 4; }
-TypePtr PtrType::base_type() const { return _base_type; }
-void PtrType::set_is_const(bool is_const) { _is_const = is_const; }
-void PtrType::set_base_type(TypePtr base_type) { _base_type = base_type; }
-
-FuncType::FuncType(TypePtr retval_type): _retval_type(retval_type) {}
-TypePtr FuncType::retval_type() const { return _retval_type; }
-int FuncType::arg_cnt() const { return _arg_types.size(); }
-const TypePtrVec &FuncType::arg_types() const { return _arg_types; }
-TypePtr FuncType::arg_type(int idx) const { return _arg_types[idx]; }
-void FuncType::set_arg_type(int idx, TypePtr arg_type) { _arg_types[idx] = arg_type; }
-
-
-void TypePrinter::_print_base_type(const ArrType &t)
-{
-	const ArrType *arr_ptr = &t;
-	while(!is_int(arr_ptr->element_type()))
-		arr_ptr = &std::get<ArrType>(*arr_ptr->element_type());
-	std::visit(*this, *arr_ptr->element_type());
-}
+// As for size, assume the code is run in 32-bit enviroinment.
 
-void TypePrinter::_print_dim_size(const ArrType &t)
+Type::Type(TypeKind kind, bool is_const)
+  : _kind(kind), _is_const(is_const), _len(0), _size(kind == TypeKind::INT? 4 : 0),
+	_id(0), _hash(0)
 {
-	const ArrType *arr_ptr = &t;
-	while(true)
-	{
-		_out << '[' << arr_ptr->len() << ']';
-		if(is_int(arr_ptr->element_type()))
-			break;
-		arr_ptr = &std::get<ArrType>(*arr_ptr->element_type());
-	}
+	assert(kind == TypeKind::VOID || kind == TypeKind::INT);
+	_init_hash();
 }
 
-void TypePrinter::operator() (const VoidType &t)
+Type::Type(TypePtr ele_type, int len)
+  : _kind(TypeKind::ARR), _is_const(ele_type->is_const()), _len(len),
+	_size(len * ele_type->size()), _id(0), _hash(0), _sub_type(std::move(ele_type))
 {
-	_out << "void";
+	_init_hash();
 }
 
-void TypePrinter::operator() (const IntType &t)
+Type::Type(TypePtr base_type, bool is_const)
+  : _kind(TypeKind::PTR), _is_const(is_const), _len(0), _size(4), _id(0), _hash(0),
+	_sub_type(std::move(base_type))
 {
-	if(t.is_const())
-		_out << "const ";
-	_out << "int";
+	_init_hash();
 }
 
-void TypePrinter::operator() (const ArrType &t)
+Type::Type(TypePtr retval_type, TypePtrVec arg_types)
+  : _kind(TypeKind::FUNC), _is_const(false), _len(0), _size(0), _id(0), _hash(0),
+	_sub_type(std::move(retval_type)), _arg_types(std::move(arg_types))
 {
-	_print_base_type(t);
-	_print_dim_size(t);
+	_init_hash();
 }
 
-void TypePrinter::operator() (const PtrType &t)
+Type::Type(const Type &other, uint32_t id, std::pmr::memory_resource *res)
+  : _kind(other._kind), _is_const(other._is_const), _len(other._len), _size(other._size),
+	_id(id), _hash(other._hash), _sub_type(other._sub_type), _arg_types(other._arg_types, res)
 {
-	if(is_int(t.base_type()))
-	{
-		std::visit(*this, *t.base_type());
-		_out << "[]";
-	}
-	else if(is_arr(t.base_type()))
-	{
-		const auto &arr = std::get<ArrType>(*t.base_type());
-		_print_base_type(arr);
-		_out << "[]";
-		_print_dim_size(arr);
-	}
-	else // Pointer of array or function types is not supported by default.
-		 // Simply prints "pointer of #base_type".
-	{
-		_out << "pointer of ";
-		std::visit(*this, *t.base_type());
-	}
 }
 
-void TypePrinter::operator() (const FuncType &t)
+void Type::_init_hash()
 {
-	std::visit(*this, *t.retval_type());
-	_out << "(*)(";
-	for(int i = 0, arg_cnt = t.arg_cnt(); i < arg_cnt; i++)
-	{
-		if(i >= 1)
-			_out << ", ";
-		std::visit(*this, *t.arg_type(i));
-	}
-	_out << ')';
+	// The const bit of pointers is ignored by `is_same_type', and that of
+	// arrays comes from the elements.
+	_hash = hash_combine(static_cast<uint64_t>(_kind), _kind == TypeKind::INT && _is_const);
+	_hash = hash_combine(_hash, static_cast<uint64_t>(_len));
+	if(_sub_type != nullptr)
+		_hash = hash_combine(_hash, _sub_type->hash());
+	for(const auto &arg_type : _arg_types)
+		_hash = hash_combine(_hash, arg_type->hash());
 }
 
 } // namespace compiler_skeleton::sysy
 
 std::ostream &operator << (std::ostream &out, const compiler_skeleton::sysy::TypePtr &type)
 {
-	compiler_skeleton::sysy::TypePrinter printer(out);
-	std::visit(printer, *type);
+	using namespace compiler_skeleton::sysy;
+	switch(type->kind())
+	{
+		case TypeKind::VOID:
+			out << "void";
+			break;
+		case TypeKind::INT:
+			if(type->is_const())
+				out << "const ";
+			out << "int";
+			break;
+		case TypeKind::ARR: // something like "int[2][3]"
+			print_arr_base_type(out, type.get());
+			print_arr_dims(out, type.get());
+			break;
+		case TypeKind::PTR:
+			if(is_int(type->base_type()))
+				out << type->base_type() << "[]";
+			else if(is_arr(type->base_type()))
+			{
+				print_arr_base_type(out, type->base_type().get());
+				out << "[]";
+				print_arr_dims(out, type->base_type().get());
+			}
+			else // Pointer of array or function types is not supported by default.
+				 // Simply prints "pointer of #base_type".
+				out << "pointer of " << type->base_type();
+			break;
+		case TypeKind::FUNC: // something like "int(*)(int, int[])"
+			out << type->retval_type() << "(*)(";
+			for(int i = 0, arg_cnt = type->arg_cnt(); i < arg_cnt; i++)
+			{
+				if(i >= 1)
+					out << ", ";
+				out << type->arg_type(i);
+			}
+			out << ')';
+			break;
+	}
 	return out;
-}
\ No newline at end of file
+}
@@ -4,7 +4,7 @@
 /*
  * The recursive tree-style definition of tyes in SysY. Can be used in the
  * entries of symbol tables or in the leaf nodes of ASTs to mark the type.
- * 
+ *
  * The main class: TypePtr, a universal type pointer recording the type.
  *  + To get a TypePtr, use `make_void()', `make_int()', or other handy
  *    constructors.
@@ -13,7 +13,7 @@
  *    two types are the same, or `can_accept' to check if one types accepts
  *    another type.
  *  + Simplely print them using std::cout or any other type of std::ostream.
- * 
+ *
  * Example:
  *     using namespace compiler_skeleton::sysy;
  *     TypePtr int_type = make_int();
@@ -26,218 +26,156 @@
  * 										// Build an array by a dimension vector.
  *     std::cout << is_same_type(arr1, arr2); // true
  *     std::cout << arr1 << std::endl; // "int[2][3]"
+ *
+ * Types built by the constructors are interned: structurally equal types share
+ * one node, which gets a small integer id and lives until the program exits
+ * (the number of distinct types in a program is small). Since nothing is ever
+ * freed, a TypePtr to an interned type owns nothing: it has no reference
+ * count, and copying it is as cheap as copying a raw pointer. The interned
+ * types are returned by reference, so taking `int' or `int[]' needs no copy
+ * at all. The results of
+ * `can_accept' are memoized by pairs of type ids, so checking a call site
+ * against a signature that was seen before is a single lookup. Both the
+ * interning table and the memo table can be used from several threads, and
+ * neither takes a lock to find a type or a result seen before (the interning
+ * table locks one of its shards to add a type).
+ *
+ * A type is a single tagged node (no virtual functions, no variant), and is
+ * immutable once built. Its const-ness, size and a structural hash are
+ * computed by the constructor, so `is_const_type()' and `size_of_type()' are
+ * plain loads, and `is_same_type()' rejects most different types by their
+ * hashes without walking the trees.
+ *
+ * The per-kind classes (`VoidType' ... `FuncType'), their `*TypePtr' aliases
+ * and the `get_void()' ... `get_func()' accessors no longer exist, and types
+ * have no setters. Read the fields from the Type node directly, e.g.
+ * `type->element_type()' and `type->len()' of arrays, `type->base_type()' of
+ * pointers, `type->retval_type()' and `type->arg_types()' of functions.
  */
 
+#include <cstdint>
 #include <iostream>
 #include <memory>
+#include <memory_resource>
 #include <vector>
-#include <variant>
 
 namespace compiler_skeleton::sysy
 {
 
-// The base type of SysY types.
-class TypeBase;
-
-// All the types in SysY.
-class VoidType;
-class IntType;
-class ArrType;
-class PtrType;
-class FuncType;
-
-// The universal type & type pointer.
-using Type = std::variant
-<
-	VoidType,
-	IntType,
-	ArrType,
-	PtrType,
-	FuncType
->;
+class Type;
+
 using TypePtr = std::shared_ptr<Type>;
-using TypePtrVec = std::vector<TypePtr>;
+using TypePtrVec = std::pmr::vector<TypePtr>;
 
-// Corresponding type pointers.
-using VoidTypePtr = std::shared_ptr<VoidType>;
-using IntTypePtr = std::shared_ptr<IntType>;
-using ArrTypePtr = std::shared_ptr<ArrType>;
-using PtrTypePtr = std::shared_ptr<PtrType>;
-using FuncTypePtr = std::shared_ptr<FuncType>;
+enum class TypeKind: uint8_t
+{
+	VOID, INT, ARR, PTR, FUNC
+};
 
 // Type query functions.
-bool is_void(const TypePtr &type);
-bool is_int(const TypePtr &type);
-bool is_arr(const TypePtr &type);
-bool is_ptr(const TypePtr &type);
-bool is_func(const TypePtr &type);
-
-// Actual type getters.
-VoidType get_void(const TypePtr &type);
-IntType get_int(const TypePtr &type);
-ArrType get_arr(const TypePtr &type);
-PtrType get_ptr(const TypePtr &type);
-FuncType get_func(const TypePtr &type);
-
-// Handy type constructors.
-TypePtr make_void();
-TypePtr make_int(bool is_const=false);
-TypePtr make_arr(TypePtr ele_type, int len);
+inline bool is_void(const TypePtr &type);
+inline bool is_int(const TypePtr &type);
+inline bool is_arr(const TypePtr &type);
+inline bool is_ptr(const TypePtr &type);
+inline bool is_func(const TypePtr &type);
+
+// Return the interned type that is the same as `type'. The sub-types of `type'
+// must be interned already.
+const TypePtr &intern_type(const Type &type);
+
+// Handy type constructors. They return references to interned types, except
+// the dimension-vector `make_arr', which returns by value since it returns
+// `base_type' itself when the dimension list is empty.
+const TypePtr &make_void();
+const TypePtr &make_int(bool is_const=false);
+const TypePtr &make_arr(const TypePtr &ele_type, int len);
+// Build an array type given the size of all dimension sizes and a base type.
 template<class Iter>
-TypePtr make_arr(TypePtr base_type, Iter dim_begin, Iter dim_end)
+TypePtr make_arr(const TypePtr &base_type, Iter dim_begin, Iter dim_end)
 {
-	return std::make_shared<Type>(ArrType(base_type, dim_begin, dim_end));
+	if(dim_begin == dim_end)
+		return base_type;
+	int len = *dim_begin;
+	++dim_begin;
+	return make_arr(make_arr(base_type, dim_begin, dim_end), len);
 }
-TypePtr make_ptr(TypePtr base_type, bool is_const=false);
-TypePtr make_func(TypePtr retval_type);
+const TypePtr &make_ptr(const TypePtr &base_type, bool is_const=false);
+const TypePtr &make_func(const TypePtr &retval_type);
 template<class Iter>
-TypePtr make_func(TypePtr retval_type, Iter arg_types_begin, Iter arg_types_end)
+const TypePtr &make_func(const TypePtr &retval_type, Iter arg_types_begin, Iter arg_types_end)
 {
-	return std::make_shared<Type>(FuncType(retval_type, arg_types_begin, arg_types_end));
+	return intern_type(Type(retval_type, TypePtrVec(arg_types_begin, arg_types_end)));
 }
 
 // Type info functions.
-bool is_const_type(const TypePtr &type);
+inline bool is_const_type(const TypePtr &type);
 bool is_same_type(const TypePtr &type1, const TypePtr &type2);
 bool can_accept(const TypePtr &req_type, const TypePtr &prov_type);
 bool can_operate(const TypePtr &type1, const TypePtr &type2);
 TypePtr common_type(const TypePtr &type1, const TypePtr &type2);
-int size_of_type(const TypePtr &type);
-
-class TypeBase
-{
-  public:
-	virtual bool is_const() const;
-	virtual int size() const;
-};
-
-class VoidType: public TypeBase
-{
-};
-
-class IntType: public TypeBase
-{
-  protected:
-	bool _is_const;
-
-  public:
-	IntType(bool is_const);
-
-	// Getters.
-	bool is_const() const override;
-	int size() const override;
-
-	// Setters.
-	void set_is_const(bool is_const);
-};
-
-class ArrType: public TypeBase
-{
-  protected:
-	int _len;
-	TypePtr _ele_type;
-
-  public:
-	// Build an array type given the length and the type of its elements.
-	// This function does no error checking, so make sure ele_type is a
-	// valid int/array type.
-	ArrType(TypePtr ele_type, int len);
-
-	// Build an array type given the size of all dimension sizes and a base type.
-	template<class Iter>
-	ArrType(TypePtr base_type, Iter dim_begin, Iter dim_end)
-	{
-		_len = *dim_begin;
-		++dim_begin;
-		if(dim_begin != dim_end)
-			_ele_type = make_arr(base_type, dim_begin, dim_end);
-		else
-			_ele_type = base_type;
-	}
-
-	// Getters.
-	bool is_const() const override;
-	int size() const override;
-	int len() const;
-	TypePtr element_type() const;
-	int element_size() const;
-
-	// Setters.
-	void set_len(int len);
-	void set_ele_type(TypePtr ele_type);
-};
+inline int size_of_type(const TypePtr &type);
 
-/*
- * Although there are no pointers in Sys-Y, we still define and use it (at least
- * for function arguments).
- */
-class PtrType: public TypeBase
+class Type
 {
   protected:
-	bool _is_const;
-	TypePtr _base_type; // The type that the pointer points to.
+	TypeKind _kind;
+	bool _is_const; // of int & pointer types; arrays take it from the elements
+	int _len; // of array types
+	int _size;
+	uint32_t _id; // 0 if not interned
+	uint64_t _hash;
+	TypePtr _sub_type; // element type / base type / return value type
+	TypePtrVec _arg_types; // of function types
 
-  public:
-	PtrType(TypePtr base_type, bool is_const=false);
-
-	// Getters.
-	bool is_const() const override;
-	int size() const override;
-	TypePtr base_type() const;
-
-	// Setters.
-	void set_is_const(bool is_const);
-	void set_base_type(TypePtr base_type);
-};
-
-class FuncType: public TypeBase
-{
-  protected:
-	TypePtr _retval_type;
-	TypePtrVec _arg_types;
+	void _init_hash();
 
   public:
-	FuncType(TypePtr retval_type);
-	template<class Iter>
-	FuncType(TypePtr retval_type, Iter arg_types_begin, Iter arg_types_end)
-	  : _retval_type(retval_type),
-		_arg_types(TypePtrVec(arg_types_begin, arg_types_end)) {}
-
-	// Getters.
-	TypePtr retval_type() const;
-	int arg_cnt() const;
-	const TypePtrVec &arg_types() const;
-	TypePtr arg_type(int idx) const;
-
-	// Setters.
-	void set_retval_type(TypePtr retval_type) { _retval_type = retval_type; }
-	template<class Iter>
-	void set_args_types(Iter arg_types_begin, Iter arg_types_end)
-		{ _arg_types = TypePtrVec(arg_types_begin, arg_types_end); }
-	void set_arg_type(int idx, TypePtr arg_type);
+	// Use the `make_*' constructors instead of these.
+	Type(TypeKind kind, bool is_const=false); // void & int
+	Type(TypePtr ele_type, int len); // array
+	Type(TypePtr base_type, bool is_const); // pointer
+	Type(TypePtr retval_type, TypePtrVec arg_types); // function
+	// Used by the interning table to copy a type into its own memory.
+	Type(const Type &other, uint32_t id, std::pmr::memory_resource *res);
+
+	Type(const Type &) = delete;
+	Type &operator = (const Type &) = delete;
+
+	// Common getters.
+	inline TypeKind kind() const { return _kind; }
+	inline bool is_const() const { return _is_const; }
+	inline int size() const { return _size; } // 0 for void & function types
+	inline uint64_t hash() const { return _hash; } // equal for the same types
+	inline uint32_t id() const { return _id; }
+
+	// Array getters.
+	inline int len() const { return _len; }
+	inline const TypePtr &element_type() const { return _sub_type; }
+	inline int element_size() const { return _sub_type->size(); }
+
+	// Pointer getters.
+	inline const TypePtr &base_type() const { return _sub_type; }
+
+	// Function getters.
+	inline const TypePtr &retval_type() const { return _sub_type; }
+	inline int arg_cnt() const { return static_cast<int>(_arg_types.size()); }
+	inline const TypePtrVec &arg_types() const { return _arg_types; }
+	inline const TypePtr &arg_type(int idx) const { return _arg_types[idx]; }
 };
 
-// Prints the types to a stream.
-class TypePrinter: public TypeBase
-{
-  protected:
-	void _print_base_type(const ArrType &t);
-	void _print_dim_size(const ArrType &t);
-	std::ostream &_out;
-
-  public:
-	TypePrinter(std::ostream &out): _out(out) {}
+inline bool is_void(const TypePtr &type) { return type->kind() == TypeKind::VOID; }
+inline bool is_int(const TypePtr &type) { return type->kind() == TypeKind::INT; }
+inline bool is_arr(const TypePtr &type) { return type->kind() == TypeKind::ARR; }
+inline bool is_ptr(const TypePtr &type) { return type->kind() == TypeKind::PTR; }
+inline bool is_func(const TypePtr &type) { return type->kind() == TypeKind::FUNC; }
 
-	void operator() (const VoidType &t); // "void"
-	void operator() (const IntType &t); // "int" or "const int"
-	void operator() (const ArrType &t); // something like "int[2][3]"
-	void operator() (const PtrType &t); // something like "int[][3]"
-	void operator() (const FuncType &t); // something like "int (*)(int, int[])"
-};
+inline bool is_const_type(const TypePtr &type) { return type->is_const(); }
+inline int size_of_type(const TypePtr &type) { return type->size(); }
 
 } // namespace compiler_skeleton
 
-// use std::ostream to output TypePtr.
+// use std::ostream to output TypePtr, e.g. "const int", "int[2][3]",
+// "int[][3]" (a pointer) or "int(*)(int, int[])".
 std::ostream &operator << (std::ostream &out, const compiler_skeleton::sysy::TypePtr &type);
 
-#endif
\ No newline at end of file
+#endif
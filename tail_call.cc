@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <unordered_set>
+#include "lambda_visitor.h"
+#include "profiler.h"
+#include "tail_call.h"
+
+namespace
+{
+
+compiler_skeleton::utils::Statistic self_tail_calls("tail call", "self tail calls turned into jumps");
+compiler_skeleton::utils::Statistic tail_calls("tail call", "tail calls marked");
+
+} // namespace
+
+namespace compiler_skeleton::eeyore
+{
+
+namespace
+{
+
+// A key of a variable, or of no variable for immediates.
+inline uint64_t var_key(const Operand &opr)
+{
+	if(std::holds_alternative<int>(opr))
+		return std::numeric_limits<uint64_t>::max();
+	int id = std::visit(utils::LambdaVisitor
+	{
+		[](int) { return 0; },
+		[](const VarBase &var) { return var.id; }
+	}, opr);
+	return static_cast<uint64_t>(opr.index()) << 32 | static_cast<uint32_t>(id);
+}
+
+class TailRecursion
+{
+  protected:
+	EeyoreStmtVec &_stmts;
+	int _next_temp = 0, _next_label = 0;
+
+	void _find_free_ids();
+	// Find the local arrays of the function [begin, end) and the variables
+	// that may hold an address into one of them, through moves, additions
+	// and subtractions, by their keys.
+	void _find_local_addrs(size_t begin, size_t end, std::unordered_set<uint64_t> &addrs) const;
+	// The call at `call' is a self tail call of the function [begin, end),
+	// which declares the T-type variables `locals'.
+	bool _is_self_tail_call(size_t begin, size_t call, size_t end,
+		const std::unordered_set<int> &locals, const std::unordered_set<uint64_t> &local_addrs) const;
+
+  public:
+	TailRecursion(EeyoreStmtVec &stmts): _stmts(stmts) { _find_free_ids(); }
+
+	size_t run();
+};
+
+void TailRecursion::_find_free_ids()
+{
+	std::vector<Operand> oprs;
+	auto see = [this](const Operand &opr)
+	{
+		if(auto temp = std::get_if<TempVar>(&opr))
+			_next_temp = std::max(_next_temp, temp->id + 1);
+	};
+	for(const auto &stmt : _stmts)
+	{
+		used_vars(stmt, oprs);
+		std::for_each(oprs.begin(), oprs.end(), see);
+		defined_vars(stmt, oprs);
+		std::for_each(oprs.begin(), oprs.end(), see);
+		std::visit(utils::LambdaVisitor
+		{
+			[&](const DeclStmt &s) { see(s.var); },
+			[this](const LabelStmt &s) { _next_label = std::max(_next_label, s.label.id + 1); },
+			[this](const GotoStmt &s) { _next_label = std::max(_next_label, s.goto_label.id + 1); },
+			[this](const CondGotoStmt &s) { _next_label = std::max(_next_label, s.goto_label.id + 1); },
+			[](const auto &) {}
+		}, stmt);
+	}
+}
+
+void TailRecursion::_find_local_addrs(size_t begin, size_t end,
+	std::unordered_set<uint64_t> &addrs) const
+{
+	addrs.clear();
+	for(size_t i = begin + 1; i < end; i++)
+		if(auto decl = std::get_if<DeclStmt>(&_stmts[i]); decl != nullptr && decl->is_arr)
+			addrs.insert(var_key(decl->var));
+	// The order of the statements is ignored, so a round over them all is
+	// repeated until no more variables are found.
+	for(bool changed = !addrs.empty(); changed; )
+	{
+		changed = false;
+		for(size_t i = begin + 1; i < end; i++)
+		{
+			const Operand *dst = nullptr;
+			bool derived = false;
+			if(auto move = std::get_if<MoveStmt>(&_stmts[i]))
+			{
+				dst = &move->opr;
+				derived = addrs.count(var_key(move->opr1));
+			}
+			else if(auto op = std::get_if<BinaryOpStmt>(&_stmts[i]);
+				op != nullptr && (op->op_type == BinaryOp::ADD || op->op_type == BinaryOp::SUB))
+			{
+				dst = &op->opr;
+				derived = addrs.count(var_key(op->opr1)) || addrs.count(var_key(op->opr2));
+			}
+			if(derived && addrs.insert(var_key(*dst)).second)
+				changed = true;
+		}
+	}
+}
+
+bool TailRecursion::_is_self_tail_call(size_t begin, size_t call, size_t end,
+	const std::unordered_set<int> &locals, const std::unordered_set<uint64_t> &local_addrs) const
+{
+	const auto &def = std::get<FuncDefStmt>(_stmts[begin]);
+	auto func_call = std::get_if<FuncCallStmt>(&_stmts[call]);
+	if(func_call == nullptr || func_call->func_name != def.func_name)
+		return false;
+	// The ParamStmts before the call are all for it.
+	size_t arg_cnt = def.arg_cnt;
+	if(call - begin <= arg_cnt || std::holds_alternative<ParamStmt>(_stmts[call - arg_cnt - 1]))
+		return false;
+	for(size_t i = call - arg_cnt; i < call; i++)
+	{
+		auto param = std::get_if<ParamStmt>(&_stmts[i]);
+		if(param == nullptr)
+			return false;
+		if(local_addrs.count(var_key(param->param)))
+			return false;
+	}
+
+	size_t next = call + 1;
+	while(next < end && std::holds_alternative<LabelStmt>(_stmts[next]))
+		next++;
+	auto ret = next < end? std::get_if<RetStmt>(&_stmts[next]) : nullptr;
+	if(ret == nullptr)
+		return false;
+	// The loop never writes the receiver, which only goes unnoticed if it
+	// is not a global.
+	const auto &receiver = func_call->retval_receiver;
+	if(receiver)
+		if(auto var = std::get_if<OrigVar>(&*receiver); var != nullptr && !locals.count(var->id))
+			return false;
+	if(!ret->retval)
+		return true;
+	return receiver && receiver->index() == ret->retval->index()
+		&& std::visit([&](const auto &opr) { return opr == std::get<std::decay_t<decltype(opr)>>(*receiver); },
+			*ret->retval);
+}
+
+size_t TailRecursion::run()
+{
+	EeyoreStmtVec out(_stmts.get_allocator());
+	out.reserve(_stmts.size());
+	size_t changed = 0;
+	std::vector<size_t> calls;
+	std::unordered_set<int> locals;
+	std::unordered_set<uint64_t> local_addrs;
+	for(size_t begin = 0; begin < _stmts.size(); )
+	{
+		if(!std::holds_alternative<FuncDefStmt>(_stmts[begin]))
+		{
+			out.push_back(std::move(_stmts[begin++]));
+			continue;
+		}
+		size_t end = begin + 1;
+		locals.clear();
+		for(; !std::holds_alternative<EndFuncDefStmt>(_stmts[end]); end++)
+			if(auto decl = std::get_if<DeclStmt>(&_stmts[end]))
+				if(auto var = std::get_if<OrigVar>(&decl->var))
+					locals.insert(var->id);
+		end++;
+		_find_local_addrs(begin, end, local_addrs);
+		calls.clear();
+		for(size_t i = begin + 1; i < end; i++)
+			if(_is_self_tail_call(begin, i, end, locals, local_addrs))
+				calls.push_back(i);
+		if(calls.empty())
+		{
+			std::move(_stmts.begin() + begin, _stmts.begin() + end, std::back_inserter(out));
+			begin = end;
+			continue;
+		}
+
+		// The arguments of each call, as read before any parameter changes.
+		int arg_cnt = std::get<FuncDefStmt>(_stmts[begin]).arg_cnt;
+		std::vector<std::vector<Operand>> args(calls.size());
+		std::vector<EeyoreStatement> copies;
+		for(size_t idx = 0; idx < calls.size(); idx++)
+		{
+			std::vector<bool> assigned(arg_cnt, false);
+			for(int i = 0; i < arg_cnt; i++)
+			{
+				Operand arg = std::get<ParamStmt>(_stmts[calls[idx] - arg_cnt + i]).param;
+				auto param = std::get_if<Param>(&arg);
+				if(param != nullptr && param->id < i && assigned[param->id])
+				{
+					copies.emplace_back(DeclStmt(TempVar(_next_temp)));
+					arg = TempVar(_next_temp++);
+				}
+				assigned[i] = param == nullptr || param->id != i;
+				args[idx].push_back(arg);
+			}
+		}
+
+		out.push_back(std::move(_stmts[begin]));
+		std::move(copies.begin(), copies.end(), std::back_inserter(out));
+		size_t i = begin + 1;
+		while(std::holds_alternative<DeclStmt>(_stmts[i]))
+			out.push_back(std::move(_stmts[i++]));
+		Label entry(_next_label++);
+		out.push_back(LabelStmt(entry));
+		auto next_call = calls.begin();
+		for(; i < end; i++)
+		{
+			if(next_call == calls.end() || i + arg_cnt < *next_call)
+			{
+				out.push_back(std::move(_stmts[i]));
+				continue;
+			}
+			const auto &call_args = args[next_call - calls.begin()];
+			for(int arg = 0; arg < arg_cnt; arg++)
+			{
+				const Operand &orig = std::get<ParamStmt>(_stmts[*next_call - arg_cnt + arg]).param;
+				if(std::holds_alternative<Param>(orig) && !std::holds_alternative<Param>(call_args[arg]))
+					out.push_back(MoveStmt(call_args[arg], orig));
+			}
+			for(int arg = 0; arg < arg_cnt; arg++)
+			{
+				auto param = std::get_if<Param>(&call_args[arg]);
+				if(param == nullptr || param->id != arg)
+					out.push_back(MoveStmt(Param(arg), call_args[arg]));
+			}
+			out.push_back(GotoStmt(entry));
+			i = *next_call++;
+			changed++;
+			++self_tail_calls;
+		}
+		begin = end;
+	}
+	_stmts.swap(out);
+	return changed;
+}
+
+} // namespace
+
+size_t eliminate_tail_recursion(EeyoreStmtVec &stmts)
+{
+	utils::ScopedTimer timer("eliminate tail recursion");
+	return TailRecursion(stmts).run();
+}
+
+} // namespace compiler_skeleton::eeyore
+
+namespace compiler_skeleton::tigger
+{
+
+size_t mark_tail_calls(TiggerStmtVec &stmts)
+{
+	utils::ScopedTimer timer("mark tail calls");
+	size_t marked = 0;
+	for(size_t begin = 0; begin < stmts.size(); )
+	{
+		if(!std::holds_alternative<FuncHeaderStmt>(stmts[begin]))
+		{
+			begin++;
+			continue;
+		}
+		size_t end = begin + 1;
+		bool addr_taken = false;
+		for(; !std::holds_alternative<FuncEndStmt>(stmts[end]); end++)
+		{
+			auto addr = std::get_if<LoadAddrStmt>(&stmts[end]);
+			addr_taken = addr_taken || (addr != nullptr && std::holds_alternative<int>(addr->src));
+		}
+		for(size_t call = begin + 1; !addr_taken && call < end; call++)
+		{
+			if(!std::holds_alternative<FuncCallStmt>(stmts[call]))
+				continue;
+			size_t ret = call + 1;
+			for(; ret < end; ret++)
+			{
+				auto restore = std::get_if<LoadStmt>(&stmts[ret]);
+				if(restore == nullptr || !std::holds_alternative<CalleeSavedReg>(restore->opr)
+					|| !std::holds_alternative<int>(restore->src))
+				{
+					break;
+				}
+			}
+			if(!std::holds_alternative<ReturnStmt>(stmts[ret]))
+				continue;
+			std::rotate(stmts.begin() + call, stmts.begin() + call + 1, stmts.begin() + ret);
+			std::get<FuncCallStmt>(stmts[ret - 1]).is_tail = true;
+			call = ret;
+			marked++;
+			++tail_calls;
+		}
+		begin = end + 1;
+	}
+	return marked;
+}
+
+} // namespace compiler_skeleton::tigger
@@ -0,0 +1,54 @@
+#ifndef SKELETON_TAIL_CALL_H
+#define SKELETON_TAIL_CALL_H
+
+/*
+ * Tail calls, in Eeyore and in Tigger.
+ *
+ *  + `eliminate_tail_recursion' turns self tail calls in Eeyore into loops. A
+ *    self tail call is a call to the function itself, right after the
+ *    ParamStmts of all its arguments, and followed only by labels and a
+ *    RetStmt of its result (or of nothing). It becomes moves of the arguments
+ *    to the parameters and a jump to the entry of the function. Arguments that
+ *    read another parameter go through fresh temporaries first, since the
+ *    parameters are assigned one by one. A call passing a local array (one
+ *    declared with `DeclStmt::is_arr'), or an address computed from one by
+ *    moves, additions and subtractions, is left alone, as the array would be
+ *    reused by the next round. So is a call whose result goes to a global,
+ *    which the loop would never write.
+ *  + `mark_tail_calls' marks the other tail calls in Tigger: a FuncCallStmt
+ *    followed by the restores of callee-saved registers and a ReturnStmt. The
+ *    restores move before the call (the callee keeps the registers anyway),
+ *    so the RISC-V emitter can pop the frame and jump to the callee. Functions
+ *    that take the address of a stack slot are skipped, since the callee may
+ *    use it. Run this last, after the passes that look for the restores (see
+ *    tigger_saves.h).
+ *
+ * Example:
+ *     using namespace compiler_skeleton;
+ *     eeyore::eliminate_tail_recursion(eeyore_stmts);
+ *     ... // lower to Tigger
+ *     tigger::mark_tail_calls(tigger_stmts);
+ *     riscv::emit_riscv(std::cout, tigger_stmts);
+ */
+
+#include <cstddef>
+#include "eeyore.h"
+#include "tigger.h"
+
+namespace compiler_skeleton::eeyore
+{
+
+// Returns the number of calls turned into jumps.
+size_t eliminate_tail_recursion(EeyoreStmtVec &stmts);
+
+} // namespace compiler_skeleton::eeyore
+
+namespace compiler_skeleton::tigger
+{
+
+// Returns the number of calls marked.
+size_t mark_tail_calls(TiggerStmtVec &stmts);
+
+} // namespace compiler_skeleton::tigger
+
+#endif
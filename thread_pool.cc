@@ -0,0 +1,85 @@
+#include <algorithm>
+#include "thread_pool.h"
+
+namespace compiler_skeleton::utils
+{
+
+ThreadPool::ThreadPool(int thread_cnt)
+  : _func(nullptr), _job_size(0), _next_idx(0), _busy_workers(0), _generation(0),
+	_stopping(false)
+{
+	if(thread_cnt <= 0)
+		thread_cnt = std::max(1u, std::thread::hardware_concurrency());
+	for(int i = 1; i < thread_cnt; i++)
+		_workers.emplace_back([this]() { _worker_loop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard lock(_mutex);
+		_stopping = true;
+	}
+	_job_cv.notify_all();
+	for(auto &worker : _workers)
+		worker.join();
+}
+
+void ThreadPool::_run_items()
+{
+	for(size_t idx = _next_idx.fetch_add(1); idx < _job_size; idx = _next_idx.fetch_add(1))
+		(*_func)(idx);
+}
+
+void ThreadPool::_worker_loop()
+{
+	uint64_t seen_generation = 0;
+	while(true)
+	{
+		{
+			std::unique_lock lock(_mutex);
+			_job_cv.wait(lock, [&]() { return _stopping || _generation != seen_generation; });
+			if(_stopping)
+				return;
+			seen_generation = _generation;
+			_busy_workers++;
+		}
+		_run_items();
+		{
+			std::lock_guard lock(_mutex);
+			_busy_workers--;
+		}
+		_done_cv.notify_one();
+	}
+}
+
+void ThreadPool::parallel_for(size_t n, const std::function<void (size_t)> &func)
+{
+	if(_workers.empty() || n <= 1)
+	{
+		for(size_t i = 0; i < n; i++)
+			func(i);
+		return;
+	}
+	{
+		// A worker that woke up too late for the previous job may still be
+		// looking at it.
+		std::unique_lock lock(_mutex);
+		_done_cv.wait(lock, [&]() { return _busy_workers == 0; });
+		_func = &func;
+		_job_size = n;
+		_next_idx.store(0);
+		_generation++;
+	}
+	_job_cv.notify_all();
+	_run_items();
+
+	// Every index has been taken once the caller runs out of work, but some
+	// workers may still be running theirs, or may not have woken up yet (in
+	// which case they find no work left when they do).
+	std::unique_lock lock(_mutex);
+	_done_cv.wait(lock, [&]() { return _busy_workers == 0; });
+	_func = nullptr;
+}
+
+} // namespace compiler_skeleton::utils
@@ -0,0 +1,66 @@
+#ifndef SKELETON_THREAD_POOL_H
+#define SKELETON_THREAD_POOL_H
+
+/*
+ * A fixed-size pool of worker threads for data-parallel loops.
+ *
+ * `parallel_for(n, func)' calls `func(i)' for every i in [0, n) on the pool
+ * (the calling thread takes part as well) and returns when all the calls are
+ * done. Indices are handed out one by one from an atomic counter, so uneven
+ * work items (e.g. functions of very different sizes) balance themselves.
+ *
+ * A pool with one thread runs everything on the calling thread. Calls of
+ * `parallel_for' on the same pool must not overlap.
+ *
+ * Example:
+ *     using namespace compiler_skeleton::utils;
+ *     ThreadPool pool; // one thread per hardware thread
+ *     std::vector<int> res(funcs.size());
+ *     pool.parallel_for(funcs.size(), [&](size_t i) { res[i] = check(funcs[i]); });
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace compiler_skeleton::utils
+{
+
+class ThreadPool
+{
+  protected:
+	std::vector<std::thread> _workers;
+	std::mutex _mutex;
+	std::condition_variable _job_cv, _done_cv;
+
+	// The current job, guarded by `_mutex' except for the atomic counters.
+	const std::function<void (size_t)> *_func;
+	size_t _job_size;
+	std::atomic<size_t> _next_idx;
+	size_t _busy_workers;
+	uint64_t _generation; // bumped for every job, so workers can tell new ones
+	bool _stopping;
+
+	void _worker_loop();
+	void _run_items();
+
+  public:
+	// `thread_cnt' counts the calling thread; 0 means one per hardware thread.
+	explicit ThreadPool(int thread_cnt=0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator = (const ThreadPool &) = delete;
+
+	int thread_cnt() const { return static_cast<int>(_workers.size()) + 1; }
+
+	void parallel_for(size_t n, const std::function<void (size_t)> &func);
+};
+
+} // namespace compiler_skeleton::utils
+
+#endif
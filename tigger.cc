@@ -5,6 +5,8 @@ using std::endl;
 namespace compiler_skeleton::tigger
 {
 
+using ::operator <<; // Printers of Eeyore operators.
+
 void RegPrinter::operator() (const ZeroReg &reg)
 {
 	out << 'x' << reg.id;
@@ -34,17 +36,31 @@ void TiggerPrinter::operator() (const GlobalVarDeclStmt &stmt)
 void TiggerPrinter::operator() (const GlobalArrDeclStmt &stmt)
 {
 	out << stmt.var << " = malloc " << stmt.size << endl;
+	if(stmt.init != nullptr)
+		_inits.emplace_back(stmt.var, stmt.init);
 }
 
 void TiggerPrinter::operator() (const FuncHeaderStmt &stmt)
 {
-	out << stmt.func_name << " [" << stmt.arg_cnt << "] ["
+	out << "f_" << stmt.func_name << " [" << stmt.arg_cnt << "] ["
 		<< stmt.stack_size << ']' << endl;
+	if(stmt.func_name != utils::Symbol("main"))
+		return;
+	for(const auto &[var, init] : _inits)
+	{
+		(*this)(LoadAddrStmt(CallerSavedReg(0), var));
+		init->for_each_nonzero([this](int offset, int val)
+		{
+			(*this)(MoveStmt(CallerSavedReg(1), val));
+			(*this)(WriteArrStmt(CallerSavedReg(0), offset * 4, CallerSavedReg(1)));
+		});
+	}
+	_inits.clear();
 }
 
 void TiggerPrinter::operator() (const FuncEndStmt &stmt)
 {
-	out << "end " << stmt.func_name << endl;
+	out << "end f_" << stmt.func_name << endl;
 }
 
 void TiggerPrinter::operator() (const UnaryOpStmt &stmt)
@@ -91,7 +107,7 @@ void TiggerPrinter::operator() (const LabelStmt &stmt)
 
 void TiggerPrinter::operator() (const FuncCallStmt &stmt)
 {
-	out << "  call " << stmt.func_name << endl;
+	out << "  call f_" << stmt.func_name << endl;
 }
 
 void TiggerPrinter::operator() (const ReturnStmt &stmt)
@@ -114,25 +130,25 @@ void TiggerPrinter::operator() (const LoadAddrStmt &stmt)
 	out << "  loadaddr " << stmt.src << ' ' << stmt.opr << endl;
 }
 
-} // namespace compiler_skeleton::tigger
-
-std::ostream &operator << (std::ostream &out, const compiler_skeleton::tigger::Label &label)
+std::ostream &operator << (std::ostream &out, const Label &label)
 {
 	return out << 'l' << label.id;
 }
 
-std::ostream &operator << (std::ostream &out, const compiler_skeleton::tigger::Reg &reg)
+std::ostream &operator << (std::ostream &out, const Reg &reg)
 {
-	compiler_skeleton::tigger::RegPrinter printer{out};
+	RegPrinter printer{out};
 	std::visit(printer, reg);
 	return out;
 }
 
-std::ostream &operator << (std::ostream &out, const compiler_skeleton::tigger::GlobalVar &global_var)
+std::ostream &operator << (std::ostream &out, const GlobalVar &global_var)
 {
 	return out << 'v' << global_var.id;
 }
 
+} // namespace compiler_skeleton::tigger
+
 std::ostream &operator << (std::ostream &out, const compiler_skeleton::tigger::TiggerStatement &stmt)
 {
 	compiler_skeleton::tigger::TiggerPrinter tigger_printer(out);
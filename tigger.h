@@ -2,9 +2,14 @@
 #define SKELETON_TIGGER_H
 
 #include <iostream>
+#include <memory_resource>
 #include <string>
+#include <utility>
 #include <variant>
+#include <vector>
 #include "variant_printer.h"
+#include "profiler.h"
+#include "symbol.h"
 #include "eeyore.h"
 
 namespace compiler_skeleton::tigger
@@ -76,26 +81,29 @@ struct GlobalArrDeclStmt
 {
 	GlobalVar var;
 	int size;
+	const eeyore::InitData *init; // nullptr if all zero, see eeyore.h
 
-	GlobalArrDeclStmt(GlobalVar _var, int _size)
-	  : var(_var), size(_size) {}
+	GlobalArrDeclStmt(GlobalVar _var, int _size, const eeyore::InitData *_init=nullptr)
+	  : var(_var), size(_size), init(_init) {}
 };
 
+// As in Eeyore, function names do not carry the "f_" prefix, which is added
+// by the printer.
 struct FuncHeaderStmt
 {
-	std::string func_name;
+	utils::Symbol func_name;
 	int arg_cnt;
 	int stack_size;
 
-	FuncHeaderStmt(std::string _func_name, int _arg_cnt, int _stack_size=0)
+	FuncHeaderStmt(utils::Symbol _func_name, int _arg_cnt, int _stack_size=0)
 	  : func_name(_func_name), arg_cnt(_arg_cnt), stack_size(_stack_size) {}
 };
 
 struct FuncEndStmt
 {
-	std::string func_name;
+	utils::Symbol func_name;
 
-	FuncEndStmt(std::string _func_name): func_name(_func_name) {}
+	FuncEndStmt(utils::Symbol _func_name): func_name(_func_name) {}
 };
 
 struct UnaryOpStmt
@@ -169,9 +177,13 @@ struct LabelStmt
 
 struct FuncCallStmt
 {
-	std::string func_name;
+	utils::Symbol func_name;
+	// Directly followed by a ReturnStmt, with nothing left to restore, so the
+	// callee may return to our caller itself (see tail_call.h).
+	bool is_tail;
 
-	FuncCallStmt(std::string _func_name): func_name(_func_name) {}
+	FuncCallStmt(utils::Symbol _func_name, bool _is_tail=false)
+	  : func_name(_func_name), is_tail(_is_tail) {}
 };
 
 struct ReturnStmt
@@ -224,6 +236,10 @@ using TiggerStatement = std::variant
 	LoadAddrStmt
 >;
 
+// A list of statements whose memory comes from a std::pmr resource, e.g. the
+// arena of the compilation unit.
+using TiggerStmtVec = std::pmr::vector<TiggerStatement>;
+
 struct RegPrinter
 {
 	std::ostream &out;
@@ -234,8 +250,14 @@ struct RegPrinter
 	void operator() (const ArgReg &reg);
 };
 
+// The initial data of global arrays is stored by the first statements of
+// f_main, through t0 and t1, which hold nothing yet. So print the declarations
+// and f_main with the same printer, e.g. by printing the whole program at once.
 class TiggerPrinter
 {
+  protected:
+	std::vector<std::pair<GlobalVar, const eeyore::InitData *>> _inits; // not stored yet
+
   public:
 	std::ostream &out;
 
@@ -260,15 +282,19 @@ class TiggerPrinter
 	void operator() (const LoadAddrStmt &stmt);
 };
 
+// These are declared inside the namespace so that the variant printer can find
+// them through ADL when printing RegOrNum and GlobalVarOrNum.
+std::ostream &operator << (std::ostream &out, const Label &label);
+std::ostream &operator << (std::ostream &out, const Reg &reg);
+std::ostream &operator << (std::ostream &out, const GlobalVar &global_var);
+
 } // namespace compiler_skeleton::tigger
 
-std::ostream &operator << (std::ostream &out, const compiler_skeleton::tigger::Label &label);
-std::ostream &operator << (std::ostream &out, const compiler_skeleton::tigger::Reg &reg);
-std::ostream &operator << (std::ostream &out, const compiler_skeleton::tigger::GlobalVar &global_var);
 std::ostream &operator << (std::ostream &out, const compiler_skeleton::tigger::TiggerStatement &stmt);
-template<template<class...> class Container>
-std::ostream &operator << (std::ostream &out, const Container<compiler_skeleton::tigger::TiggerStatement> &stmts)
+template<template<class...> class Container, class ...Ts>
+std::ostream &operator << (std::ostream &out, const Container<compiler_skeleton::tigger::TiggerStatement, Ts...> &stmts)
 {
+	compiler_skeleton::utils::ScopedTimer timer("print tigger");
 	compiler_skeleton::tigger::TiggerPrinter printer{out};
 	for(const auto &stmt : stmts)
 		std::visit(printer, stmt);
@@ -0,0 +1,439 @@
+#include <algorithm>
+#include <numeric>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include "bitmap.h"
+#include "cfg.h"
+#include "profiler.h"
+#include "tigger_frame.h"
+#include "tigger_liveness.h"
+#include "tigger_sched.h"
+
+namespace
+{
+
+using namespace compiler_skeleton::tigger;
+using compiler_skeleton::eeyore::CFG;
+using compiler_skeleton::eeyore::DomTree;
+using compiler_skeleton::eeyore::LoopForest;
+using compiler_skeleton::utils::Bitmap;
+
+compiler_skeleton::utils::Statistic frames_shrunk("frame layout", "frames shrunk");
+compiler_skeleton::utils::Statistic words_saved("frame layout", "stack words saved");
+
+// The slot a statement accesses directly, if any.
+std::optional<int> slot_of(const TiggerStatement &stmt)
+{
+	if(auto store = std::get_if<StoreStmt>(&stmt))
+		return store->stack_offset;
+	if(auto load = std::get_if<LoadStmt>(&stmt); load != nullptr && std::holds_alternative<int>(load->src))
+		return std::get<int>(load->src);
+	if(auto addr = std::get_if<LoadAddrStmt>(&stmt); addr != nullptr && std::holds_alternative<int>(addr->src))
+		return std::get<int>(addr->src);
+	return std::nullopt;
+}
+
+void set_slot(TiggerStatement &stmt, int slot)
+{
+	if(auto store = std::get_if<StoreStmt>(&stmt))
+		store->stack_offset = slot;
+	else if(auto load = std::get_if<LoadStmt>(&stmt))
+		load->src = slot;
+	else
+		std::get<LoadAddrStmt>(stmt).src = slot;
+}
+
+class FrameLayout
+{
+  protected:
+	struct Object
+	{
+		int start, size;
+		bool is_array = false, is_scalar = false;
+		bool pinned = false; // conflicts with every other object
+		double weight = 0;
+		int new_start = -1;
+	};
+
+	TiggerStatement *_stmts;
+	int _stmt_cnt;
+	CFG _cfg;
+	DomTree _dom;
+	LoopForest _loops;
+	std::vector<Object> _objs;
+	std::unordered_map<int, int> _obj_at; // objects by their first slots
+	std::vector<Bitmap> _array_accesses; // arrays accessed in each block
+	std::vector<Bitmap> _scalars_in; // scalars live in or used by each block
+	std::vector<Bitmap> _conflicts;
+
+	// The scalar statement `idx' stores or loads, or -1.
+	int _scalar_at(int idx)
+	{
+		auto slot = slot_of(_stmts[idx]);
+		return !slot || std::holds_alternative<LoadAddrStmt>(_stmts[idx])? -1 : _obj_at[*slot];
+	}
+	double _freq(int block) const;
+	void _find_objects(int stack_size);
+	void _find_array_accesses();
+	void _add_scalar_conflicts();
+	void _add_array_conflicts();
+	int _place(int obj) const;
+
+  public:
+	// [begin, end) is a function, from its FuncHeaderStmt to its FuncEndStmt.
+	FrameLayout(TiggerStatement *begin, TiggerStatement *end);
+
+	// Rewrites the function with the new layout if it is smaller. Returns the
+	// number of words saved.
+	int apply();
+};
+
+FrameLayout::FrameLayout(TiggerStatement *begin, TiggerStatement *end)
+  : _stmts(begin), _stmt_cnt(static_cast<int>(end - begin)),
+	_cfg(begin, end), _dom(_cfg), _loops(_cfg, _dom)
+{
+	_find_objects(std::get<FuncHeaderStmt>(*begin).stack_size);
+	if(_objs.size() < 2)
+		return;
+	int obj_cnt = static_cast<int>(_objs.size());
+	_conflicts.assign(obj_cnt, Bitmap(obj_cnt));
+	_find_array_accesses();
+	_add_scalar_conflicts();
+	_add_array_conflicts();
+	for(int i = 0; i < obj_cnt; i++)
+	{
+		if(_objs[i].is_array && _objs[i].is_scalar)
+			_objs[i].pinned = true;
+		for(int j = 0; j < obj_cnt; j++)
+			if(_objs[i].pinned || _conflicts[i].get(j))
+			{
+				_conflicts[i].set(j);
+				_conflicts[j].set(i);
+			}
+	}
+}
+
+// How often a block runs, as guessed from its loop depth.
+double FrameLayout::_freq(int block) const
+{
+	double freq = 1;
+	for(int depth = std::min(_loops.depth_of(block), 6); depth > 0; depth--)
+		freq *= 8;
+	return freq;
+}
+
+void FrameLayout::_find_objects(int stack_size)
+{
+	std::vector<int> slots;
+	for(int i = 1; i < _stmt_cnt - 1; i++)
+		if(auto slot = slot_of(_stmts[i]))
+			slots.push_back(*slot);
+	std::sort(slots.begin(), slots.end());
+	slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+	for(int slot : slots)
+	{
+		_obj_at[slot] = static_cast<int>(_objs.size());
+		_objs.push_back(Object{slot, 1});
+	}
+	for(int i = 1; i < _stmt_cnt - 1; i++)
+	{
+		if(auto slot = slot_of(_stmts[i]))
+		{
+			Object &obj = _objs[_obj_at[*slot]];
+			(std::holds_alternative<LoadAddrStmt>(_stmts[i])? obj.is_array : obj.is_scalar) = true;
+		}
+	}
+	for(size_t idx = 0; idx < _objs.size(); idx++)
+	{
+		Object &obj = _objs[idx];
+		if(obj.is_array)
+		{
+			int end = idx + 1 < _objs.size()? _objs[idx + 1].start : std::max(stack_size, obj.start + 1);
+			obj.size = end - obj.start;
+		}
+	}
+}
+
+void FrameLayout::_find_array_accesses()
+{
+	int obj_cnt = static_cast<int>(_objs.size());
+	_array_accesses.assign(_cfg.block_cnt(), Bitmap(obj_cnt));
+	RegLiveness liveness(_cfg, _stmts);
+	for(int idx = 0; idx < _cfg.block_cnt(); idx++)
+	{
+		const auto &block = _cfg.block(idx);
+		Bitmap &accessed = _array_accesses[idx];
+		double freq = _freq(idx);
+		auto access = [&](int obj)
+		{
+			accessed.set(obj);
+			_objs[obj].weight += freq;
+		};
+
+		// The array whose address each register holds, or -1.
+		int array_in[REG_KEY_CNT];
+		std::fill(std::begin(array_in), std::end(array_in), -1);
+		for(int i = block.begin; i < block.end; i++)
+		{
+			const TiggerStatement &stmt = _stmts[i];
+			if(auto slot = slot_of(stmt))
+			{
+				int obj = _obj_at[*slot];
+				if(_objs[obj].is_scalar)
+					_objs[obj].weight += freq;
+				if(std::holds_alternative<LoadAddrStmt>(stmt))
+					access(obj);
+			}
+
+			RegSet use, def;
+			reg_effects(stmt, use, def);
+			bool computes = std::holds_alternative<UnaryOpStmt>(stmt)
+				|| std::holds_alternative<BinaryOpStmt>(stmt) || std::holds_alternative<MoveStmt>(stmt);
+			int derived = std::holds_alternative<LoadAddrStmt>(stmt)
+				&& std::holds_alternative<int>(std::get<LoadAddrStmt>(stmt).src)?
+				_obj_at[*slot_of(stmt)] : -1;
+			for(int key = 0; key < REG_KEY_CNT; key++)
+			{
+				int obj = array_in[key];
+				if(!(use >> key & 1) || obj < 0)
+					continue;
+				access(obj);
+				auto write = std::get_if<WriteArrStmt>(&stmt);
+				// The address escapes to memory.
+				if(std::holds_alternative<StoreStmt>(stmt)
+					|| (write != nullptr && reg_key(write->opr) == key))
+				{
+					_objs[obj].pinned = true;
+				}
+				if(computes)
+				{
+					if(derived >= 0 && derived != obj)
+						_objs[derived].pinned = _objs[obj].pinned = true;
+					derived = obj;
+				}
+			}
+			for(int key = 0; key < REG_KEY_CNT; key++)
+				if(def >> key & 1)
+					array_in[key] = derived;
+		}
+
+		RegSet live = liveness.live_out(idx);
+		for(int key = 0; key < REG_KEY_CNT; key++)
+			if(array_in[key] >= 0 && (live >> key & 1))
+				_objs[array_in[key]].pinned = true;
+	}
+}
+
+void FrameLayout::_add_scalar_conflicts()
+{
+	int obj_cnt = static_cast<int>(_objs.size()), block_cnt = _cfg.block_cnt();
+	// Liveness of the scalars, with stores killing them and loads using them.
+	std::vector<Bitmap> gen(block_cnt, Bitmap(obj_cnt)), kill(block_cnt, Bitmap(obj_cnt));
+	std::vector<Bitmap> live_in(block_cnt, Bitmap(obj_cnt)), live_out(block_cnt, Bitmap(obj_cnt));
+	_scalars_in.assign(block_cnt, Bitmap(obj_cnt));
+	for(int idx = 0; idx < block_cnt; idx++)
+	{
+		const auto &block = _cfg.block(idx);
+		for(int i = block.end - 1; i >= block.begin; i--)
+		{
+			int obj = _scalar_at(i);
+			if(obj < 0)
+				continue;
+			_scalars_in[idx].set(obj);
+			if(std::holds_alternative<StoreStmt>(_stmts[i]))
+			{
+				gen[idx].reset(obj);
+				kill[idx].set(obj);
+			}
+			else
+				gen[idx].set(obj);
+		}
+	}
+	const auto &rpo = _cfg.rpo();
+	Bitmap live(obj_cnt);
+	for(bool changed = true; changed; )
+	{
+		changed = false;
+		for(auto iter = rpo.rbegin(); iter != rpo.rend(); ++iter)
+		{
+			live.clear();
+			for(int succ : _cfg.block(*iter).succs)
+				live.union_with(live_in[succ]);
+			live_out[*iter] = live;
+			live.diff_with(kill[*iter]);
+			live.union_with(gen[*iter]);
+			// The sets only grow.
+			if(live.cnt() != live_in[*iter].cnt())
+			{
+				live_in[*iter] = live;
+				changed = true;
+			}
+		}
+	}
+
+	for(int idx : rpo)
+	{
+		// The scalars live on entry all conflict, and each store conflicts
+		// with whatever is live after it.
+		for(int obj = 0; obj < obj_cnt; obj++)
+			if(live_in[idx].get(obj))
+				_conflicts[obj].union_with(live_in[idx]);
+		const auto &block = _cfg.block(idx);
+		live = live_out[idx];
+		for(int i = block.end - 1; i >= block.begin; i--)
+		{
+			int obj = _scalar_at(i);
+			if(obj < 0)
+				continue;
+			if(std::holds_alternative<StoreStmt>(_stmts[i]))
+			{
+				_conflicts[obj].union_with(live);
+				live.reset(obj);
+			}
+			else
+				live.set(obj);
+		}
+		_scalars_in[idx].union_with(live_in[idx]);
+		_scalars_in[idx].union_with(live_out[idx]);
+	}
+}
+
+void FrameLayout::_add_array_conflicts()
+{
+	int obj_cnt = static_cast<int>(_objs.size()), block_cnt = _cfg.block_cnt();
+	// Arrays accessed in or after each block, by a backward flow, and in or
+	// before it, by a forward one. Accesses never kill.
+	std::vector<Bitmap> later(block_cnt, Bitmap(obj_cnt)), before(block_cnt, Bitmap(obj_cnt));
+	const auto &rpo = _cfg.rpo();
+	Bitmap set(obj_cnt);
+	for(bool changed = true; changed; )
+	{
+		changed = false;
+		for(auto iter = rpo.rbegin(); iter != rpo.rend(); ++iter)
+		{
+			set = _array_accesses[*iter];
+			for(int succ : _cfg.block(*iter).succs)
+				set.union_with(later[succ]);
+			if(set.cnt() != later[*iter].cnt())
+			{
+				later[*iter] = set;
+				changed = true;
+			}
+		}
+	}
+	for(bool changed = true; changed; )
+	{
+		changed = false;
+		for(int idx : rpo)
+		{
+			set = _array_accesses[idx];
+			for(int pred : _cfg.block(idx).preds)
+				set.union_with(before[pred]);
+			if(set.cnt() != before[idx].cnt())
+			{
+				before[idx] = set;
+				changed = true;
+			}
+		}
+	}
+
+	for(int idx : rpo)
+	{
+		// The arrays accessed both before and after the block, or in it.
+		Bitmap &arrays = later[idx];
+		set.clear();
+		for(int pred : _cfg.block(idx).preds)
+			set.union_with(before[pred]);
+		arrays.intersect_with(set);
+		arrays.union_with(_array_accesses[idx]);
+		Bitmap occupied = arrays;
+		occupied.union_with(_scalars_in[idx]);
+		for(int obj = 0; obj < obj_cnt; obj++)
+			if(arrays.get(obj))
+				_conflicts[obj].union_with(occupied);
+	}
+}
+
+// The lowest offset where `obj' is clear of the objects placed that conflict
+// with it.
+int FrameLayout::_place(int obj) const
+{
+	std::vector<std::pair<int, int>> taken;
+	for(int other = 0; other < static_cast<int>(_objs.size()); other++)
+		if(_objs[other].new_start >= 0 && _conflicts[obj].get(other))
+			taken.emplace_back(_objs[other].new_start, _objs[other].new_start + _objs[other].size);
+	std::sort(taken.begin(), taken.end());
+	int start = 0;
+	for(const auto &[begin, end] : taken)
+	{
+		if(begin >= start + _objs[obj].size)
+			break;
+		start = std::max(start, end);
+	}
+	return start;
+}
+
+int FrameLayout::apply()
+{
+	auto &header = std::get<FuncHeaderStmt>(_stmts[0]);
+	if(_objs.size() < 2)
+		return 0;
+	std::vector<int> order(_objs.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [this](int obj1, int obj2)
+	{
+		return _objs[obj1].weight / _objs[obj1].size > _objs[obj2].weight / _objs[obj2].size;
+	});
+	int stack_size = 0;
+	for(int obj : order)
+	{
+		_objs[obj].new_start = _place(obj);
+		stack_size = std::max(stack_size, _objs[obj].new_start + _objs[obj].size);
+	}
+	if(stack_size >= header.stack_size)
+		return 0;
+
+	for(int i = 1; i < _stmt_cnt - 1; i++)
+		if(auto slot = slot_of(_stmts[i]))
+		{
+			const Object &obj = _objs[_obj_at[*slot]];
+			set_slot(_stmts[i], obj.new_start + (*slot - obj.start));
+		}
+	int saved = header.stack_size - stack_size;
+	header.stack_size = stack_size;
+	return saved;
+}
+
+} // namespace
+
+namespace compiler_skeleton::tigger
+{
+
+int layout_frames(TiggerStatement *begin, TiggerStatement *end)
+{
+	utils::ScopedTimer timer("layout frames");
+	int saved = 0;
+	for(TiggerStatement *func = begin; func != end; )
+	{
+		if(!std::holds_alternative<FuncHeaderStmt>(*func))
+		{
+			++func;
+			continue;
+		}
+		TiggerStatement *func_end = func + 1;
+		while(!std::holds_alternative<FuncEndStmt>(*func_end))
+			++func_end;
+		++func_end;
+		if(int func_saved = FrameLayout(func, func_end).apply(); func_saved > 0)
+		{
+			saved += func_saved;
+			++frames_shrunk;
+			words_saved += func_saved;
+		}
+		func = func_end;
+	}
+	return saved;
+}
+
+} // namespace compiler_skeleton::tigger
@@ -0,0 +1,52 @@
+#ifndef SKELETON_TIGGER_FRAME_H
+#define SKELETON_TIGGER_FRAME_H
+
+/*
+ * Stack frame layout of Tigger functions, by stack slot coloring.
+ *
+ * The objects in a frame are found from the slots the function uses: a slot
+ * that is stored to and loaded from holds a scalar (a spilled temporary or a
+ * saved register), and a slot whose address is taken is the base of an array
+ * that extends up to the next slot used (or the end of the frame). Arrays are
+ * thus expected to be reached through their bases only.
+ *
+ * Two objects may share stack space unless their live ranges overlap:
+ *  + A scalar is live from a store to the loads reading it, as registers are.
+ *    Each store conflicts with all the objects live after it, even if its own
+ *    value is never read.
+ *  + An array is live wherever it has been accessed before and is accessed
+ *    again, by block. Its accesses are the statements using a register that
+ *    holds its address (or an address computed from it), within the block
+ *    that took the address. If such a register lives on past the block, or is
+ *    stored to memory, the array is kept apart from all the others.
+ *
+ * The objects are then placed greedily, each at the lowest offset free of
+ * the objects it conflicts with, hottest first: accesses in loops count more,
+ * and the count is divided by the object size. Hot scalars thus get small
+ * offsets, which RISC-V encodes in fewer instructions, and the frame shrinks,
+ * which helps deep recursion.
+ *
+ * Example:
+ *     using namespace compiler_skeleton::tigger;
+ *     int words_saved = layout_frames(stmts);
+ */
+
+#include "tigger.h"
+
+namespace compiler_skeleton::tigger
+{
+
+// Lays out the frames of all the functions in [begin, end) anew, in place.
+// Returns the number of stack words saved.
+int layout_frames(TiggerStatement *begin, TiggerStatement *end);
+
+// The same, for a container of TiggerStatements with contiguous storage.
+template<class Container>
+int layout_frames(Container &stmts)
+{
+	return layout_frames(stmts.data(), stmts.data() + stmts.size());
+}
+
+} // namespace compiler_skeleton::tigger
+
+#endif
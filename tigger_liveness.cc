@@ -0,0 +1,94 @@
+#include "tigger_sched.h"
+#include "tigger_liveness.h"
+
+namespace
+{
+
+using namespace compiler_skeleton::tigger;
+
+template<class RegVec>
+RegSet regs_of(const RegVec &regs)
+{
+	RegSet set = 0;
+	for(const auto &reg : regs)
+		set |= reg_bit(reg);
+	return set;
+}
+
+} // namespace
+
+namespace compiler_skeleton::tigger
+{
+
+RegSet reg_bit(const Reg &reg)
+{
+	int key = reg_key(reg);
+	return key < 0? 0 : RegSet(1) << key;
+}
+
+void reg_effects(const TiggerStatement &stmt, RegSet &use, RegSet &def)
+{
+	static const RegSet ARG_REGS = regs_of(ALL_ARG_REG);
+	static const RegSet CALL_CLOBBERED = ARG_REGS | regs_of(ALL_CALLER_SAVED_REG);
+	thread_local std::vector<Reg> regs;
+
+	if(std::holds_alternative<FuncCallStmt>(stmt))
+	{
+		use = ARG_REGS; // the arguments, as far as we know
+		def = CALL_CLOBBERED;
+	}
+	else if(std::holds_alternative<ReturnStmt>(stmt))
+	{
+		use = reg_bit(ArgReg(0));
+		def = 0;
+	}
+	else
+	{
+		used_regs(stmt, regs);
+		use = regs_of(regs);
+		defined_regs(stmt, regs);
+		def = regs_of(regs);
+	}
+}
+
+RegLiveness::RegLiveness(const eeyore::CFG &cfg, const TiggerStatement *func,
+	const std::vector<char> *skip)
+  : _live_in(cfg.block_cnt(), 0), _live_out(cfg.block_cnt(), 0)
+{
+	int block_cnt = cfg.block_cnt();
+	std::vector<RegSet> gen(block_cnt, 0), kill(block_cnt, 0);
+	for(int idx = 0; idx < block_cnt; idx++)
+	{
+		const auto &block = cfg.block(idx);
+		for(int i = block.end - 1; i >= block.begin; i--)
+		{
+			if(skip != nullptr && (*skip)[i])
+				continue;
+			RegSet use, def;
+			reg_effects(func[i], use, def);
+			gen[idx] = (gen[idx] & ~def) | use;
+			kill[idx] |= def;
+		}
+	}
+
+	const auto &rpo = cfg.rpo();
+	for(bool changed = true; changed; )
+	{
+		changed = false;
+		for(auto iter = rpo.rbegin(); iter != rpo.rend(); ++iter)
+		{
+			RegSet out = 0;
+			for(int succ : cfg.block(*iter).succs)
+				out |= _live_in[succ];
+			RegSet in = gen[*iter] | (out & ~kill[*iter]);
+			if(in != _live_in[*iter] || out != _live_out[*iter])
+			{
+				_live_in[*iter] = in;
+				_live_out[*iter] = out;
+				changed = true;
+			}
+		}
+	}
+}
+
+} // namespace compiler_skeleton::tigger
@@ -0,0 +1,51 @@
+#ifndef SKELETON_TIGGER_LIVENESS_H
+#define SKELETON_TIGGER_LIVENESS_H
+
+/*
+ * Register liveness of Tigger functions, for the back end passes.
+ *
+ * Registers are kept in 64-bit sets, by their `reg_key's (see tigger_sched.h).
+ * Calls are taken to read all the argument registers and to clobber them and
+ * the caller-saved ones, and returns to read a0. Callee-saved registers are
+ * not live at returns: the restores before them, if any, read the values.
+ *
+ * Example:
+ *     using namespace compiler_skeleton::tigger;
+ *     eeyore::CFG cfg(func.data(), func.data() + func.size());
+ *     RegLiveness liveness(cfg, func.data());
+ *     if(liveness.live_out(0) & reg_bit(CalleeSavedReg(0)))
+ *         std::cout << "s0 lives past the entry block" << std::endl;
+ */
+
+#include <cstdint>
+#include <vector>
+#include "cfg.h"
+#include "tigger.h"
+
+namespace compiler_skeleton::tigger
+{
+
+using RegSet = uint64_t;
+
+RegSet reg_bit(const Reg &reg);
+// The registers `stmt' reads and writes.
+void reg_effects(const TiggerStatement &stmt, RegSet &use, RegSet &def);
+
+class RegLiveness
+{
+  protected:
+	std::vector<RegSet> _live_in, _live_out;
+
+  public:
+	// `func' is the function `cfg' was built from. The statements marked in
+	// `skip', if given, are left out.
+	RegLiveness(const eeyore::CFG &cfg, const TiggerStatement *func,
+		const std::vector<char> *skip=nullptr);
+
+	RegSet live_in(int block) const { return _live_in[block]; }
+	RegSet live_out(int block) const { return _live_out[block]; }
+};
+
+} // namespace compiler_skeleton::tigger
+
+#endif
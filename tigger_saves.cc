@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <utility>
+#include "cfg.h"
+#include "lambda_visitor.h"
+#include "profiler.h"
+#include "tigger_liveness.h"
+#include "tigger_sched.h"
+#include "tigger_saves.h"
+
+namespace
+{
+
+using namespace compiler_skeleton::tigger;
+using compiler_skeleton::eeyore::CFG;
+using compiler_skeleton::eeyore::DomTree;
+using compiler_skeleton::eeyore::LoopForest;
+
+compiler_skeleton::utils::Statistic saves_removed("callee saves", "unneeded saves removed");
+compiler_skeleton::utils::Statistic regs_renamed("callee saves", "registers moved to caller-saved ones");
+compiler_skeleton::utils::Statistic saves_wrapped("callee saves", "saves shrink-wrapped");
+
+void rename_regs(TiggerStatement &stmt, const std::optional<Reg> *renames)
+{
+	auto rename = [renames](Reg &reg)
+	{
+		if(int key = reg_key(reg); key >= 0 && renames[key])
+			reg = *renames[key];
+	};
+	auto rename_opt = [&rename](RegOrNum &opr)
+	{
+		if(auto reg = std::get_if<Reg>(&opr))
+			rename(*reg);
+	};
+	std::visit(compiler_skeleton::utils::LambdaVisitor
+	{
+		[&](UnaryOpStmt &s) { rename(s.opr); rename(s.opr1); },
+		[&](BinaryOpStmt &s) { rename(s.opr); rename(s.opr1); rename_opt(s.opr2); },
+		[&](MoveStmt &s) { rename(s.opr); rename_opt(s.opr1); },
+		[&](ReadArrStmt &s) { rename(s.opr); rename(s.opr1); },
+		[&](WriteArrStmt &s) { rename(s.opr); rename(s.opr1); },
+		[&](CondGotoStmt &s) { rename(s.opr1); rename(s.opr2); },
+		[&](StoreStmt &s) { rename(s.opr); },
+		[&](LoadStmt &s) { rename(s.opr); },
+		[&](LoadAddrStmt &s) { rename(s.opr); },
+		[](auto &) {}
+	}, stmt);
+}
+
+class FuncSaves
+{
+  protected:
+	struct SavedReg
+	{
+		int id, slot;
+	};
+	struct Insertion
+	{
+		int pos; // the statement to insert before
+		TiggerStatement stmt;
+	};
+
+	TiggerStatement *_stmts;
+	int _stmt_cnt;
+	CFG _cfg;
+	DomTree _dom;
+	LoopForest _loops;
+	std::vector<SavedReg> _saved;
+	std::vector<char> _is_save; // the saves and restores found
+	std::optional<RegLiveness> _liveness;
+	RegSet _used, _live_across_calls = 0; // `_used' includes the reserved register
+
+	void _find_saves();
+	void _effects(int idx, RegSet &use, RegSet &def) const;
+	void _scan_regs();
+	int _save_block(const std::vector<int> &blocks) const;
+	bool _in_cycle(int block) const;
+
+  public:
+	// [begin, end) is a function, from its FuncHeaderStmt to its FuncEndStmt.
+	// `reserved' is never taken by a rename.
+	FuncSaves(TiggerStatement *begin, TiggerStatement *end, Reg reserved);
+
+	// Moves the function to `out', with its saves placed anew.
+	size_t place(TiggerStmtVec &out);
+};
+
+FuncSaves::FuncSaves(TiggerStatement *begin, TiggerStatement *end, Reg reserved)
+  : _stmts(begin), _stmt_cnt(static_cast<int>(end - begin)),
+	_cfg(begin, end), _dom(_cfg), _loops(_cfg, _dom), _is_save(_stmt_cnt, false),
+	_used(reg_bit(reserved))
+{
+	_find_saves();
+	if(!_saved.empty())
+	{
+		_liveness.emplace(_cfg, _stmts, &_is_save);
+		_scan_regs();
+	}
+}
+
+void FuncSaves::_find_saves()
+{
+	int slot_of[REG_KEY_CNT];
+	std::fill(std::begin(slot_of), std::end(slot_of), -1);
+	for(int i = 1; i < _stmt_cnt; i++)
+	{
+		auto save = std::get_if<StoreStmt>(&_stmts[i]);
+		if(save == nullptr || !std::holds_alternative<CalleeSavedReg>(save->opr))
+			break;
+		int key = reg_key(save->opr);
+		if(slot_of[key] >= 0)
+			break;
+		slot_of[key] = save->stack_offset;
+		_saved.push_back(SavedReg{std::get<CalleeSavedReg>(save->opr).id, save->stack_offset});
+		_is_save[i] = true;
+	}
+	for(const auto &block : _cfg.blocks())
+	{
+		if(block.end == block.begin || !std::holds_alternative<ReturnStmt>(_stmts[block.end - 1]))
+			continue;
+		for(int i = block.end - 2; i >= block.begin; i--)
+		{
+			auto restore = std::get_if<LoadStmt>(&_stmts[i]);
+			if(restore == nullptr || !std::holds_alternative<CalleeSavedReg>(restore->opr)
+				|| !std::holds_alternative<int>(restore->src)
+				|| std::get<int>(restore->src) != slot_of[reg_key(restore->opr)])
+			{
+				break;
+			}
+			_is_save[i] = true;
+		}
+	}
+}
+
+void FuncSaves::_effects(int idx, RegSet &use, RegSet &def) const
+{
+	if(_is_save[idx])
+		use = def = 0;
+	else
+		reg_effects(_stmts[idx], use, def);
+}
+
+void FuncSaves::_scan_regs()
+{
+	for(int idx = 0; idx < _cfg.block_cnt(); idx++)
+	{
+		const auto &block = _cfg.block(idx);
+		RegSet live = _liveness->live_out(idx);
+		for(int i = block.end - 1; i >= block.begin; i--)
+		{
+			RegSet use, def;
+			_effects(i, use, def);
+			if(std::holds_alternative<FuncCallStmt>(_stmts[i]))
+				_live_across_calls |= live & ~def;
+			else
+				_used |= use | def;
+			live = (live & ~def) | use;
+		}
+	}
+}
+
+// The nearest block dominating all of `blocks' and in no loop.
+int FuncSaves::_save_block(const std::vector<int> &blocks) const
+{
+	int save = blocks[0];
+	for(int block : blocks)
+		while(!_dom.dominates(save, block))
+			save = _dom.idom(save);
+	if(int loop = _loops.loop_of(save); loop >= 0)
+	{
+		while(_loops.loop(loop).parent >= 0)
+			loop = _loops.loop(loop).parent;
+		save = _dom.idom(_loops.loop(loop).header);
+	}
+	// Irreducible cycles are not loops, but a save in one would still run
+	// again after the register is written.
+	return save < 0 || _in_cycle(save)? 0 : save;
+}
+
+bool FuncSaves::_in_cycle(int block) const
+{
+	std::vector<char> visited(_cfg.block_cnt(), false);
+	std::vector<int> stack(_cfg.block(block).succs);
+	while(!stack.empty())
+	{
+		int cur = stack.back();
+		stack.pop_back();
+		if(cur == block)
+			return true;
+		if(visited[cur])
+			continue;
+		visited[cur] = true;
+		stack.insert(stack.end(), _cfg.block(cur).succs.begin(), _cfg.block(cur).succs.end());
+	}
+	return false;
+}
+
+size_t FuncSaves::place(TiggerStmtVec &out)
+{
+	std::vector<Insertion> insertions;
+	std::optional<Reg> renames[REG_KEY_CNT];
+	size_t changed = 0;
+	for(const SavedReg &saved : _saved)
+	{
+		Reg reg = CalleeSavedReg(saved.id);
+		RegSet bit = reg_bit(reg);
+		std::vector<int> writes, returns;
+		for(int idx : _cfg.rpo())
+		{
+			RegSet use, def = 0;
+			const auto &block = _cfg.block(idx);
+			for(int i = block.begin; i < block.end && !(def & bit); i++)
+				_effects(i, use, def);
+			if(def & bit)
+				writes.push_back(idx);
+		}
+		if(writes.empty())
+		{
+			changed++;
+			++saves_removed;
+			continue;
+		}
+
+		if(!(_live_across_calls & bit) && !(_liveness->live_in(0) & bit))
+		{
+			// The caller-saved registers are left to the calls.
+			std::optional<Reg> free_reg;
+			for(const CallerSavedReg &caller_saved : ALL_CALLER_SAVED_REG)
+				if(!(_used & reg_bit(caller_saved)))
+				{
+					free_reg = caller_saved;
+					break;
+				}
+			if(free_reg)
+			{
+				_used |= reg_bit(*free_reg);
+				renames[reg_key(reg)] = free_reg;
+				changed++;
+				++regs_renamed;
+				continue;
+			}
+		}
+
+		// The returns reached from a write need the register restored.
+		std::vector<char> reached(_cfg.block_cnt(), false);
+		std::vector<int> stack(writes);
+		while(!stack.empty())
+		{
+			int idx = stack.back();
+			stack.pop_back();
+			if(reached[idx])
+				continue;
+			reached[idx] = true;
+			const auto &block = _cfg.block(idx);
+			if(block.end > block.begin && std::holds_alternative<ReturnStmt>(_stmts[block.end - 1]))
+				returns.push_back(idx);
+			stack.insert(stack.end(), block.succs.begin(), block.succs.end());
+		}
+		writes.insert(writes.end(), returns.begin(), returns.end());
+		int save_block = _save_block(writes);
+
+		const auto &block = _cfg.block(save_block);
+		int save_pos = block.begin;
+		if(save_pos < block.end && std::holds_alternative<LabelStmt>(_stmts[save_pos]))
+			save_pos++;
+		insertions.push_back(Insertion{save_pos, StoreStmt(saved.slot, reg)});
+		for(int idx : returns)
+			insertions.push_back(Insertion{_cfg.block(idx).end - 1, LoadStmt(reg, saved.slot)});
+
+		int return_cnt = 0;
+		for(const auto &block : _cfg.blocks())
+			return_cnt += block.end > block.begin
+				&& std::holds_alternative<ReturnStmt>(_stmts[block.end - 1]);
+		if(save_block != 0 || static_cast<int>(returns.size()) != return_cnt)
+		{
+			changed++;
+			++saves_wrapped;
+		}
+	}
+	if(changed == 0)
+	{
+		std::move(_stmts, _stmts + _stmt_cnt, std::back_inserter(out));
+		return 0;
+	}
+
+	std::stable_sort(insertions.begin(), insertions.end(),
+		[](const Insertion &a, const Insertion &b) { return a.pos < b.pos; });
+	auto next = insertions.begin();
+	for(int i = 0; i < _stmt_cnt; i++)
+	{
+		for(; next != insertions.end() && next->pos == i; ++next)
+			out.push_back(std::move(next->stmt));
+		if(_is_save[i])
+			continue;
+		rename_regs(_stmts[i], renames);
+		out.push_back(std::move(_stmts[i]));
+	}
+	return changed;
+}
+
+} // namespace
+
+namespace compiler_skeleton::tigger
+{
+
+size_t place_callee_saves(TiggerStmtVec &stmts, Reg reserved)
+{
+	utils::ScopedTimer timer("place callee saves");
+	TiggerStmtVec out(stmts.get_allocator());
+	out.reserve(stmts.size());
+	size_t changed = 0;
+	for(size_t i = 0; i < stmts.size(); )
+	{
+		if(!std::holds_alternative<FuncHeaderStmt>(stmts[i]))
+		{
+			out.push_back(std::move(stmts[i++]));
+			continue;
+		}
+		size_t end = i + 1;
+		while(!std::holds_alternative<FuncEndStmt>(stmts[end]))
+			end++;
+		end++;
+		changed += FuncSaves(stmts.data() + i, stmts.data() + end, reserved).place(out);
+		i = end;
+	}
+	stmts.swap(out);
+	return changed;
+}
+
+} // namespace compiler_skeleton::tigger
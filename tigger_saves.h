@@ -0,0 +1,48 @@
+#ifndef SKELETON_TIGGER_SAVES_H
+#define SKELETON_TIGGER_SAVES_H
+
+/*
+ * Placement of the saves and restores of callee-saved registers in Tigger
+ * functions.
+ *
+ * A function is expected to save the callee-saved registers it uses with the
+ * StoreStmts right after its FuncHeaderStmt, and to restore them with the
+ * LoadStmts (from the same stack slots) right before each ReturnStmt. For
+ * each register saved that way:
+ *  + If the function never writes the register, its save and restores are
+ *    removed.
+ *  + If it is live across no call, keeping it in a caller-saved register costs
+ *    nothing, while a callee-saved one costs a save and a restore; so it is
+ *    renamed to a caller-saved register the function does not use, if there is
+ *    one, and the save and restores are removed. The scratch register of the
+ *    RISC-V emitter (see riscv.h) must stay free, so it is passed in as
+ *    reserved and never taken. A register live across calls
+ *    would need a save and a restore around each of them instead, which is
+ *    never cheaper, so it stays where it is.
+ *  + Otherwise the save is shrink-wrapped: it is moved to the nearest block
+ *    dominating all the writes to the register and the returns they reach,
+ *    outside of any loop, and only those returns restore the register. Early
+ *    returns before the register is written then skip both.
+ *
+ * The stack slots freed stay in the frame.
+ *
+ * Example:
+ *     using namespace compiler_skeleton::tigger;
+ *     size_t changed = place_callee_saves(stmts);
+ *     riscv::emit_riscv(std::cout, stmts);
+ */
+
+#include <cstddef>
+#include "tigger.h"
+
+namespace compiler_skeleton::tigger
+{
+
+// Returns the number of saved registers whose saves were removed, renamed or
+// moved. `reserved' is never a rename target; by default it is t6, the
+// scratch register of the RISC-V emitter.
+size_t place_callee_saves(TiggerStmtVec &stmts, Reg reserved=CallerSavedReg(6));
+
+} // namespace compiler_skeleton::tigger
+
+#endif
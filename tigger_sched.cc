@@ -0,0 +1,346 @@
+#include <algorithm>
+#include "lambda_visitor.h"
+#include "profiler.h"
+#include "tigger_sched.h"
+
+namespace
+{
+
+using namespace compiler_skeleton::tigger;
+
+compiler_skeleton::utils::Statistic regions_scheduled("tigger sched", "regions reordered");
+
+// Longer straight-line runs are scheduled in windows of this size, which
+// bounds the quadratic parts of building the DAG and of issuing.
+constexpr int MAX_REGION_SIZE = 256;
+inline bool ends_region(const TiggerStatement &stmt)
+{
+	return std::visit(compiler_skeleton::utils::LambdaVisitor
+	{
+		[](const UnaryOpStmt &) { return false; },
+		[](const BinaryOpStmt &) { return false; },
+		[](const MoveStmt &) { return false; },
+		[](const ReadArrStmt &) { return false; },
+		[](const WriteArrStmt &) { return false; },
+		[](const StoreStmt &) { return false; },
+		[](const LoadStmt &) { return false; },
+		[](const LoadAddrStmt &) { return false; },
+		[](const auto &) { return true; }
+	}, stmt);
+}
+
+struct MemAccess
+{
+	enum Kind { NONE, STACK, GLOBAL, ANY } kind;
+	int id; // stack offset or global variable id
+	bool is_write;
+
+	bool may_alias(const MemAccess &other) const
+	{
+		return kind == ANY || other.kind == ANY || (kind == other.kind && id == other.id);
+	}
+};
+
+MemAccess mem_access_of(const TiggerStatement &stmt)
+{
+	return std::visit(compiler_skeleton::utils::LambdaVisitor
+	{
+		[](const LoadStmt &s)
+		{
+			if(auto offset = std::get_if<int>(&s.src))
+				return MemAccess{MemAccess::STACK, *offset, false};
+			return MemAccess{MemAccess::GLOBAL, std::get<GlobalVar>(s.src).id, false};
+		},
+		[](const StoreStmt &s) { return MemAccess{MemAccess::STACK, s.stack_offset, true}; },
+		// Arrays are reached through addresses, which may point anywhere.
+		[](const ReadArrStmt &) { return MemAccess{MemAccess::ANY, 0, false}; },
+		[](const WriteArrStmt &) { return MemAccess{MemAccess::ANY, 0, true}; },
+		[](const auto &) { return MemAccess{MemAccess::NONE, 0, false}; }
+	}, stmt);
+}
+
+class RegionScheduler
+{
+  protected:
+	struct Edge
+	{
+		int to, latency;
+	};
+
+	const LatencyModel &_model;
+	std::vector<std::vector<Edge>> _succs;
+	std::vector<int> _pred_cnt, _height, _ready_time, _order;
+	std::vector<Reg> _regs;
+	std::vector<TiggerStatement> _tmp;
+
+	void _add_edge(int from, int to, int latency)
+	{
+		_succs[from].push_back(Edge{to, latency});
+		_pred_cnt[to]++;
+	}
+	void _build_dag(const TiggerStatement *stmts, int n);
+	void _issue(int n);
+
+  public:
+	RegionScheduler(const LatencyModel &model): _model(model) {}
+
+	// Returns true if the order changed.
+	bool schedule(TiggerStatement *stmts, int n);
+};
+
+void RegionScheduler::_build_dag(const TiggerStatement *stmts, int n)
+{
+	_succs.assign(n, {});
+	_pred_cnt.assign(n, 0);
+	int last_def[REG_KEY_CNT];
+	std::fill(std::begin(last_def), std::end(last_def), -1);
+	std::vector<int> uses_since_def[REG_KEY_CNT];
+	std::vector<int> mem_ops;
+
+	for(int i = 0; i < n; i++)
+	{
+		used_regs(stmts[i], _regs);
+		for(const Reg &reg : _regs)
+		{
+			int key = reg_key(reg);
+			if(key < 0)
+				continue;
+			if(last_def[key] >= 0) // true dependency
+				_add_edge(last_def[key], i, _model.latency(stmts[last_def[key]]));
+			uses_since_def[key].push_back(i);
+		}
+		defined_regs(stmts[i], _regs);
+		for(const Reg &reg : _regs)
+		{
+			int key = reg_key(reg);
+			if(key < 0)
+				continue;
+			for(int use : uses_since_def[key]) // anti dependencies
+				if(use != i)
+					_add_edge(use, i, 0);
+			if(last_def[key] >= 0) // output dependency
+				_add_edge(last_def[key], i, 0);
+			last_def[key] = i;
+			uses_since_def[key].clear();
+		}
+
+		MemAccess access = mem_access_of(stmts[i]);
+		if(access.kind == MemAccess::NONE)
+			continue;
+		// Everything before a write that may alias anything is ordered
+		// before that write already, so the scan stops there.
+		for(auto iter = mem_ops.rbegin(); iter != mem_ops.rend(); ++iter)
+		{
+			MemAccess prev = mem_access_of(stmts[*iter]);
+			if((prev.is_write || access.is_write) && prev.may_alias(access))
+				_add_edge(*iter, i, prev.is_write && !access.is_write? 1 : 0);
+			if(prev.is_write && prev.kind == MemAccess::ANY)
+				break;
+		}
+		mem_ops.push_back(i);
+	}
+
+	// The longest latency path from each statement to the end of the region.
+	_height.assign(n, 0);
+	for(int i = n - 1; i >= 0; i--)
+	{
+		_height[i] = _model.latency(stmts[i]);
+		for(const Edge &edge : _succs[i])
+			_height[i] = std::max(_height[i], edge.latency + _height[edge.to]);
+	}
+}
+
+void RegionScheduler::_issue(int n)
+{
+	_ready_time.assign(n, 0);
+	_order.clear();
+	std::vector<int> candidates;
+	for(int i = 0; i < n; i++)
+		if(_pred_cnt[i] == 0)
+			candidates.push_back(i);
+
+	for(int cycle = 0; !candidates.empty(); )
+	{
+		int best = -1, best_pos = -1, earliest = -1;
+		for(int pos = 0; pos < static_cast<int>(candidates.size()); pos++)
+		{
+			int idx = candidates[pos];
+			if(earliest < 0 || _ready_time[idx] < earliest)
+				earliest = _ready_time[idx];
+			if(_ready_time[idx] > cycle)
+				continue;
+			if(best < 0 || _height[idx] > _height[best]
+				|| (_height[idx] == _height[best] && idx < best))
+			{
+				best = idx;
+				best_pos = pos;
+			}
+		}
+		if(best < 0) // nothing is ready, wait for the first one
+		{
+			cycle = earliest;
+			continue;
+		}
+		candidates[best_pos] = candidates.back();
+		candidates.pop_back();
+		_order.push_back(best);
+		for(const Edge &edge : _succs[best])
+		{
+			_ready_time[edge.to] = std::max(_ready_time[edge.to], cycle + edge.latency);
+			if(--_pred_cnt[edge.to] == 0)
+				candidates.push_back(edge.to);
+		}
+		cycle++;
+	}
+}
+
+bool RegionScheduler::schedule(TiggerStatement *stmts, int n)
+{
+	_build_dag(stmts, n);
+	_issue(n);
+	bool changed = false;
+	for(int i = 0; i < n; i++)
+		changed = changed || _order[i] != i;
+	if(!changed)
+		return false;
+	_tmp.clear();
+	for(int idx : _order)
+		_tmp.push_back(std::move(stmts[idx]));
+	std::move(_tmp.begin(), _tmp.end(), stmts);
+	return true;
+}
+
+} // namespace
+
+namespace compiler_skeleton::tigger
+{
+
+int LatencyModel::latency(const TiggerStatement &stmt) const
+{
+	return std::visit(utils::LambdaVisitor
+	{
+		[this](const LoadStmt &) { return load; },
+		[this](const ReadArrStmt &) { return load; },
+		[this](const BinaryOpStmt &s)
+		{
+			switch(s.op_type)
+			{
+				case BinaryOp::MUL: return mul;
+				case BinaryOp::DIV:
+				case BinaryOp::MOD: return div;
+				default: return alu;
+			}
+		},
+		[this](const auto &) { return alu; }
+	}, stmt);
+}
+
+int reg_key(const Reg &reg)
+{
+	if(std::holds_alternative<ZeroReg>(reg) && std::get<ZeroReg>(reg).id == 0)
+		return -1;
+	return static_cast<int>(reg.index()) * 16
+		+ std::visit([](const auto &r) { return r.id; }, reg);
+}
+
+void used_regs(const TiggerStatement &stmt, std::vector<Reg> &regs)
+{
+	regs.clear();
+	std::visit(utils::LambdaVisitor
+	{
+		[&](const UnaryOpStmt &s) { regs.push_back(s.opr1); },
+		[&](const BinaryOpStmt &s)
+		{
+			regs.push_back(s.opr1);
+			if(auto reg = std::get_if<Reg>(&s.opr2))
+				regs.push_back(*reg);
+		},
+		[&](const MoveStmt &s)
+		{
+			if(auto reg = std::get_if<Reg>(&s.opr1))
+				regs.push_back(*reg);
+		},
+		[&](const ReadArrStmt &s) { regs.push_back(s.opr1); },
+		[&](const WriteArrStmt &s) { regs.push_back(s.opr1); regs.push_back(s.opr); },
+		[&](const CondGotoStmt &s) { regs.push_back(s.opr1); regs.push_back(s.opr2); },
+		[&](const StoreStmt &s) { regs.push_back(s.opr); },
+		[](const auto &) {}
+	}, stmt);
+}
+
+void defined_regs(const TiggerStatement &stmt, std::vector<Reg> &regs)
+{
+	regs.clear();
+	std::visit(utils::LambdaVisitor
+	{
+		[&](const UnaryOpStmt &s) { regs.push_back(s.opr); },
+		[&](const BinaryOpStmt &s) { regs.push_back(s.opr); },
+		[&](const MoveStmt &s) { regs.push_back(s.opr); },
+		[&](const ReadArrStmt &s) { regs.push_back(s.opr); },
+		[&](const LoadStmt &s) { regs.push_back(s.opr); },
+		[&](const LoadAddrStmt &s) { regs.push_back(s.opr); },
+		[](const auto &) {}
+	}, stmt);
+}
+
+size_t schedule(TiggerStatement *begin, TiggerStatement *end, const LatencyModel &model)
+{
+	utils::ScopedTimer timer("schedule tigger");
+	RegionScheduler scheduler(model);
+	size_t changed = 0;
+	for(TiggerStatement *region = begin; region != end; )
+	{
+		if(ends_region(*region))
+		{
+			++region;
+			continue;
+		}
+		TiggerStatement *region_end = region;
+		while(region_end != end && !ends_region(*region_end)
+			&& region_end - region < MAX_REGION_SIZE)
+		{
+			++region_end;
+		}
+		if(region_end - region >= 2
+			&& scheduler.schedule(region, static_cast<int>(region_end - region)))
+		{
+			changed++;
+			++regions_scheduled;
+		}
+		region = region_end;
+	}
+	return changed;
+}
+
+int count_stalls(const TiggerStatement *begin, const TiggerStatement *end,
+	const LatencyModel &model)
+{
+	int ready[REG_KEY_CNT] = {};
+	int cycle = 0, stalls = 0;
+	std::vector<Reg> regs;
+	for(const TiggerStatement *stmt = begin; stmt != end; ++stmt)
+	{
+		// Whatever flows in from other blocks or from a callee is assumed
+		// to be ready.
+		if(std::holds_alternative<LabelStmt>(*stmt) || std::holds_alternative<FuncCallStmt>(*stmt)
+			|| std::holds_alternative<FuncHeaderStmt>(*stmt))
+		{
+			std::fill(std::begin(ready), std::end(ready), 0);
+			continue;
+		}
+		int issue = cycle;
+		used_regs(*stmt, regs);
+		for(const Reg &reg : regs)
+			if(int key = reg_key(reg); key >= 0)
+				issue = std::max(issue, ready[key]);
+		stalls += issue - cycle;
+		cycle = issue + 1;
+		defined_regs(*stmt, regs);
+		for(const Reg &reg : regs)
+			if(int key = reg_key(reg); key >= 0)
+				ready[key] = issue + model.latency(*stmt);
+	}
+	return stalls;
+}
+
+} // namespace compiler_skeleton::tigger
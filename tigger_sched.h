@@ -0,0 +1,83 @@
+#ifndef SKELETON_TIGGER_SCHED_H
+#define SKELETON_TIGGER_SCHED_H
+
+/*
+ * List scheduling of Tigger statements, to move loads (and other long
+ * latency operations) away from the statements using their results.
+ *
+ * Code is scheduled in regions: the straight-line runs of statements between
+ * labels, jumps, calls and returns, which all stay in place. In a region:
+ *  + A dependency DAG is built from the registers each statement defines and
+ *    uses (true, anti and output dependencies), and from memory ordering.
+ *    Stack slots and global variables are told apart by their offsets and
+ *    ids; array accesses may alias any memory. Reads are never ordered among
+ *    themselves.
+ *  + The statements are then issued cycle by cycle. Among those whose inputs
+ *    are ready, the one on the longest latency path to the end of the region
+ *    goes first, ties being broken by the original order.
+ *
+ * Latencies come from a LatencyModel, whose defaults describe a simple
+ * in-order RV32IM core; derive from it to model another one. `count_stalls'
+ * runs the same model as an in-order, single-issue pipeline and counts the
+ * cycles spent waiting for operands, to compare code before and after.
+ *
+ * Example:
+ *     using namespace compiler_skeleton::tigger;
+ *     LatencyModel model;
+ *     int before = count_stalls(stmts, model);
+ *     schedule(stmts, model);
+ *     int after = count_stalls(stmts, model); // after <= before, usually
+ */
+
+#include <cstddef>
+#include <vector>
+#include "tigger.h"
+
+namespace compiler_skeleton::tigger
+{
+
+class LatencyModel
+{
+  public:
+	int alu = 1;
+	int mul = 3;
+	int div = 20;
+	int load = 3; // loads from the stack, globals and arrays
+
+	virtual ~LatencyModel() = default;
+	// Cycles from issuing `stmt' until its result can be used.
+	virtual int latency(const TiggerStatement &stmt) const;
+};
+
+// Registers numbered by their kinds and ids, below REG_KEY_CNT; -1 for x0,
+// which is always zero and so carries no dependency.
+constexpr int REG_KEY_CNT = 4 * 16;
+int reg_key(const Reg &reg);
+
+// Registers read and written by a statement. Calls, jumps and other
+// statements that end a region are not described.
+void used_regs(const TiggerStatement &stmt, std::vector<Reg> &regs);
+void defined_regs(const TiggerStatement &stmt, std::vector<Reg> &regs);
+
+// Reorder the statements in [begin, end) in place. Returns the number of
+// regions whose order changed.
+size_t schedule(TiggerStatement *begin, TiggerStatement *end,
+	const LatencyModel &model=LatencyModel());
+int count_stalls(const TiggerStatement *begin, const TiggerStatement *end,
+	const LatencyModel &model=LatencyModel());
+
+// The same, for a container of TiggerStatements with contiguous storage.
+template<class Container>
+size_t schedule(Container &stmts, const LatencyModel &model=LatencyModel())
+{
+	return schedule(stmts.data(), stmts.data() + stmts.size(), model);
+}
+template<class Container>
+int count_stalls(const Container &stmts, const LatencyModel &model=LatencyModel())
+{
+	return count_stalls(stmts.data(), stmts.data() + stmts.size(), model);
+}
+
+} // namespace compiler_skeleton::tigger
+
+#endif